@@ -0,0 +1,1414 @@
+/**
+ * @brief     libdae benchmarks
+ * @details   Generates synthetic COLLADA 1.5 documents in memory and measures
+ *            loading, searching and destroying them, along with the daeu
+ *            matrix, skinning, morphing and triangulation kernels. Results
+ *            are written to stdout as one JSON object per line.
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2011
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#include <dae.h>
+#include <daeu.h>
+#include <expat.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <pthread.h>
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+#ifdef _WIN32
+typedef HANDLE bench_thread;
+#else
+typedef pthread_t bench_thread;
+#endif
+
+typedef struct bench_text_s bench_text;
+typedef struct bench_counter_s bench_counter;
+typedef struct bench_options_s bench_options;
+typedef struct bench_worker_s bench_worker;
+
+struct bench_text_s
+{
+    char* str;
+    size_t len;
+    size_t cap;
+};
+
+struct bench_counter_s
+{
+    size_t numallocs;
+    size_t bytes;
+    size_t peakbytes;
+};
+
+struct bench_options_s
+{
+    double scale;
+    int reps;
+    int numthreads;
+};
+
+struct bench_worker_s
+{
+    bench_thread thread;
+    const bench_text* text;
+    /// the shared document read by every worker, NULL while loading
+    dae_COLLADA* doc;
+    size_t numnodes;
+    size_t count;
+    size_t found;
+    unsigned seed;
+};
+
+//****************************************************************************
+static double bench_get_time()
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return ((double) now.QuadPart) / ((double) freq.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double) now.tv_sec) + ((double) now.tv_nsec)*1e-9;
+#endif
+}
+
+//****************************************************************************
+static size_t bench_get_peak_rss()
+{
+    // peak resident set size of the process in kilobytes
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    return pmc.PeakWorkingSetSize/1024;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (size_t) usage.ru_maxrss;
+#endif
+}
+
+//****************************************************************************
+static unsigned bench_rand(
+    unsigned* state)
+{
+    // xorshift, so runs are repeatable across platforms
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+//****************************************************************************
+static float bench_randf(
+    unsigned* state)
+{
+    return ((float) (bench_rand(state) & 0xffff)) / 65535.0f;
+}
+
+//****************************************************************************
+static void* bench_aligned_alloc(
+    size_t size)
+{
+    // the kernels expect the 64 byte alignment used by the daeu compilers
+    char* raw = (char*) malloc(size + 64 + sizeof(void*));
+    char* ptr = (char*) (((size_t) (raw + sizeof(void*) + 63)) & ~63);
+    ((void**) ptr)[-1] = raw;
+    return ptr;
+}
+
+//****************************************************************************
+static void bench_aligned_free(
+    void* ptr)
+{
+    if(ptr != NULL)
+    {
+        free(((void**) ptr)[-1]);
+    }
+}
+
+//****************************************************************************
+static void bench_printf(
+    bench_text* text,
+    const char* fmt,
+    ...)
+{
+    va_list args;
+    size_t need = 256;
+    int n;
+    for(;;)
+    {
+        if(text->cap - text->len < need)
+        {
+            text->cap = (text->len + need)*2;
+            text->str = (char*) realloc(text->str, text->cap);
+        }
+        va_start(args, fmt);
+        n = vsnprintf(
+            text->str + text->len,
+            text->cap - text->len,
+            fmt,
+            args);
+        va_end(args);
+        if(n >= 0 && (size_t) n < text->cap - text->len)
+        {
+            break;
+        }
+        // retry with the length the result needs, or with twice the room
+        // when the runtime only reports that it did not fit
+        need = (n >= 0) ? (size_t) n + 1 : (text->cap - text->len)*2;
+    }
+    text->len += n;
+}
+
+//****************************************************************************
+static void bench_gen_begin(
+    bench_text* text)
+{
+    bench_printf(text,
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        "<COLLADA xmlns=\"http://www.collada.org/2008/03/COLLADASchema\""
+        " version=\"1.5.0\">\n"
+        "<asset><created>2011-01-01T00:00:00</created>"
+        "<modified>2011-01-01T00:00:00</modified>"
+        "<unit meter=\"1\" name=\"meter\"/><up_axis>Y_UP</up_axis>"
+        "</asset>\n");
+}
+
+//****************************************************************************
+static void bench_gen_end(
+    bench_text* text)
+{
+    bench_printf(text,
+        "<scene><instance_visual_scene url=\"#scene\"/></scene>\n"
+        "</COLLADA>\n");
+}
+
+//****************************************************************************
+static void bench_gen_floats(
+    bench_text* text,
+    const char* id,
+    size_t count,
+    unsigned* seed)
+{
+    size_t i;
+    bench_printf(text, "<float_array id=\"%s\" count=\"%lu\">",
+        id, (unsigned long) count);
+    for(i = 0; i < count; ++i)
+    {
+        bench_printf(text, (i & 7) ? " %.4f" : "\n%.4f",
+            bench_randf(seed)*100.0f - 50.0f);
+    }
+    bench_printf(text, "</float_array>\n");
+}
+
+//****************************************************************************
+static void bench_gen_node_open(
+    bench_text* text,
+    size_t index,
+    unsigned* seed)
+{
+    bench_printf(text,
+        "<node id=\"n%lu\" sid=\"n%lu\" name=\"node%lu\">"
+        "<translate sid=\"t\">%.3f %.3f %.3f</translate>"
+        "<rotate sid=\"r\">0 1 0 %.2f</rotate>"
+        "<scale sid=\"s\">1 1 1</scale>",
+        (unsigned long) index, (unsigned long) index, (unsigned long) index,
+        bench_randf(seed), bench_randf(seed), bench_randf(seed),
+        bench_randf(seed)*360.0f);
+}
+
+//****************************************************************************
+static size_t bench_gen_arrays(
+    bench_text* text,
+    double scale)
+{
+    // a few geometries with very large float and index arrays
+    size_t numgeoms = 4;
+    size_t numverts = (size_t) (32768*scale);
+    size_t g;
+    unsigned seed = 1;
+    bench_gen_begin(text);
+    bench_printf(text, "<library_geometries>\n");
+    for(g = 0; g < numgeoms; ++g)
+    {
+        char id[32];
+        size_t i;
+        bench_printf(text,
+            "<geometry id=\"g%lu\"><mesh>"
+            "<source id=\"g%lu-pos\">", (unsigned long) g, (unsigned long) g);
+        sprintf(id, "g%lu-pos-array", (unsigned long) g);
+        bench_gen_floats(text, id, numverts*3, &seed);
+        bench_printf(text,
+            "<technique_common><accessor source=\"#%s\" count=\"%lu\""
+            " stride=\"3\"><param name=\"X\" type=\"float\"/>"
+            "<param name=\"Y\" type=\"float\"/>"
+            "<param name=\"Z\" type=\"float\"/></accessor>"
+            "</technique_common></source>\n"
+            "<vertices id=\"g%lu-vtx\"><input semantic=\"POSITION\""
+            " source=\"#g%lu-pos\"/></vertices>\n"
+            "<triangles count=\"%lu\"><input semantic=\"VERTEX\""
+            " source=\"#g%lu-vtx\" offset=\"0\"/><p>",
+            id, (unsigned long) numverts, (unsigned long) g,
+            (unsigned long) g, (unsigned long) numverts,
+            (unsigned long) g);
+        for(i = 0; i < numverts*3; ++i)
+        {
+            bench_printf(text, (i & 15) ? " %lu" : "\n%lu",
+                (unsigned long) (bench_rand(&seed) % numverts));
+        }
+        bench_printf(text, "</p></triangles></mesh></geometry>\n");
+    }
+    bench_printf(text,
+        "</library_geometries>\n"
+        "<library_visual_scenes><visual_scene id=\"scene\">");
+    for(g = 0; g < numgeoms; ++g)
+    {
+        bench_gen_node_open(text, g, &seed);
+        bench_printf(text, "<instance_geometry url=\"#g%lu\"/></node>\n",
+            (unsigned long) g);
+    }
+    bench_printf(text, "</visual_scene></library_visual_scenes>\n");
+    bench_gen_end(text);
+    return numgeoms;
+}
+
+//****************************************************************************
+static size_t bench_gen_deep(
+    bench_text* text,
+    double scale)
+{
+    // several long chains of nested nodes
+    size_t numchains = 8;
+    size_t depth = (size_t) (512*scale);
+    size_t c;
+    size_t n = 0;
+    unsigned seed = 2;
+    bench_gen_begin(text);
+    bench_printf(text,
+        "<library_visual_scenes><visual_scene id=\"scene\">\n");
+    for(c = 0; c < numchains; ++c)
+    {
+        size_t d;
+        for(d = 0; d < depth; ++d)
+        {
+            bench_gen_node_open(text, n, &seed);
+            bench_printf(text, "\n");
+            ++n;
+        }
+        for(d = 0; d < depth; ++d)
+        {
+            bench_printf(text, "</node>");
+        }
+        bench_printf(text, "\n");
+    }
+    bench_printf(text, "</visual_scene></library_visual_scenes>\n");
+    bench_gen_end(text);
+    return n;
+}
+
+//****************************************************************************
+static size_t bench_gen_small(
+    bench_text* text,
+    double scale)
+{
+    // a flat scene of many small nodes, each with a handful of children
+    size_t numnodes = (size_t) (65536*scale);
+    size_t i;
+    unsigned seed = 3;
+    bench_gen_begin(text);
+    bench_printf(text,
+        "<library_visual_scenes><visual_scene id=\"scene\">\n");
+    for(i = 0; i < numnodes; ++i)
+    {
+        bench_gen_node_open(text, i, &seed);
+        bench_printf(text,
+            "<instance_node url=\"#n%lu\"/>"
+            "<extra><technique profile=\"bench\">"
+            "<param name=\"p\" type=\"float\">1</param>"
+            "</technique></extra></node>\n",
+            (unsigned long) (bench_rand(&seed) % numnodes));
+    }
+    bench_printf(text, "</visual_scene></library_visual_scenes>\n");
+    bench_gen_end(text);
+    return numnodes;
+}
+
+//****************************************************************************
+static size_t bench_gen_anim(
+    bench_text* text,
+    double scale)
+{
+    // one animation per node transform, with long key lists
+    size_t numnodes = (size_t) (1024*scale);
+    size_t numkeys = 120;
+    size_t i;
+    unsigned seed = 4;
+    bench_gen_begin(text);
+    bench_printf(text, "<library_animations>\n");
+    for(i = 0; i < numnodes; ++i)
+    {
+        unsigned long n = (unsigned long) i;
+        char id[32];
+        size_t k;
+        bench_printf(text, "<animation id=\"a%lu\"><source id=\"a%lu-in\">",
+            n, n);
+        bench_printf(text, "<float_array id=\"a%lu-in-array\" count=\"%lu\">",
+            n, (unsigned long) numkeys);
+        for(k = 0; k < numkeys; ++k)
+        {
+            bench_printf(text, " %.4f", k/30.0f);
+        }
+        bench_printf(text,
+            "</float_array><technique_common>"
+            "<accessor source=\"#a%lu-in-array\" count=\"%lu\">"
+            "<param name=\"TIME\" type=\"float\"/></accessor>"
+            "</technique_common></source>\n"
+            "<source id=\"a%lu-out\">",
+            n, (unsigned long) numkeys, n);
+        sprintf(id, "a%lu-out-array", n);
+        bench_gen_floats(text, id, numkeys*3, &seed);
+        bench_printf(text,
+            "<technique_common><accessor source=\"#%s\" count=\"%lu\""
+            " stride=\"3\"><param name=\"X\" type=\"float\"/>"
+            "<param name=\"Y\" type=\"float\"/>"
+            "<param name=\"Z\" type=\"float\"/></accessor>"
+            "</technique_common></source>\n"
+            "<source id=\"a%lu-interp\">"
+            "<Name_array id=\"a%lu-interp-array\" count=\"%lu\">",
+            id, (unsigned long) numkeys, n, n, (unsigned long) numkeys);
+        for(k = 0; k < numkeys; ++k)
+        {
+            bench_printf(text, " LINEAR");
+        }
+        bench_printf(text,
+            "</Name_array><technique_common>"
+            "<accessor source=\"#a%lu-interp-array\" count=\"%lu\">"
+            "<param name=\"INTERPOLATION\" type=\"name\"/></accessor>"
+            "</technique_common></source>\n"
+            "<sampler id=\"a%lu-sampler\">"
+            "<input semantic=\"INPUT\" source=\"#a%lu-in\"/>"
+            "<input semantic=\"OUTPUT\" source=\"#a%lu-out\"/>"
+            "<input semantic=\"INTERPOLATION\" source=\"#a%lu-interp\"/>"
+            "</sampler><channel source=\"#a%lu-sampler\" target=\"n%lu/t\"/>"
+            "</animation>\n",
+            n, (unsigned long) numkeys, n, n, n, n, n, n);
+    }
+    bench_printf(text,
+        "</library_animations>\n"
+        "<library_visual_scenes><visual_scene id=\"scene\">\n");
+    for(i = 0; i < numnodes; ++i)
+    {
+        bench_gen_node_open(text, i, &seed);
+        bench_printf(text, "</node>\n");
+    }
+    bench_printf(text, "</visual_scene></library_visual_scenes>\n");
+    bench_gen_end(text);
+    return numnodes;
+}
+
+//****************************************************************************
+static size_t bench_gen_tris(
+    bench_text* text,
+    double scale)
+{
+    // a planar grid of positions shared by polylists of polygons with three
+    // to eight corners and a polygons element of squares with holes. The
+    // polygons are split across polylists the way material groups split
+    // them, which also keeps each text list short
+    size_t numpolys = (size_t) (262144*scale);
+    size_t numholes = numpolys/64 + 1;
+    size_t grid = 128;
+    size_t numverts = grid*grid;
+    size_t i;
+    size_t j;
+    unsigned seed = 9;
+    unsigned pcountseed = 10;
+    unsigned vcountseed = 10;
+    bench_gen_begin(text);
+    bench_printf(text,
+        "<library_geometries>\n"
+        "<geometry id=\"g0\"><mesh><source id=\"g0-pos\">"
+        "<float_array id=\"g0-pos-array\" count=\"%lu\">",
+        (unsigned long) numverts*3);
+    for(i = 0; i < numverts; ++i)
+    {
+        bench_printf(text, "\n%lu 0 %lu",
+            (unsigned long) (i % grid), (unsigned long) (i/grid));
+    }
+    bench_printf(text,
+        "</float_array><technique_common>"
+        "<accessor source=\"#g0-pos-array\" count=\"%lu\" stride=\"3\">"
+        "<param name=\"X\" type=\"float\"/>"
+        "<param name=\"Y\" type=\"float\"/>"
+        "<param name=\"Z\" type=\"float\"/></accessor>"
+        "</technique_common></source>\n"
+        "<source id=\"g0-nrm\">",
+        (unsigned long) numverts);
+    bench_gen_floats(text, "g0-nrm-array", 1024*3, &seed);
+    bench_printf(text,
+        "<technique_common><accessor source=\"#g0-nrm-array\""
+        " count=\"1024\" stride=\"3\"><param name=\"X\" type=\"float\"/>"
+        "<param name=\"Y\" type=\"float\"/>"
+        "<param name=\"Z\" type=\"float\"/></accessor>"
+        "</technique_common></source>\n"
+        "<vertices id=\"g0-vtx\"><input semantic=\"POSITION\""
+        " source=\"#g0-pos\"/></vertices>\n");
+    for(i = 0; i < numpolys; i += 4096)
+    {
+        size_t count = (numpolys - i < 4096) ? numpolys - i : 4096;
+        bench_printf(text,
+            "<polylist count=\"%lu\">"
+            "<input semantic=\"VERTEX\" source=\"#g0-vtx\" offset=\"0\"/>"
+            "<input semantic=\"NORMAL\" source=\"#g0-nrm\" offset=\"1\"/>"
+            "<vcount>",
+            (unsigned long) count);
+        for(j = 0; j < count; ++j)
+        {
+            bench_printf(text, (j & 31) ? " %u" : "\n%u",
+                3 + bench_rand(&vcountseed) % 6);
+        }
+        bench_printf(text, "</vcount><p>");
+        for(j = 0; j < count; ++j)
+        {
+            // the counts are replayed so the corners match the vcount
+            unsigned numcorners = 3 + bench_rand(&pcountseed) % 6;
+            unsigned c;
+            bench_printf(text, "\n");
+            for(c = 0; c < numcorners; ++c)
+            {
+                bench_printf(text, " %lu %lu",
+                    (unsigned long) (bench_rand(&seed) % numverts),
+                    (unsigned long) (bench_rand(&seed) % 1024));
+            }
+        }
+        bench_printf(text, "</p></polylist>\n");
+    }
+    bench_printf(text,
+        "<polygons count=\"%lu\">"
+        "<input semantic=\"VERTEX\" source=\"#g0-vtx\" offset=\"0\"/>"
+        "<input semantic=\"NORMAL\" source=\"#g0-nrm\" offset=\"1\"/>",
+        (unsigned long) numholes);
+    for(i = 0; i < numholes; ++i)
+    {
+        // a 3x3 square with the 1x1 square in its middle cut out
+        unsigned long x = bench_rand(&seed) % (grid - 3);
+        unsigned long z = bench_rand(&seed) % (grid - 3);
+        unsigned long v = z*grid + x;
+        unsigned long n = bench_rand(&seed) % 1024;
+        unsigned long g = (unsigned long) grid;
+        bench_printf(text,
+            "\n<ph><p>%lu %lu %lu %lu %lu %lu %lu %lu</p>"
+            "<h>%lu %lu %lu %lu %lu %lu %lu %lu</h></ph>",
+            v, n, v + 3, n, v + 3*g + 3, n, v + 3*g, n,
+            v + g + 1, n, v + 2*g + 1, n, v + 2*g + 2, n, v + g + 2, n);
+    }
+    bench_printf(text,
+        "</polygons></mesh></geometry>\n</library_geometries>\n"
+        "<library_visual_scenes><visual_scene id=\"scene\">");
+    bench_gen_node_open(text, 0, &seed);
+    bench_printf(text,
+        "<instance_geometry url=\"#g0\"/></node>\n"
+        "</visual_scene></library_visual_scenes>\n");
+    bench_gen_end(text);
+    return numpolys + numholes;
+}
+
+//****************************************************************************
+static void* bench_counter_alloc(
+    void* user,
+    size_t size)
+{
+    // each block is prefixed with its size so frees can be accounted
+    bench_counter* counter = (bench_counter*) user;
+    size_t* block = (size_t*) malloc(size + 2*sizeof(size_t));
+    ++counter->numallocs;
+    counter->bytes += size;
+    if(counter->bytes > counter->peakbytes)
+    {
+        counter->peakbytes = counter->bytes;
+    }
+    block[0] = size;
+    return block + 2;
+}
+
+//****************************************************************************
+static void* bench_counter_realloc(
+    void* user,
+    void* ptr,
+    size_t size)
+{
+    bench_counter* counter = (bench_counter*) user;
+    size_t* block = ((size_t*) ptr) - 2;
+    counter->bytes -= block[0];
+    block = (size_t*) realloc(block, size + 2*sizeof(size_t));
+    ++counter->numallocs;
+    counter->bytes += size;
+    if(counter->bytes > counter->peakbytes)
+    {
+        counter->peakbytes = counter->bytes;
+    }
+    block[0] = size;
+    return block + 2;
+}
+
+//****************************************************************************
+static void bench_counter_free(
+    void* user,
+    void* ptr)
+{
+    bench_counter* counter = (bench_counter*) user;
+    size_t* block = ((size_t*) ptr) - 2;
+    counter->bytes -= block[0];
+    free(block);
+}
+
+//****************************************************************************
+static dae_COLLADA* bench_parse(
+    const bench_text* text,
+    const dae_allocator* allocator)
+{
+    dae_COLLADA* doc = (allocator != NULL) ?
+        dae_create_ex(allocator) :
+        dae_create();
+    daeu_xml_parser parser;
+    XML_Parser expat = XML_ParserCreate(NULL);
+    daeu_xml_create(doc, &parser);
+    XML_SetElementHandler(
+        expat,
+        daeu_xml_startelement,
+        daeu_xml_endelement);
+    XML_SetCharacterDataHandler(expat, daeu_xml_chardata);
+    XML_SetUserData(expat, parser);
+    if(XML_Parse(expat, text->str, (int) text->len, 1) != XML_STATUS_OK)
+    {
+        fprintf(stderr, "bench: %s at line %lu\n",
+            XML_ErrorString(XML_GetErrorCode(expat)),
+            (unsigned long) XML_GetCurrentLineNumber(expat));
+    }
+    XML_ParserFree(expat);
+    daeu_xml_destroy(parser);
+    return doc;
+}
+
+//****************************************************************************
+static void* bench_expat_create(
+    void* user)
+{
+    return XML_ParserCreate(NULL);
+}
+
+//****************************************************************************
+static int bench_expat_parse(
+    void* user,
+    void* tokenizer,
+    daeu_xml_parser parser,
+    const char* data,
+    size_t size)
+{
+    XML_Parser expat = (XML_Parser) tokenizer;
+    XML_ParserReset(expat, NULL);
+    XML_SetElementHandler(
+        expat,
+        daeu_xml_startelement,
+        daeu_xml_endelement);
+    XML_SetCharacterDataHandler(expat, daeu_xml_chardata);
+    XML_SetUserData(expat, parser);
+    return (XML_Parse(expat, data, (int) size, 1) == XML_STATUS_OK) ? 0 : -1;
+}
+
+//****************************************************************************
+static void bench_expat_destroy(
+    void* user,
+    void* tokenizer)
+{
+    XML_ParserFree((XML_Parser) tokenizer);
+}
+
+//****************************************************************************
+static size_t bench_get_doc_bytes(
+    dae_COLLADA* doc)
+{
+    size_t numstats = dae_get_memory_stats(doc, NULL, 0);
+    dae_memory_stats* stats;
+    size_t bytes = 0;
+    size_t i;
+    stats = (dae_memory_stats*) malloc(numstats*sizeof(*stats));
+    dae_get_memory_stats(doc, stats, numstats);
+    for(i = 0; i < numstats; ++i)
+    {
+        bytes += stats[i].headerbytes + stats[i].structbytes;
+        bytes += stats[i].vectorbytes + stats[i].stringbytes;
+    }
+    free(stats);
+    return bytes;
+}
+
+//****************************************************************************
+static void bench_search(
+    const char* shape,
+    dae_COLLADA* doc,
+    size_t numnodes)
+{
+    // looks up random nodes by uri and random transforms by sid path
+    size_t numqueries = 100;
+    unsigned seed = 5;
+    size_t found = 0;
+    double t;
+    size_t i;
+    t = bench_get_time();
+    for(i = 0; i < numqueries; ++i)
+    {
+        char uri[32];
+        sprintf(uri, "#n%lu", (unsigned long) (bench_rand(&seed) % numnodes));
+        found += daeu_search_uri(doc, uri) != NULL;
+    }
+    t = bench_get_time() - t;
+    printf("{\"bench\":\"search_uri\",\"shape\":\"%s\",\"queries\":%lu,"
+        "\"found\":%lu,\"ns_per_query\":%.1f}\n",
+        shape, (unsigned long) numqueries, (unsigned long) found,
+        t*1e9/numqueries);
+    found = 0;
+    t = bench_get_time();
+    for(i = 0; i < numqueries; ++i)
+    {
+        char ref[32];
+        dae_obj_ptr obj;
+        int index;
+        unsigned long n = (unsigned long) (bench_rand(&seed) % numnodes);
+        sprintf(ref, "n%lu/t.X", n);
+        found += daeu_search_sid(doc, ref, &obj, &index) == 2;
+    }
+    t = bench_get_time() - t;
+    printf("{\"bench\":\"search_sid\",\"shape\":\"%s\",\"queries\":%lu,"
+        "\"found\":%lu,\"ns_per_query\":%.1f}\n",
+        shape, (unsigned long) numqueries, (unsigned long) found,
+        t*1e9/numqueries);
+}
+
+//****************************************************************************
+static void bench_load(
+    const char* shape,
+    const bench_options* opts)
+{
+    bench_text text;
+    bench_counter counter;
+    dae_allocator allocator;
+    double parsetime = 1e30;
+    double destroytime = 1e30;
+    double clonetime;
+    double deduptime;
+    double pdestroytime;
+    double asynctime;
+    daeu_destroy_job job;
+    dae_COLLADA* doc;
+    double t;
+    size_t docbytes = 0;
+    size_t numnodes;
+    size_t numdups;
+    int rep;
+    memset(&text, 0, sizeof(text));
+    if(!strcmp(shape, "arrays"))
+    {
+        numnodes = bench_gen_arrays(&text, opts->scale);
+    }
+    else if(!strcmp(shape, "deep"))
+    {
+        numnodes = bench_gen_deep(&text, opts->scale);
+    }
+    else if(!strcmp(shape, "small"))
+    {
+        numnodes = bench_gen_small(&text, opts->scale);
+    }
+    else
+    {
+        numnodes = bench_gen_anim(&text, opts->scale);
+    }
+    allocator.alloc = bench_counter_alloc;
+    allocator.realloc = bench_counter_realloc;
+    allocator.free = bench_counter_free;
+    allocator.user = &counter;
+    for(rep = 0; rep < opts->reps; ++rep)
+    {
+        memset(&counter, 0, sizeof(counter));
+        t = bench_get_time();
+        doc = bench_parse(&text, &allocator);
+        t = bench_get_time() - t;
+        parsetime = (t < parsetime) ? t : parsetime;
+        if(rep == 0)
+        {
+            docbytes = bench_get_doc_bytes(doc);
+            bench_search(shape, doc, numnodes);
+        }
+        t = bench_get_time();
+        dae_destroy(doc);
+        t = bench_get_time() - t;
+        destroytime = (t < destroytime) ? t : destroytime;
+    }
+    // the counting allocator is not thread safe, so the clone, the dedup
+    // and the parallel and background teardowns use the default hooks
+    doc = bench_parse(&text, NULL);
+    t = bench_get_time();
+    dae_destroy((dae_COLLADA*) dae_clone(doc, NULL));
+    clonetime = bench_get_time() - t;
+    t = bench_get_time();
+    numdups = daeu_dedup(doc, opts->numthreads);
+    deduptime = bench_get_time() - t;
+    t = bench_get_time();
+    daeu_destroy(doc, opts->numthreads);
+    pdestroytime = bench_get_time() - t;
+    doc = bench_parse(&text, NULL);
+    t = bench_get_time();
+    daeu_destroy_async(doc, opts->numthreads, &job);
+    asynctime = bench_get_time() - t;
+    daeu_destroy_wait(job);
+    printf("{\"bench\":\"load\",\"shape\":\"%s\",\"bytes\":%lu,"
+        "\"parse_s\":%.6f,\"mb_per_s\":%.2f,\"allocs\":%lu,"
+        "\"alloc_peak_bytes\":%lu,\"doc_bytes\":%lu,\"clone_s\":%.6f,"
+        "\"dedup_s\":%.6f,\"dedup_removed\":%lu,\"destroy_s\":%.6f,"
+        "\"parallel_destroy_s\":%.6f,\"async_destroy_return_s\":%.6f,"
+        "\"peak_rss_kb\":%lu}\n",
+        shape, (unsigned long) text.len, parsetime,
+        text.len/parsetime/1e6, (unsigned long) counter.numallocs,
+        (unsigned long) counter.peakbytes, (unsigned long) docbytes,
+        clonetime, deduptime, (unsigned long) numdups, destroytime,
+        pdestroytime, asynctime,
+        (unsigned long) bench_get_peak_rss());
+    free(text.str);
+}
+
+//****************************************************************************
+#ifdef _WIN32
+static DWORD WINAPI bench_worker_main(
+#else
+static void* bench_worker_main(
+#endif
+    void* arg)
+{
+    // loads private documents, or reads the shared one, count times
+    bench_worker* worker = (bench_worker*) arg;
+    size_t i;
+    for(i = 0; i < worker->count; ++i)
+    {
+        if(worker->doc == NULL)
+        {
+            dae_COLLADA* doc = bench_parse(worker->text, NULL);
+            worker->found += dae_get_memory_stats(doc, NULL, 0) > 0;
+            dae_destroy(doc);
+        }
+        else
+        {
+            unsigned long n;
+            char ref[32];
+            dae_obj_ptr obj;
+            int index;
+            n = (unsigned long) (bench_rand(&worker->seed) % worker->numnodes);
+            sprintf(ref, "#n%lu", n);
+            worker->found += daeu_search_uri(worker->doc, ref) != NULL;
+            sprintf(ref, "n%lu/t.X", n);
+            worker->found +=
+                daeu_search_sid(worker->doc, ref, &obj, &index) == 2;
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+static double bench_run_workers(
+    bench_worker* workers,
+    int numworkers)
+{
+    double t = bench_get_time();
+    int i;
+    for(i = 0; i < numworkers; ++i)
+    {
+#ifdef _WIN32
+        workers[i].thread = CreateThread(
+            NULL, 0, bench_worker_main, workers + i, 0, NULL);
+#else
+        pthread_create(&workers[i].thread, NULL, bench_worker_main,
+            workers + i);
+#endif
+    }
+    for(i = 0; i < numworkers; ++i)
+    {
+#ifdef _WIN32
+        WaitForSingleObject(workers[i].thread, INFINITE);
+        CloseHandle(workers[i].thread);
+#else
+        pthread_join(workers[i].thread, NULL);
+#endif
+    }
+    return bench_get_time() - t;
+}
+
+//****************************************************************************
+static void bench_threads(
+    const bench_options* opts)
+{
+    // builds separate documents on every thread, starting before the schema
+    // has been used when run first, then reads one document from all of them.
+    // running this under a thread sanitizer checks the concurrency guarantees
+    int numworkers = (opts->numthreads > 0) ? opts->numthreads : 4;
+    size_t numloads = (size_t) (64*opts->scale) + 1;
+    size_t numsearches = (size_t) (256*opts->scale) + 1;
+    bench_worker* workers;
+    bench_text text;
+    dae_COLLADA* doc;
+    size_t numnodes;
+    size_t found = 0;
+    double t;
+    int i;
+    memset(&text, 0, sizeof(text));
+    numnodes = bench_gen_anim(&text, 0.05);
+    workers = (bench_worker*) calloc(numworkers, sizeof(*workers));
+    for(i = 0; i < numworkers; ++i)
+    {
+        workers[i].text = &text;
+        workers[i].count = numloads;
+    }
+    t = bench_run_workers(workers, numworkers);
+    printf("{\"bench\":\"threads_load\",\"threads\":%d,\"docs\":%lu,"
+        "\"s\":%.6f,\"docs_per_s\":%.1f}\n",
+        numworkers, (unsigned long) (numloads*numworkers), t,
+        numloads*numworkers/t);
+    doc = bench_parse(&text, NULL);
+    for(i = 0; i < numworkers; ++i)
+    {
+        workers[i].doc = doc;
+        workers[i].numnodes = numnodes;
+        workers[i].count = numsearches;
+        workers[i].found = 0;
+        workers[i].seed = i + 1;
+    }
+    t = bench_run_workers(workers, numworkers);
+    for(i = 0; i < numworkers; ++i)
+    {
+        found += workers[i].found;
+    }
+    printf("{\"bench\":\"threads_search\",\"threads\":%d,"
+        "\"queries\":%lu,\"found\":%lu,\"s\":%.6f}\n",
+        numworkers, (unsigned long) (numsearches*numworkers*2),
+        (unsigned long) found, t);
+    dae_destroy(doc);
+    free(workers);
+    free(text.str);
+}
+
+//****************************************************************************
+static void bench_batch(
+    const bench_options* opts)
+{
+    // writes a set of files of mixed sizes and loads them with
+    // daeu_xml_load_batch, on one thread and then on the pool
+    int numfiles = (int) (32*opts->scale) + 1;
+    const char* dir = getenv("TMPDIR");
+    daeu_xml_driver driver;
+    daeu_xml_load_result* results;
+    char** paths;
+    size_t bytes = 0;
+    int pass;
+    int i;
+    if(dir == NULL)
+    {
+        dir = getenv("TEMP");
+    }
+    if(dir == NULL)
+    {
+        dir = "/tmp";
+    }
+    paths = (char**) malloc(numfiles*sizeof(*paths));
+    results = (daeu_xml_load_result*) malloc(numfiles*sizeof(*results));
+    for(i = 0; i < numfiles; ++i)
+    {
+        bench_text text;
+        FILE* fp;
+        paths[i] = (char*) malloc(strlen(dir) + 32);
+        sprintf(paths[i], "%s/bench_batch_%d.dae", dir, i);
+        memset(&text, 0, sizeof(text));
+        if((i & 1) != 0)
+        {
+            bench_gen_small(&text, 0.01*(1 + (i & 7)));
+        }
+        else
+        {
+            bench_gen_anim(&text, 0.02*(1 + (i & 7)));
+        }
+        fp = fopen(paths[i], "wb");
+        if(fp != NULL)
+        {
+            fwrite(text.str, 1, text.len, fp);
+            fclose(fp);
+        }
+        bytes += text.len;
+        free(text.str);
+    }
+    driver.create = bench_expat_create;
+    driver.parse = bench_expat_parse;
+    driver.destroy = bench_expat_destroy;
+    driver.user = NULL;
+    for(pass = 0; pass < 2; ++pass)
+    {
+        int numthreads = (pass == 0) ? 1 : opts->numthreads;
+        double readtime = 0.0;
+        double parsetime = 0.0;
+        double best = 1e30;
+        int failed = 0;
+        int rep;
+        for(rep = 0; rep < opts->reps; ++rep)
+        {
+            double t = bench_get_time();
+            failed = daeu_xml_load_batch(
+                (const char* const*) paths,
+                numfiles,
+                &driver,
+                NULL,
+                numthreads,
+                results) != 0;
+            t = bench_get_time() - t;
+            if(t < best)
+            {
+                best = t;
+                readtime = 0.0;
+                parsetime = 0.0;
+                for(i = 0; i < numfiles; ++i)
+                {
+                    readtime += results[i].readtime;
+                    parsetime += results[i].parsetime;
+                }
+            }
+            for(i = 0; i < numfiles; ++i)
+            {
+                if(results[i].doc != NULL)
+                {
+                    dae_destroy(results[i].doc);
+                }
+            }
+        }
+        printf("{\"bench\":\"batch\",\"threads\":%d,\"files\":%d,"
+            "\"bytes\":%lu,\"failed\":%d,\"s\":%.6f,\"mb_per_s\":%.2f,"
+            "\"read_s\":%.6f,\"parse_s\":%.6f}\n",
+            numthreads, numfiles, (unsigned long) bytes, failed, best,
+            bytes/best/1e6, readtime, parsetime);
+    }
+    for(i = 0; i < numfiles; ++i)
+    {
+        remove(paths[i]);
+        free(paths[i]);
+    }
+    free(results);
+    free(paths);
+}
+
+//****************************************************************************
+static void bench_matrix_multiply_scalar(
+    const float* a,
+    const float* b,
+    float* out,
+    size_t count)
+{
+    // the scalar row by column product the kernels replaced
+    size_t i;
+    for(i = 0; i < count; ++i)
+    {
+        const float* ma = a + i*16;
+        const float* mb = b + i*16;
+        float* mo = out + i*16;
+        int r;
+        for(r = 0; r < 4; ++r)
+        {
+            int c;
+            for(c = 0; c < 4; ++c)
+            {
+                mo[r*4 + c] =
+                    ma[r*4 + 0]*mb[0*4 + c] +
+                    ma[r*4 + 1]*mb[1*4 + c] +
+                    ma[r*4 + 2]*mb[2*4 + c] +
+                    ma[r*4 + 3]*mb[3*4 + c];
+            }
+        }
+    }
+}
+
+//****************************************************************************
+static void bench_report_kernel(
+    const char* name,
+    size_t count,
+    double t)
+{
+    printf("{\"bench\":\"%s\",\"count\":%lu,\"s\":%.6f,"
+        "\"ns_per_item\":%.3f}\n",
+        name, (unsigned long) count, t, t*1e9/count);
+}
+
+//****************************************************************************
+static void bench_matrix(
+    const bench_options* opts)
+{
+    size_t count = (size_t) (262144*opts->scale);
+    float* a = (float*) bench_aligned_alloc(count*16*sizeof(float));
+    float* b = (float*) bench_aligned_alloc(count*16*sizeof(float));
+    float* out = (float*) bench_aligned_alloc(count*16*sizeof(float));
+    int* parents = (int*) malloc(count*sizeof(int));
+    double best[4] = { 1e30, 1e30, 1e30, 1e30 };
+    unsigned seed = 6;
+    size_t i;
+    int rep;
+    for(i = 0; i < count*16; ++i)
+    {
+        a[i] = bench_randf(&seed);
+        b[i] = bench_randf(&seed);
+    }
+    for(i = 0; i < count; ++i)
+    {
+        // a forest of shallow hierarchies
+        size_t k = i % 64;
+        parents[i] = (k > 0) ? (int) (i - 1 - bench_rand(&seed) % k) : -1;
+        a[i*16 + 0] += 4.0f;
+        a[i*16 + 5] += 4.0f;
+        a[i*16 + 10] += 4.0f;
+        a[i*16 + 15] += 4.0f;
+    }
+    for(rep = 0; rep < opts->reps; ++rep)
+    {
+        double t = bench_get_time();
+        bench_matrix_multiply_scalar(a, b, out, count);
+        t = bench_get_time() - t;
+        best[0] = (t < best[0]) ? t : best[0];
+        t = bench_get_time();
+        daeu_matrix_multiply_batch(a, b, out, count);
+        t = bench_get_time() - t;
+        best[1] = (t < best[1]) ? t : best[1];
+        t = bench_get_time();
+        daeu_matrix_compose_batch(parents, a, out, count);
+        t = bench_get_time() - t;
+        best[2] = (t < best[2]) ? t : best[2];
+        t = bench_get_time();
+        daeu_matrix_invert_batch(a, out, count);
+        t = bench_get_time() - t;
+        best[3] = (t < best[3]) ? t : best[3];
+    }
+    bench_report_kernel("matrix_multiply_scalar", count, best[0]);
+    bench_report_kernel("matrix_multiply_batch", count, best[1]);
+    bench_report_kernel("matrix_compose_batch", count, best[2]);
+    bench_report_kernel("matrix_invert_batch", count, best[3]);
+    free(parents);
+    bench_aligned_free(out);
+    bench_aligned_free(b);
+    bench_aligned_free(a);
+}
+
+//****************************************************************************
+static void bench_init_mesh(
+    daeu_mesh* mesh,
+    daeu_mesh_attrib* attribs,
+    size_t numvertices,
+    unsigned* seed)
+{
+    // position, normal and texcoord, with the position source of each
+    // vertex being the vertex itself
+    size_t i;
+    memset(mesh, 0, sizeof(*mesh));
+    attribs[0].semantic = "POSITION";
+    attribs[0].set = -1;
+    attribs[0].offset = 0;
+    attribs[0].size = 3;
+    attribs[1].semantic = "NORMAL";
+    attribs[1].set = -1;
+    attribs[1].offset = 3;
+    attribs[1].size = 3;
+    attribs[2].semantic = "TEXCOORD";
+    attribs[2].set = -1;
+    attribs[2].offset = 6;
+    attribs[2].size = 2;
+    mesh->attribs = attribs;
+    mesh->numattribs = 3;
+    mesh->vertexsize = 8;
+    mesh->numvertices = numvertices;
+    mesh->vertices = (float*) bench_aligned_alloc(
+        numvertices*mesh->vertexsize*sizeof(float));
+    mesh->sources = (unsigned*) malloc(numvertices*3*sizeof(unsigned));
+    for(i = 0; i < numvertices*mesh->vertexsize; ++i)
+    {
+        mesh->vertices[i] = bench_randf(seed);
+    }
+    for(i = 0; i < numvertices; ++i)
+    {
+        mesh->sources[i*3 + 0] = (unsigned) i;
+        mesh->sources[i*3 + 1] = (unsigned) i;
+        mesh->sources[i*3 + 2] = (unsigned) i;
+    }
+}
+
+//****************************************************************************
+static void bench_free_mesh(
+    daeu_mesh* mesh)
+{
+    bench_aligned_free(mesh->vertices);
+    free(mesh->sources);
+}
+
+//****************************************************************************
+static void bench_skin(
+    const bench_options* opts)
+{
+    size_t numvertices = (size_t) (1048576*opts->scale);
+    unsigned influences = 4;
+    daeu_mesh_attrib attribs[3];
+    daeu_mesh mesh;
+    daeu_skin skin;
+    float* palette;
+    float* out;
+    double best = 1e30;
+    unsigned seed = 7;
+    size_t i;
+    int rep;
+    bench_init_mesh(&mesh, attribs, numvertices, &seed);
+    memset(&skin, 0, sizeof(skin));
+    skin.numjoints = 64;
+    skin.numvertices = numvertices;
+    skin.influences = influences;
+    skin.indices = (unsigned short*) bench_aligned_alloc(
+        numvertices*influences*sizeof(unsigned short));
+    skin.weights = (float*) bench_aligned_alloc(
+        numvertices*influences*sizeof(float));
+    for(i = 0; i < numvertices*influences; ++i)
+    {
+        skin.indices[i] = (unsigned short) (bench_rand(&seed) % 64);
+        skin.weights[i] = 1.0f/influences;
+    }
+    palette = (float*) bench_aligned_alloc(skin.numjoints*16*sizeof(float));
+    for(i = 0; i < skin.numjoints*16; ++i)
+    {
+        palette[i] = ((i % 5) == 0) ? 1.0f : bench_randf(&seed)*0.1f;
+    }
+    out = (float*) bench_aligned_alloc(
+        numvertices*mesh.vertexsize*sizeof(float));
+    for(rep = 0; rep < opts->reps; ++rep)
+    {
+        double t = bench_get_time();
+        daeu_skin_deform(&skin, palette, &mesh, opts->numthreads, out);
+        t = bench_get_time() - t;
+        best = (t < best) ? t : best;
+    }
+    bench_report_kernel("skin_deform", numvertices, best);
+    bench_aligned_free(out);
+    bench_aligned_free(palette);
+    bench_aligned_free(skin.weights);
+    bench_aligned_free(skin.indices);
+    bench_free_mesh(&mesh);
+}
+
+//****************************************************************************
+static void bench_morph(
+    const bench_options* opts)
+{
+    size_t numvertices = (size_t) (1048576*opts->scale);
+    daeu_mesh_attrib attribs[9][3];
+    daeu_mesh meshes[9];
+    float weights[8];
+    float* out;
+    double best[2] = { 1e30, 1e30 };
+    unsigned seed = 8;
+    size_t i;
+    int rep;
+    for(i = 0; i < 9; ++i)
+    {
+        bench_init_mesh(meshes + i, attribs[i], numvertices, &seed);
+    }
+    for(i = 0; i < 8; ++i)
+    {
+        weights[i] = 0.1f;
+    }
+    out = (float*) bench_aligned_alloc(
+        numvertices*meshes[0].vertexsize*sizeof(float));
+    for(rep = 0; rep < opts->reps; ++rep)
+    {
+        double t = bench_get_time();
+        daeu_morph_blend(
+            meshes, meshes + 1, weights, 8,
+            daeu_MORPH_NORMALIZED, opts->numthreads, out);
+        t = bench_get_time() - t;
+        best[0] = (t < best[0]) ? t : best[0];
+        t = bench_get_time();
+        daeu_morph_blend(
+            meshes, meshes + 1, weights, 8,
+            daeu_MORPH_RELATIVE, opts->numthreads, out);
+        t = bench_get_time() - t;
+        best[1] = (t < best[1]) ? t : best[1];
+    }
+    bench_report_kernel("morph_blend_normalized", numvertices, best[0]);
+    bench_report_kernel("morph_blend_relative", numvertices, best[1]);
+    bench_aligned_free(out);
+    for(i = 0; i < 9; ++i)
+    {
+        bench_free_mesh(meshes + i);
+    }
+}
+
+//****************************************************************************
+static void bench_tris(
+    const bench_options* opts)
+{
+    // polygons are generated in the document, as they would be loaded
+    daeu_mesh_attrib attribs[2];
+    daeu_mesh compiled;
+    dae_COLLADA* doc;
+    dae_mesh_type* mesh;
+    bench_text text;
+    daeu_tris* tris;
+    double best[2] = { 1e30, 1e30 };
+    size_t numpolys;
+    size_t numprims;
+    size_t numtris = 0;
+    size_t i;
+    int rep;
+    memset(&text, 0, sizeof(text));
+    numpolys = bench_gen_tris(&text, opts->scale);
+    doc = bench_parse(&text, NULL);
+    mesh = doc->el_library_geometries.values[0]->
+        el_geometry.values[0]->el_mesh;
+    attribs[0].semantic = "POSITION";
+    attribs[0].set = -1;
+    attribs[1].semantic = "NORMAL";
+    attribs[1].set = -1;
+    numprims = mesh->el_polylist.size + mesh->el_polygons.size;
+    tris = (daeu_tris*) malloc(numprims*sizeof(*tris));
+    for(rep = 0; rep < opts->reps; ++rep)
+    {
+        double t = bench_get_time();
+        for(i = 0; i < mesh->el_polylist.size; ++i)
+        {
+            daeu_triangulate(mesh, mesh->el_polylist.values[i], tris + i);
+        }
+        for(i = 0; i < mesh->el_polygons.size; ++i)
+        {
+            daeu_triangulate(
+                mesh,
+                mesh->el_polygons.values[i],
+                tris + mesh->el_polylist.size + i);
+        }
+        t = bench_get_time() - t;
+        best[0] = (t < best[0]) ? t : best[0];
+        numtris = 0;
+        for(i = 0; i < numprims; ++i)
+        {
+            numtris += tris[i].numtris;
+            daeu_tris_destroy(tris + i);
+        }
+        t = bench_get_time();
+        daeu_mesh_compile(mesh, attribs, 2, &compiled);
+        t = bench_get_time() - t;
+        best[1] = (t < best[1]) ? t : best[1];
+        daeu_mesh_destroy(&compiled);
+    }
+    bench_report_kernel("triangulate", numpolys, best[0]);
+    bench_report_kernel("mesh_compile", numtris, best[1]);
+    free(tris);
+    dae_destroy(doc);
+    free(text.str);
+}
+
+//****************************************************************************
+int main(
+    int argc,
+    char** argv)
+{
+    static const char* s_all[] =
+    {
+        "threads", "arrays", "deep", "small", "anim", "batch", "matrix",
+        "skin", "morph", "tris"
+    };
+    const char** names = s_all;
+    size_t numnames = sizeof(s_all)/sizeof(*s_all);
+    bench_options opts;
+    size_t i;
+    int argi = 1;
+    opts.scale = 1.0;
+    opts.reps = 3;
+    opts.numthreads = 0;
+    while(argi + 1 < argc && argv[argi][0] == '-')
+    {
+        if(!strcmp(argv[argi], "-s"))
+        {
+            opts.scale = atof(argv[argi + 1]);
+        }
+        else if(!strcmp(argv[argi], "-r"))
+        {
+            opts.reps = atoi(argv[argi + 1]);
+        }
+        else if(!strcmp(argv[argi], "-t"))
+        {
+            opts.numthreads = atoi(argv[argi + 1]);
+        }
+        argi += 2;
+    }
+    if(opts.scale <= 0.0 || opts.reps < 1 ||
+       (argi < argc && argv[argi][0] == '-'))
+    {
+        fprintf(stderr,
+            "usage: bench [-s scale] [-r reps] [-t threads] [name ...]\n"
+            "names: threads arrays deep small anim batch matrix skin "
+            "morph tris\n");
+        return 1;
+    }
+    if(argi < argc)
+    {
+        names = (const char**) argv + argi;
+        numnames = argc - argi;
+    }
+    for(i = 0; i < numnames; ++i)
+    {
+        const char* name = names[i];
+        if(!strcmp(name, "threads"))
+        {
+            bench_threads(&opts);
+        }
+        else if(!strcmp(name, "batch"))
+        {
+            bench_batch(&opts);
+        }
+        else if(!strcmp(name, "matrix"))
+        {
+            bench_matrix(&opts);
+        }
+        else if(!strcmp(name, "skin"))
+        {
+            bench_skin(&opts);
+        }
+        else if(!strcmp(name, "morph"))
+        {
+            bench_morph(&opts);
+        }
+        else if(!strcmp(name, "tris") || !strcmp(name, "polylist"))
+        {
+            bench_tris(&opts);
+        }
+        else if(!strcmp(name, "arrays") || !strcmp(name, "deep") ||
+                !strcmp(name, "small") || !strcmp(name, "anim"))
+        {
+            bench_load(name, &opts);
+        }
+        else
+        {
+            fprintf(stderr, "bench: unknown benchmark %s\n", name);
+            return 1;
+        }
+        fflush(stdout);
+    }
+    return 0;
+}
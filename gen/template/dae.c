@@ -10,6 +10,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define dae_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifdef DAE_INSTRUMENT
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#endif
 
 #define dae_GET_HEADER(pobj_) \
     ((dae_obj_header*) (((ptrdiff_t) pobj_)-((sizeof(dae_obj_header)+7)&~7)))
@@ -17,6 +32,28 @@
 #define dae_GET_PTR(phdr_) \
     ((dae_obj_ptr)  (((ptrdiff_t) phdr_)+((sizeof(dae_obj_header)+7)&~7)))
 
+#ifdef _MSC_VER
+#define dae_ATOMIC_LOAD(p_) _InterlockedCompareExchange((p_), 0, 0)
+#define dae_ATOMIC_STORE(p_, v_) _InterlockedExchange((p_), (v_))
+#define dae_ATOMIC_CAS(p_, old_, new_) \
+    (_InterlockedCompareExchange((p_), (new_), (old_)) == (old_))
+#define dae_ATOMIC_ADD(p_, v_) (_InterlockedExchangeAdd((p_), (v_)) + (v_))
+#else
+#define dae_ATOMIC_LOAD(p_) __atomic_load_n((p_), __ATOMIC_ACQUIRE)
+#define dae_ATOMIC_STORE(p_, v_) __atomic_store_n((p_), (v_), __ATOMIC_RELEASE)
+#define dae_ATOMIC_CAS(p_, old_, new_) \
+    __sync_bool_compare_and_swap((p_), (old_), (new_))
+#define dae_ATOMIC_ADD(p_, v_) __sync_add_and_fetch((p_), (v_))
+#endif
+
+// numeric data vectors are preceded by a reference count, so that clones
+// can share them until one of them writes. the size keeps the values
+// aligned as malloc would
+#define dae_DATA_HEADER_SIZE 16
+
+#define dae_GET_DATA_REFS(pvalues_) \
+    ((volatile long*) (((char*) (pvalues_)) - dae_DATA_HEADER_SIZE))
+
 enum dae_obj_memberdeftype_e
 {
     dae_MEMBER_ATTRIB,
@@ -28,8 +65,16 @@ enum dae_obj_flags_e
     dae_XSD_ANY = 1 << 0,
 };
 
+enum dae_schema_state_e
+{
+    dae_SCHEMA_EMPTY,
+    dae_SCHEMA_BUILDING,
+    dae_SCHEMA_READY
+};
+
 typedef enum dae_obj_memberdeftype_e dae_obj_memberdeftype;
 typedef enum dae_obj_flags_e dae_obj_flags;
+typedef enum dae_schema_state_e dae_schema_state;
 
 typedef struct dae_obj_memberdef_s dae_obj_memberdef;
 typedef struct dae_obj_typedef_s dae_obj_typedef;
@@ -84,21 +129,81 @@ struct dae_obj_header_s
     const char* membername;
     int structindex;
     const dae_obj_typedef* def;
+    const dae_allocator* allocator;
     dae_obj_list attribs;
     dae_obj_list elems;
     dae_obj_header* prev;
     dae_obj_header* next;
 };
 
+static void* dae_libc_alloc(
+    void* user,
+    size_t size);
+
+static void* dae_libc_realloc(
+    void* user,
+    void* ptr,
+    size_t size);
+
+static void dae_libc_free(
+    void* user,
+    void* ptr);
+
+static void* dae_alloc(
+    const dae_allocator* allocator,
+    size_t size);
+
+static void* dae_realloc(
+    const dae_allocator* allocator,
+    void* ptr,
+    size_t size);
+
 static void dae_free(
+    const dae_allocator* allocator,
+    void* ptr);
+
+#ifdef DAE_INSTRUMENT
+static double dae_get_time();
+
+static void* dae_instrument_alloc(
+    void* user,
+    size_t size);
+
+static void* dae_instrument_realloc(
+    void* user,
+    void* ptr,
+    size_t size);
+
+static void dae_instrument_free(
+    void* user,
     void* ptr);
 
+static dae_instrument* dae_get_instrument(
+    const dae_obj_header* hdr);
+#endif
+
 static char* dae_strdup(
+    const dae_allocator* allocator,
     const char* str);
 
 static dae_obj_ptr dae_create_obj(
+    const dae_allocator* allocator,
     const dae_obj_typedef* def);
 
+static dae_obj_header* dae_clone_obj(
+    const dae_allocator* allocator,
+    const dae_obj_header* srchdr);
+
+static void* dae_reserve_data(
+    const dae_allocator* allocator,
+    dae_obj_vector* vec,
+    size_t count,
+    size_t typesize);
+
+static void dae_release_data(
+    const dae_allocator* allocator,
+    void* values);
+
 static dae_obj_ptr dae_add_obj(
     dae_obj_header* parenthdr,
     dae_obj_list* parentlist,
@@ -107,9 +212,37 @@ static dae_obj_ptr dae_add_obj(
     const dae_obj_typedef* childdef,
     size_t childsize);
 
+static void dae_link_obj(
+    dae_obj_header* parenthdr,
+    dae_obj_list* parentlist,
+    const dae_obj_memberdef* memberdef,
+    dae_obj_header* childhdr);
+
+static void dae_unlink_obj(
+    dae_obj_header* hdr);
+
 static void dae_destroy_obj(
     dae_obj_header* hdr);
 
+static size_t dae_count_split_trees(
+    const dae_obj_header* root,
+    int depth,
+    int* deeper_out);
+
+static void dae_split_trees(
+    dae_obj_header* root,
+    int depth,
+    dae_obj_ptr* subtrees_out);
+
+static void dae_count_obj_memory(
+    const dae_obj_header* hdr,
+    dae_memory_stats* stats);
+
+static size_t dae_convert_string_bools(
+    const char* str,
+    int* bools_out,
+    size_t max);
+
 static size_t dae_convert_string_floats(
     const char* str,
     float* floats_out);
@@ -135,9 +268,13 @@ static size_t dae_convert_string_uint32s(
     unsigned* ints_out);
 
 static size_t dae_convert_string_words(
+    const dae_allocator* allocator,
     const char* str,
     char** strings_out);
 
+static size_t dae_count_string_bools(
+    const char* str);
+
 static size_t dae_count_string_floats(
     const char* str);
 
@@ -156,9 +293,27 @@ static size_t dae_count_string_uint8s(
 static size_t dae_count_string_uint32s(
     const char* str);
 
+static size_t dae_count_string_hex8s(
+    const char* str);
+
 static size_t dae_count_string_words(
     const char* str);
 
+static dae_obj_header* dae_get_next_in_tree(
+    const dae_obj_header* root,
+    const dae_obj_header* itr);
+
+static size_t dae_get_native_size(
+    dae_obj_typeid datatype);
+
+static size_t dae_decode_hex_blocks(
+    const char* str,
+    size_t len,
+    unsigned char* bytes_out);
+
+static int dae_get_hex_digit(
+    char c);
+
 static void dae_get_schema(
     dae_obj_typedef** types,
     unsigned* numtypes);
@@ -169,6 +324,14 @@ static dae_obj_typedef* dae_get_type(
 static dae_obj_typedef* dae_find_type(
     const char* name);
 
+static const dae_allocator dae_libc_allocator =
+{
+    dae_libc_alloc,
+    dae_libc_realloc,
+    dae_libc_free,
+    NULL
+};
+
 //****************************************************************************
 /*GEN_SCHEMA_BGN*/
 static void dae_build_schema(
@@ -179,20 +342,143 @@ static void dae_build_schema(
 /*GEN_SCHEMA_END*/
 
 //****************************************************************************
-static void dae_free(void* ptr)
+static void* dae_libc_alloc(
+    void* user,
+    size_t size)
+{
+    return malloc(size);
+}
+
+//****************************************************************************
+static void* dae_libc_realloc(
+    void* user,
+    void* ptr,
+    size_t size)
+{
+    return realloc(ptr, size);
+}
+
+//****************************************************************************
+static void dae_libc_free(
+    void* user,
+    void* ptr)
 {
     free(ptr);
 }
 
+//****************************************************************************
+static void* dae_alloc(
+    const dae_allocator* allocator,
+    size_t size)
+{
+    return allocator->alloc(allocator->user, size);
+}
+
+//****************************************************************************
+static void* dae_realloc(
+    const dae_allocator* allocator,
+    void* ptr,
+    size_t size)
+{
+    // the hooks are not required to treat a NULL block as a new allocation
+    if(ptr == NULL)
+    {
+        return allocator->alloc(allocator->user, size);
+    }
+    return allocator->realloc(allocator->user, ptr, size);
+}
+
+//****************************************************************************
+static void dae_free(
+    const dae_allocator* allocator,
+    void* ptr)
+{
+    if(ptr != NULL)
+    {
+        allocator->free(allocator->user, ptr);
+    }
+}
+
+#ifdef DAE_INSTRUMENT
+//****************************************************************************
+static double dae_get_time()
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return ((double) now.QuadPart) / ((double) freq.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double) now.tv_sec) + ((double) now.tv_nsec)*1e-9;
+#endif
+}
+
+//****************************************************************************
+static void* dae_instrument_alloc(
+    void* user,
+    size_t size)
+{
+    dae_instrument* instrument = (dae_instrument*) user;
+    double t = dae_get_time();
+    void* ptr = dae_alloc(instrument->allocator, size);
+    instrument->alloctime += dae_get_time() - t;
+    ++instrument->numallocs;
+    return ptr;
+}
+
+//****************************************************************************
+static void* dae_instrument_realloc(
+    void* user,
+    void* ptr,
+    size_t size)
+{
+    dae_instrument* instrument = (dae_instrument*) user;
+    double t = dae_get_time();
+    ptr = dae_realloc(instrument->allocator, ptr, size);
+    instrument->alloctime += dae_get_time() - t;
+    ++instrument->numallocs;
+    return ptr;
+}
+
+//****************************************************************************
+static void dae_instrument_free(
+    void* user,
+    void* ptr)
+{
+    dae_instrument* instrument = (dae_instrument*) user;
+    double t = dae_get_time();
+    dae_free(instrument->allocator, ptr);
+    instrument->alloctime += dae_get_time() - t;
+}
+
+//****************************************************************************
+static dae_instrument* dae_get_instrument(
+    const dae_obj_header* hdr)
+{
+    // an instrumented object allocates through the instrument's hooks
+    const dae_allocator* allocator = hdr->allocator;
+    dae_instrument* instrument = NULL;
+    if(allocator->alloc == dae_instrument_alloc)
+    {
+        instrument = (dae_instrument*) allocator->user;
+    }
+    return instrument;
+}
+#endif
+
 //****************************************************************************
 static char* dae_strdup(
+    const dae_allocator* allocator,
     const char* str)
 {
     char* dup = NULL;
     if(str != NULL && *str != '\0')
     {
         size_t sz = strlen(str) + 1;
-        dup = (char*) malloc(sz);
+        dup = (char*) dae_alloc(allocator, sz);
         memcpy(dup, str, sz);
     }
     return dup;
@@ -200,18 +486,158 @@ static char* dae_strdup(
 
 //****************************************************************************
 static dae_obj_ptr dae_create_obj(
+    const dae_allocator* allocator,
     const dae_obj_typedef* def)
 {
     size_t objsize = (def != NULL) ? def->size : sizeof(char*);
     size_t bufsize = ((ptrdiff_t) dae_GET_PTR(0)) + objsize;
-    dae_obj_header* hdr = (dae_obj_header*) malloc(bufsize);
+    dae_obj_header* hdr = (dae_obj_header*) dae_alloc(allocator, bufsize);
     dae_obj_ptr obj = dae_GET_PTR(hdr);
     memset(hdr, 0, bufsize);
     hdr->structindex = -1;
     hdr->def = def;
+    hdr->allocator = allocator;
     return obj;
 }
 
+//****************************************************************************
+static dae_obj_header* dae_clone_obj(
+    const dae_allocator* allocator,
+    const dae_obj_header* srchdr)
+{
+    // copies the data of an object, but not its links to other objects
+    const dae_obj_typedef* def = srchdr->def;
+    const void* src = dae_GET_PTR(srchdr);
+    void* dst = dae_create_obj(allocator, def);
+    dae_obj_typeid datatype = dae_ID_STRING;
+    int datamax = 1;
+    size_t dataoff = 0;
+    if(def != NULL)
+    {
+        datatype = (dae_obj_typeid) def->datatypeid;
+        datamax = def->datamax;
+        dataoff = def->dataoffset;
+    }
+    if(datatype != dae_ID_INVALID)
+    {
+        size_t typesize = dae_get_native_size(datatype);
+        char** sitr = NULL;
+        char** send = NULL;
+        if(datamax == -1)
+        {
+            const dae_obj_vector* srcvec;
+            dae_obj_vector* dstvec;
+            srcvec = (const dae_obj_vector*) (((ptrdiff_t) src) + dataoff);
+            dstvec = (dae_obj_vector*) (((ptrdiff_t) dst) + dataoff);
+            if(srcvec->size > 0)
+            {
+                size_t sz = srcvec->size * typesize;
+                if(datatype == dae_ID_STRING)
+                {
+                    dstvec->values = dae_alloc(allocator, sz);
+                    memcpy(dstvec->values, srcvec->values, sz);
+                    sitr = (char**) dstvec->values;
+                    send = sitr + srcvec->size;
+                }
+                else if(allocator == srchdr->allocator)
+                {
+                    // numeric vectors are shared until either side writes
+                    dae_ATOMIC_ADD(dae_GET_DATA_REFS(srcvec->values), 1);
+                    dstvec->values = srcvec->values;
+                }
+                else
+                {
+                    // memory from other hooks is copied in bulk
+                    dae_reserve_data(
+                        allocator,
+                        dstvec,
+                        srcvec->size,
+                        typesize);
+                    memcpy(dstvec->values, srcvec->values, sz);
+                }
+                dstvec->size = srcvec->size;
+            }
+        }
+        else
+        {
+            memcpy(
+                ((char*) dst) + dataoff,
+                ((const char*) src) + dataoff,
+                datamax * typesize);
+            if(datatype == dae_ID_STRING)
+            {
+                sitr = (char**) (((ptrdiff_t) dst) + dataoff);
+                send = sitr + datamax;
+            }
+        }
+        while(sitr != send)
+        {
+            // each string is owned by its object
+            *sitr = dae_strdup(allocator, *sitr);
+            ++sitr;
+        }
+    }
+    return dae_GET_HEADER(dst);
+}
+
+//****************************************************************************
+static void* dae_reserve_data(
+    const dae_allocator* allocator,
+    dae_obj_vector* vec,
+    size_t count,
+    size_t typesize)
+{
+    // makes a numeric data vector writable, with room for at least count
+    // values. a vector shared with a clone is copied first
+    char* block = NULL;
+    size_t size = vec->size;
+    if(vec->values != NULL)
+    {
+        block = (char*) dae_GET_DATA_REFS(vec->values);
+        if(dae_ATOMIC_LOAD(dae_GET_DATA_REFS(vec->values)) > 1)
+        {
+            size_t cap = (count > size) ? count : size;
+            char* copy = (char*) dae_alloc(
+                allocator,
+                dae_DATA_HEADER_SIZE + cap*typesize);
+            memcpy(copy + dae_DATA_HEADER_SIZE, vec->values, size*typesize);
+            dae_release_data(allocator, vec->values);
+            block = copy;
+            *((volatile long*) block) = 1;
+            vec->values = block + dae_DATA_HEADER_SIZE;
+            size = cap;
+        }
+    }
+    if((block == NULL) ? (count > 0) : (count > size))
+    {
+        block = (char*) dae_realloc(
+            allocator,
+            block,
+            dae_DATA_HEADER_SIZE + count*typesize);
+        if(vec->values == NULL)
+        {
+            *((volatile long*) block) = 1;
+        }
+        vec->values = block + dae_DATA_HEADER_SIZE;
+    }
+    return vec->values;
+}
+
+//****************************************************************************
+static void dae_release_data(
+    const dae_allocator* allocator,
+    void* values)
+{
+    if(values != NULL)
+    {
+        volatile long* refs = dae_GET_DATA_REFS(values);
+        if(dae_ATOMIC_ADD(refs, -1) == 0)
+        {
+            dae_free(allocator, (void*) refs);
+        }
+    }
+}
+
 //****************************************************************************
 static dae_obj_ptr dae_add_obj(
     dae_obj_header* parenthdr,
@@ -221,13 +647,38 @@ static dae_obj_ptr dae_add_obj(
     const dae_obj_typedef* childdef,
     size_t childsize)
 {
-    void* parentobj = dae_GET_PTR(parenthdr);
-    void* childobj = dae_create_obj(childdef);
+    const dae_allocator* allocator = parenthdr->allocator;
+    void* childobj = dae_create_obj(allocator, childdef);
     dae_obj_header* childhdr = dae_GET_HEADER(childobj);
+    dae_link_obj(parenthdr, parentlist, memberdef, childhdr);
+    if(memberdef != NULL)
+    {
+        // if member definition exists, re-use name string from definition
+        childhdr->membername = memberdef->name;
+    }
+    else
+    {
+        // if no member definition exists, need to make a copy of name string
+        childhdr->membername = dae_strdup(allocator, membername);
+    }
+    return (dae_obj_ptr) childobj;
+}
+
+//****************************************************************************
+static void dae_link_obj(
+    dae_obj_header* parenthdr,
+    dae_obj_list* parentlist,
+    const dae_obj_memberdef* memberdef,
+    dae_obj_header* childhdr)
+{
+    void* parentobj = dae_GET_PTR(parenthdr);
+    void* childobj = dae_GET_PTR(childhdr);
+    const dae_allocator* allocator = parenthdr->allocator;
     // initialize header information
     childhdr->parent = parenthdr;
     childhdr->parentlist = parentlist;
     childhdr->memberdef = memberdef;
+    childhdr->structindex = -1;
     // add element to parent's header
     childhdr->prev = parentlist->tail;
     childhdr->next = NULL;
@@ -264,7 +715,10 @@ static dae_obj_ptr dae_add_obj(
             vec = (dae_obj_vector*) (((ptrdiff_t) parentobj)+offset);
             i = vec->size;
             childhdr->structindex = i;
-            buf = (void**) realloc(vec->values, (i+1) * sizeof(*buf));
+            buf = (void**) dae_realloc(
+                allocator,
+                vec->values,
+                (i+1) * sizeof(*buf));
             buf[i] = childobj;
             vec->values = buf;
             ++vec->size;
@@ -286,15 +740,70 @@ static dae_obj_ptr dae_add_obj(
                 ++mbritr;
             }
         }
-        // if member definition exists, re-use name string from definition
-        childhdr->membername = memberdef->name;
+    }
+}
+
+//****************************************************************************
+static void dae_unlink_obj(
+    dae_obj_header* hdr)
+{
+    dae_obj_header* parenthdr = hdr->parent;
+    dae_obj_list* parentlist = hdr->parentlist;
+    const dae_obj_memberdef* memberdef = hdr->memberdef;
+    // remove element from parent's header
+    if(hdr->prev != NULL)
+    {
+        hdr->prev->next = hdr->next;
     }
     else
     {
-        // if no member definition exists, need to make a copy of name string
-        childhdr->membername = dae_strdup(membername);
+        parentlist->head = hdr->next;
     }
-    return (dae_obj_ptr) childobj;
+    if(hdr->next != NULL)
+    {
+        hdr->next->prev = hdr->prev;
+    }
+    else
+    {
+        parentlist->tail = hdr->prev;
+    }
+    // remove element from parent's struct, if it was placed there
+    if(memberdef != NULL && hdr->structindex >= 0)
+    {
+        void* parentobj = dae_GET_PTR(parenthdr);
+        int offset = memberdef->offset;
+        if(memberdef->max < 0)
+        {
+            // close the gap in the vector and renumber the later siblings
+            dae_obj_vector* vec;
+            void** buf;
+            size_t i;
+            vec = (dae_obj_vector*) (((ptrdiff_t) parentobj)+offset);
+            buf = (void**) vec->values;
+            for(i = hdr->structindex + 1; i < vec->size; ++i)
+            {
+                buf[i - 1] = buf[i];
+                dae_GET_HEADER(buf[i - 1])->structindex = (int) (i - 1);
+            }
+            --vec->size;
+            if(vec->size == 0)
+            {
+                dae_free(parenthdr->allocator, vec->values);
+                vec->values = NULL;
+            }
+        }
+        else
+        {
+            // single instance pointer or fixed length array
+            void** mbr = (void**) (((ptrdiff_t) parentobj)+offset);
+            mbr[hdr->structindex] = NULL;
+        }
+    }
+    hdr->parent = NULL;
+    hdr->parentlist = NULL;
+    hdr->structindex = -1;
+    hdr->prev = NULL;
+    hdr->next = NULL;
 }
 
 //****************************************************************************
@@ -330,6 +839,7 @@ static void dae_destroy_obj(
         if(itr->attribs.head == NULL && itr->elems.head == NULL)
         {
             void* obj = dae_GET_PTR(itr);
+            const dae_allocator* allocator = itr->allocator;
             dae_obj_typeid datatype = dae_ID_INVALID;
             int datamax;
             size_t dataoff;
@@ -338,7 +848,7 @@ static void dae_destroy_obj(
                 // if the object had a member definition, the member name
                 // was derived from the def and does not need to be freed.
                 // otherwise, it does
-                dae_free((char*) itr->membername);
+                dae_free(allocator, (char*) itr->membername);
             }
             if(itr->def != NULL)
             {
@@ -358,7 +868,7 @@ static void dae_destroy_obj(
                         vec = (dae_obj_vector*) (((ptrdiff_t) obj) + off);
                         if(vec->values != NULL)
                         {
-                            dae_free(vec->values);
+                            dae_free(allocator, vec->values);
                             // set buffer to NULL to prevent multiple free as
                             // multiple element definitions may reference it
                             vec->values = NULL;
@@ -391,11 +901,16 @@ static void dae_destroy_obj(
                         char** send = sitr + vec->size;
                         while(sitr != send)
                         {
-                            dae_free(*sitr);
+                            dae_free(allocator, *sitr);
                             ++sitr;
                         }
+                        dae_free(allocator, vec->values);
+                    }
+                    else
+                    {
+                        // numeric vectors may still be used by clones
+                        dae_release_data(allocator, vec->values);
                     }
-                    dae_free(vec->values);
                 }
                 else if(datatype == dae_ID_STRING)
                 {
@@ -404,12 +919,12 @@ static void dae_destroy_obj(
                     char** send = sitr + datamax;
                     while(sitr != send)
                     {
-                        dae_free(*sitr);
+                        dae_free(allocator, *sitr);
                         ++sitr;
                     }
                 }
             }
-            dae_free(itr);
+            dae_free(allocator, itr);
             if(itr == hdr)
             {
                 // if the freed item was the selected object, stop
@@ -420,6 +935,234 @@ static void dae_destroy_obj(
     }
 }
 
+//****************************************************************************
+static size_t dae_count_split_trees(
+    const dae_obj_header* root,
+    int depth,
+    int* deeper_out)
+{
+    // counts the elements from the top level down to the given depth, each
+    // of which becomes a tree when split at that depth
+    const dae_obj_header* itr = root->elems.head;
+    size_t n = 0;
+    int d = 1;
+    *deeper_out = 0;
+    while(itr != NULL)
+    {
+        ++n;
+        if(itr->elems.head != NULL)
+        {
+            if(d < depth)
+            {
+                itr = itr->elems.head;
+                ++d;
+                continue;
+            }
+            *deeper_out = 1;
+        }
+        while(itr->next == NULL && itr->parent != root)
+        {
+            itr = itr->parent;
+            --d;
+        }
+        itr = itr->next;
+    }
+    return n;
+}
+
+//****************************************************************************
+static void dae_split_trees(
+    dae_obj_header* root,
+    int depth,
+    dae_obj_ptr* subtrees_out)
+{
+    // unlinks the same elements dae_count_split_trees counts. each element
+    // is unlinked once everything below it down to the depth has been, so
+    // the links still being walked are never the ones being cleared
+    dae_obj_header* itr = root->elems.head;
+    size_t n = 0;
+    int d = 1;
+    while(itr != NULL)
+    {
+        if(itr->elems.head != NULL && d < depth)
+        {
+            itr = itr->elems.head;
+            ++d;
+            continue;
+        }
+        while(itr != NULL)
+        {
+            dae_obj_header* next = itr->next;
+            dae_obj_header* parent = itr->parent;
+            if(d < depth)
+            {
+                // the children of the element are trees of their own
+                itr->elems.head = NULL;
+                itr->elems.tail = NULL;
+            }
+            // the struct vectors of the parent still point at the element,
+            // but they are only freed, never followed, by dae_destroy_obj
+            itr->parent = NULL;
+            itr->parentlist = NULL;
+            itr->prev = NULL;
+            itr->next = NULL;
+            subtrees_out[n] = dae_GET_PTR(itr);
+            ++n;
+            if(next != NULL)
+            {
+                itr = next;
+                break;
+            }
+            // the last child is done, so its parent is finished too
+            itr = (parent != root) ? parent : NULL;
+            --d;
+        }
+    }
+    root->elems.head = NULL;
+    root->elems.tail = NULL;
+}
+
+//****************************************************************************
+static void dae_count_obj_memory(
+    const dae_obj_header* hdr,
+    dae_memory_stats* stats)
+{
+    const void* obj = dae_GET_PTR(hdr);
+    const dae_obj_typedef* def = hdr->def;
+    dae_obj_typeid datatype;
+    int datamax;
+    size_t dataoff;
+    ++stats->count;
+    stats->headerbytes += (size_t) (ptrdiff_t) dae_GET_PTR(0);
+    if(hdr->memberdef == NULL && hdr->membername != NULL)
+    {
+        // the name is only owned when there is no member definition
+        stats->stringbytes += strlen(hdr->membername) + 1;
+    }
+    if(def != NULL)
+    {
+        const dae_obj_memberdef* mbrbgn = def->elems;
+        const dae_obj_memberdef* mbrend = mbrbgn + def->numelems;
+        const dae_obj_memberdef* mbritr;
+        stats->structbytes += def->size;
+        for(mbritr = mbrbgn; mbritr != mbrend; ++mbritr)
+        {
+            if(mbritr->max < 0)
+            {
+                // multiple element definitions may share one vector, so
+                // only the first definition at an offset is counted
+                const dae_obj_memberdef* previtr = mbrbgn;
+                const dae_obj_vector* vec;
+                while(previtr != mbritr && previtr->offset != mbritr->offset)
+                {
+                    ++previtr;
+                }
+                if(previtr == mbritr)
+                {
+                    size_t off = mbritr->offset;
+                    vec = (const dae_obj_vector*) (((ptrdiff_t) obj) + off);
+                    stats->vectorbytes += vec->size * sizeof(void*);
+                }
+            }
+        }
+        datatype = (dae_obj_typeid) def->datatypeid;
+        datamax = def->datamax;
+        dataoff = def->dataoffset;
+    }
+    else
+    {
+        stats->structbytes += sizeof(char*);
+        datatype = dae_ID_STRING;
+        datamax = 1;
+        dataoff = 0;
+    }
+    if(datatype != dae_ID_INVALID)
+    {
+        char* const* sitr = NULL;
+        char* const* send = NULL;
+        if(datamax == -1)
+        {
+            const dae_obj_vector* vec;
+            vec = (const dae_obj_vector*) (((ptrdiff_t) obj) + dataoff);
+            if(datatype == dae_ID_STRING)
+            {
+                stats->vectorbytes += vec->size * sizeof(char*);
+                sitr = (char* const*) vec->values;
+                send = sitr + vec->size;
+            }
+            else if(vec->values != NULL)
+            {
+                // a numeric vector carries its reference count, and one
+                // shared with clones is split evenly between its owners so
+                // the totals of all of them add up to the block
+                size_t bytes = dae_DATA_HEADER_SIZE +
+                    vec->size * dae_get_native_size(datatype);
+                long refs = dae_ATOMIC_LOAD(dae_GET_DATA_REFS(vec->values));
+                stats->vectorbytes += bytes/(size_t) ((refs > 0) ? refs : 1);
+            }
+        }
+        else if(datatype == dae_ID_STRING)
+        {
+            sitr = (char* const*) (((ptrdiff_t) obj) + dataoff);
+            send = sitr + datamax;
+        }
+        while(sitr != send)
+        {
+            if(*sitr != NULL)
+            {
+                stats->stringbytes += strlen(*sitr) + 1;
+            }
+            ++sitr;
+        }
+    }
+}
+
+//****************************************************************************
+static size_t dae_convert_string_bools(
+    const char* str,
+    int* bools_out,
+    size_t max)
+{
+    // parses up to max xs:boolean words, which are true, false, 1 or 0.
+    // if bools_out is NULL, the words are only counted
+    size_t n = 0;
+    while(n < max)
+    {
+        size_t len = 0;
+        int b;
+        // move past any leading whitespace
+        while(*str != '\0' && isspace(*str))
+        {
+            ++str;
+        }
+        // find the end of the word
+        while(str[len] != '\0' && !isspace(str[len]))
+        {
+            ++len;
+        }
+        if((len == 4 && !memcmp(str, "true", 4)) || (len == 1 && *str == '1'))
+        {
+            b = 1;
+        }
+        else if((len == 5 && !memcmp(str, "false", 5)) ||
+            (len == 1 && *str == '0'))
+        {
+            b = 0;
+        }
+        else
+        {
+            break;
+        }
+        if(bools_out != NULL)
+        {
+            bools_out[n] = b;
+        }
+        ++n;
+        str += len;
+    }
+    return n;
+}
+
 //****************************************************************************
 static size_t dae_convert_string_floats(
     const char* str,
@@ -628,6 +1371,7 @@ static size_t dae_convert_string_uint32s(
 
 //****************************************************************************
 static size_t dae_convert_string_words(
+    const dae_allocator* allocator,
     const char* str,
     char** strings_out)
 {
@@ -648,7 +1392,7 @@ static size_t dae_convert_string_words(
         // duplicate trimmed word
         if(len > 0)
         {
-            char* dup = (char*) malloc(len + 1);
+            char* dup = (char*) dae_alloc(allocator, len + 1);
             memcpy(dup, str, len);
             dup[len] = '\0';
             strings_out[n] = dup;
@@ -660,6 +1404,13 @@ static size_t dae_convert_string_words(
     return n;
 }
 
+//****************************************************************************
+static size_t dae_count_string_bools(
+    const char* str)
+{
+    return dae_convert_string_bools(str, NULL, (size_t) -1);
+}
+
 //****************************************************************************
 static size_t dae_count_string_floats(
     const char* str)
@@ -777,6 +1528,27 @@ static size_t dae_count_string_uint32s(
     return n;
 }
 
+//****************************************************************************
+static size_t dae_count_string_hex8s(
+    const char* str)
+{
+    // counts the number of bytes that can be decoded from the string
+    size_t n = 0;
+    while(*str != '\0')
+    {
+        if(dae_get_hex_digit(*str) >= 0)
+        {
+            ++n;
+        }
+        else if(!isspace(*str))
+        {
+            break;
+        }
+        ++str;
+    }
+    return n/2;
+}
+
 //****************************************************************************
 static size_t dae_count_string_words(
     const char* str)
@@ -806,16 +1578,173 @@ static size_t dae_count_string_words(
     return n;
 }
 
+//****************************************************************************
+static dae_obj_header* dae_get_next_in_tree(
+    const dae_obj_header* root,
+    const dae_obj_header* itr)
+{
+    // visits attributes before elements, depth first, without leaving the
+    // subtree under root
+    dae_obj_header* result = NULL;
+    if(itr->attribs.head != NULL)
+    {
+        result = itr->attribs.head;
+    }
+    else if(itr->elems.head != NULL)
+    {
+        result = itr->elems.head;
+    }
+    else
+    {
+        while(itr != root)
+        {
+            dae_obj_header* parent = itr->parent;
+            if(itr->next != NULL)
+            {
+                result = itr->next;
+                break;
+            }
+            if(itr->parentlist == &parent->attribs &&
+               parent->elems.head != NULL)
+            {
+                result = parent->elems.head;
+                break;
+            }
+            itr = parent;
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+static size_t dae_get_native_size(
+    dae_obj_typeid datatype)
+{
+    size_t size = 0;
+    switch((dae_native_typeid) datatype)
+    {
+    case dae_NATIVE_BOOL32:
+        size = sizeof(int);
+        break;
+    case dae_NATIVE_HEX8:
+        size = sizeof(unsigned char);
+        break;
+    case dae_NATIVE_FLOAT:
+        size = sizeof(float);
+        break;
+    case dae_NATIVE_INT8:
+        size = sizeof(char);
+        break;
+    case dae_NATIVE_INT16:
+        size = sizeof(short);
+        break;
+    case dae_NATIVE_INT32:
+        size = sizeof(int);
+        break;
+    case dae_NATIVE_STRING:
+        size = sizeof(char*);
+        break;
+    case dae_NATIVE_UINT8:
+        size = sizeof(unsigned char);
+        break;
+    case dae_NATIVE_UINT32:
+        size = sizeof(unsigned);
+        break;
+    default:
+        break;
+    }
+    return size;
+}
+
+//****************************************************************************
+static size_t dae_decode_hex_blocks(
+    const char* str,
+    size_t len,
+    unsigned char* bytes_out)
+{
+    // decodes blocks of 16 digits at a time, stopping at the first block
+    // that contains anything else. returns the number of digits decoded
+    size_t i = 0;
+#ifdef dae_SSE2
+    const __m128i lo = _mm_set1_epi16(0x00ff);
+    const __m128i c0 = _mm_set1_epi8('0' - 1);
+    const __m128i c9 = _mm_set1_epi8('9' + 1);
+    const __m128i ca = _mm_set1_epi8('a' - 1);
+    const __m128i cf = _mm_set1_epi8('f' + 1);
+    for(; i + 16 <= len; i += 16)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i*) (str + i));
+        // setting bit 5 lowers the case of letters and leaves digits alone
+        __m128i l = _mm_or_si128(c, _mm_set1_epi8(0x20));
+        __m128i isdigit = _mm_and_si128(
+            _mm_cmpgt_epi8(c, c0),
+            _mm_cmplt_epi8(c, c9));
+        __m128i isalpha = _mm_and_si128(
+            _mm_cmpgt_epi8(l, ca),
+            _mm_cmplt_epi8(l, cf));
+        __m128i v;
+        if(_mm_movemask_epi8(_mm_or_si128(isdigit, isalpha)) != 0xffff)
+        {
+            break;
+        }
+        v = _mm_or_si128(
+            _mm_and_si128(isdigit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+            _mm_and_si128(isalpha, _mm_sub_epi8(l, _mm_set1_epi8('a'-10))));
+        // the first digit of each pair is the high nibble of the byte
+        v = _mm_or_si128(
+            _mm_slli_epi16(_mm_and_si128(v, lo), 4),
+            _mm_srli_epi16(v, 8));
+        _mm_storel_epi64(
+            (__m128i*) (bytes_out + i/2),
+            _mm_packus_epi16(v, v));
+    }
+#else
+    (void) str;
+    (void) len;
+    (void) bytes_out;
+#endif
+    return i;
+}
+
+//****************************************************************************
+static int dae_get_hex_digit(
+    char c)
+{
+    if(c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    c |= 0x20;
+    if(c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
 //****************************************************************************
 static void dae_get_schema(
     dae_obj_typedef** types,
     unsigned* numtypes)
 {
+    // the tables are built by the first caller while any other callers
+    // wait, so documents may be created from many threads at once
     static dae_obj_typedef* s_types;
     static unsigned s_numtypes;
-    if(s_types == NULL)
+    static volatile long s_state;
+    if(dae_ATOMIC_LOAD(&s_state) != dae_SCHEMA_READY)
     {
-        dae_build_schema(&s_types, &s_numtypes);
+        if(dae_ATOMIC_CAS(&s_state, dae_SCHEMA_EMPTY, dae_SCHEMA_BUILDING))
+        {
+            dae_build_schema(&s_types, &s_numtypes);
+            dae_ATOMIC_STORE(&s_state, dae_SCHEMA_READY);
+        }
+        else
+        {
+            while(dae_ATOMIC_LOAD(&s_state) != dae_SCHEMA_READY)
+            {
+            }
+        }
     }
     *types = s_types;
     *numtypes = s_numtypes;
@@ -864,6 +1793,10 @@ dae_obj_ptr dae_add_attrib(
     const dae_obj_memberdef* at = NULL;
     const dae_obj_typedef* def = NULL;
     dae_obj_ptr obj = NULL;
+#ifdef DAE_INSTRUMENT
+    dae_instrument* instrument = dae_get_instrument(parenthdr);
+    double t = dae_get_time();
+#endif
     if(parentdef != NULL)
     {
         // predefined content type
@@ -886,6 +1819,13 @@ dae_obj_ptr dae_add_attrib(
         // undefined type, assume all attributes are strings
         def = dae_get_type(dae_ID_STRING);
     }
+#ifdef DAE_INSTRUMENT
+    if(instrument != NULL)
+    {
+        instrument->lookuptime += dae_get_time() - t;
+        ++instrument->numattribs;
+    }
+#endif
     if(def != NULL)
     {
         obj = dae_add_obj(
@@ -917,6 +1857,10 @@ dae_obj_ptr dae_add_element(
     const dae_obj_memberdef* el = NULL;
     const dae_obj_typedef* def = NULL;
     dae_obj_ptr obj = NULL;
+#ifdef DAE_INSTRUMENT
+    dae_instrument* instrument = dae_get_instrument(parenthdr);
+    double t = dae_get_time();
+#endif
     if(parentdef!=NULL && (parentdef->flags&dae_XSD_ANY)==0)
     {
         // predefined content type
@@ -939,6 +1883,13 @@ dae_obj_ptr dae_add_element(
         // any element content is allowed
         def = dae_find_type(name);
     }
+#ifdef DAE_INSTRUMENT
+    if(instrument != NULL)
+    {
+        instrument->lookuptime += dae_get_time() - t;
+        ++instrument->numelements;
+    }
+#endif
     if(parentdef == NULL || parentdef->datamax == 0)
     {
         obj = dae_add_obj(
@@ -956,11 +1907,195 @@ dae_obj_ptr dae_add_element(
     return obj;
 }
 
+//****************************************************************************
+int dae_attach(
+    dae_obj_ptr parent,
+    dae_obj_ptr obj)
+{
+    dae_obj_header* parenthdr = dae_GET_HEADER(parent);
+    dae_obj_header* hdr = dae_GET_HEADER(obj);
+    const dae_obj_typedef* parentdef = parenthdr->def;
+    const dae_allocator* allocator = hdr->allocator;
+    const dae_obj_memberdef* el = NULL;
+    const char* name = hdr->membername;
+    int err = 0;
+    if(hdr->parent != NULL || allocator != parenthdr->allocator)
+    {
+        // only a detached tree may be attached, and its memory must have
+        // come from the same hooks as the new parent's
+        err = -1;
+    }
+    else if(parentdef != NULL && parentdef->datamax != 0)
+    {
+        // the parent holds data rather than elements
+        err = -1;
+    }
+    else if(parentdef != NULL && (parentdef->flags&dae_XSD_ANY)==0)
+    {
+        // the element must match one of the parent's definitions, as it
+        // would have been given when added with dae_add_element
+        dae_obj_memberdef* elitr = parentdef->elems;
+        dae_obj_memberdef* elend = elitr + parentdef->numelems;
+        while(elitr != elend)
+        {
+            if(name != NULL && !strcmp(name, elitr->name))
+            {
+                el = elitr;
+                break;
+            }
+            ++elitr;
+        }
+        if(el != NULL)
+        {
+            err = (dae_get_type(el->objtypeid) == hdr->def) ? 0 : -1;
+        }
+        else
+        {
+            err = (hdr->def == NULL) ? 0 : -1;
+        }
+    }
+    if(err == 0)
+    {
+        if(el != NULL && hdr->memberdef == NULL)
+        {
+            dae_free(allocator, (char*) hdr->membername);
+            hdr->membername = el->name;
+        }
+        else if(el == NULL && hdr->memberdef != NULL)
+        {
+            // the name came from the old parent's definition
+            hdr->membername = dae_strdup(allocator, name);
+        }
+        dae_link_obj(parenthdr, &parenthdr->elems, el, hdr);
+    }
+    return err;
+}
+
+//****************************************************************************
+dae_obj_ptr dae_clone(
+    dae_obj_ptr obj,
+    const dae_allocator* allocator)
+{
+    const dae_obj_header* root = dae_GET_HEADER(obj);
+    const dae_obj_header* itr = root;
+    const dae_obj_header* srcparent = NULL;
+    dae_obj_header* dstparent = NULL;
+    dae_obj_header* dstroot = NULL;
+    if(allocator == NULL)
+    {
+        allocator = root->allocator;
+    }
+    // the source is walked depth first, so the parent of each object is
+    // either the previous object or one of its ancestors
+    while(itr != NULL)
+    {
+        dae_obj_header* dst = dae_clone_obj(allocator, itr);
+        const dae_obj_memberdef* memberdef = itr->memberdef;
+        if(itr == root)
+        {
+            // a cloned subtree starts out detached
+            dstroot = dst;
+            dst->memberdef = memberdef;
+        }
+        else
+        {
+            dae_obj_list* dstlist;
+            while(srcparent != itr->parent)
+            {
+                srcparent = srcparent->parent;
+                dstparent = dstparent->parent;
+            }
+            dstlist = (itr->parentlist == &srcparent->attribs) ?
+                &dstparent->attribs :
+                &dstparent->elems;
+            dae_link_obj(dstparent, dstlist, memberdef, dst);
+        }
+        if(memberdef != NULL)
+        {
+            dst->membername = memberdef->name;
+        }
+        else
+        {
+            dst->membername = dae_strdup(allocator, itr->membername);
+        }
+        srcparent = itr;
+        dstparent = dst;
+        itr = dae_get_next_in_tree(root, itr);
+    }
+    return dae_GET_PTR(dstroot);
+}
+
 //****************************************************************************
 dae_COLLADA* dae_create()
+{
+    return dae_create_ex(&dae_libc_allocator);
+}
+
+//****************************************************************************
+dae_COLLADA* dae_create_ex(
+    const dae_allocator* allocator)
 {
     const dae_obj_typedef* def = dae_get_type(dae_ID_COLLADA);
-    return (dae_COLLADA*) dae_create_obj(def);
+    return (dae_COLLADA*) dae_create_obj(allocator, def);
+}
+
+//****************************************************************************
+size_t dae_decode_hex(
+    const char* str,
+    size_t len,
+    unsigned char* bytes_out,
+    size_t* numchars_out)
+{
+    const char* itr = str;
+    const char* end = str + len;
+    const char* pair = NULL;
+    size_t n = 0;
+    int hi = -1;
+    while(itr != end)
+    {
+        int d;
+        if(hi < 0)
+        {
+            // whole runs of digits are decoded in blocks
+            size_t m = dae_decode_hex_blocks(itr, end - itr, bytes_out + n);
+            itr += m;
+            n += m/2;
+            if(itr == end)
+            {
+                break;
+            }
+        }
+        d = dae_get_hex_digit(*itr);
+        if(d >= 0)
+        {
+            if(hi < 0)
+            {
+                hi = d;
+                pair = itr;
+            }
+            else
+            {
+                bytes_out[n] = (unsigned char) ((hi << 4) | d);
+                ++n;
+                hi = -1;
+            }
+        }
+        else if(!isspace(*itr))
+        {
+            break;
+        }
+        ++itr;
+    }
+    if(hi >= 0)
+    {
+        // an unpaired digit is not consumed
+        itr = pair;
+    }
+    if(numchars_out != NULL)
+    {
+        *numchars_out = (size_t) (itr - str);
+    }
+    return n;
 }
 
 //****************************************************************************
@@ -970,6 +2105,60 @@ void dae_destroy(
     dae_destroy_obj(dae_GET_HEADER(doc));
 }
 
+//****************************************************************************
+size_t dae_destroy_split(
+    dae_COLLADA* doc,
+    size_t mintrees,
+    dae_obj_ptr* subtrees_out)
+{
+    // a document often holds a few very large elements, such as one mesh
+    // or one visual scene, so the split goes one level deeper at a time
+    // until there are enough trees for the threads releasing them
+    dae_obj_header* root = dae_GET_HEADER(doc);
+    int depth = 2;
+    int deeper;
+    size_t n = dae_count_split_trees(root, depth, &deeper);
+    while(n < mintrees && deeper)
+    {
+        ++depth;
+        n = dae_count_split_trees(root, depth, &deeper);
+    }
+    if(subtrees_out != NULL)
+    {
+        dae_split_trees(root, depth, subtrees_out);
+        dae_destroy_obj(root);
+    }
+    return n;
+}
+
+//****************************************************************************
+void dae_destroy_subtree(
+    dae_obj_ptr subtree)
+{
+    dae_destroy_obj(dae_GET_HEADER(subtree));
+}
+
+//****************************************************************************
+int dae_detach(
+    dae_obj_ptr obj)
+{
+    dae_obj_header* hdr = dae_GET_HEADER(obj);
+    int err = -1;
+    if(hdr->parent != NULL && hdr->parentlist == &hdr->parent->elems)
+    {
+        dae_unlink_obj(hdr);
+        err = 0;
+    }
+    return err;
+}
+
+//****************************************************************************
+const dae_allocator* dae_get_allocator(
+    dae_obj_ptr obj)
+{
+    return dae_GET_HEADER(obj)->allocator;
+}
+
 //****************************************************************************
 size_t dae_get_data(
     dae_obj_ptr obj,
@@ -1017,6 +2206,65 @@ dae_obj_ptr dae_get_first_element(
     return (childhdr != NULL) ? dae_GET_PTR(childhdr) : NULL;
 }
 
+//****************************************************************************
+size_t dae_get_memory_stats(
+    dae_obj_ptr obj,
+    dae_memory_stats* stats_out,
+    size_t maxstats)
+{
+    const dae_obj_header* root = dae_GET_HEADER(obj);
+    const dae_obj_header* itr = root;
+    dae_obj_typedef* types;
+    unsigned numtypes;
+    size_t i;
+    dae_get_schema(&types, &numtypes);
+    // the entry after the schema types receives untyped elements
+    for(i = 0; i < maxstats && i <= numtypes; ++i)
+    {
+        memset(stats_out + i, 0, sizeof(*stats_out));
+        stats_out[i].type = (i < numtypes) ?
+            (dae_obj_typeid) i :
+            dae_ID_INVALID;
+    }
+    while(itr != NULL)
+    {
+        size_t index = numtypes;
+        if(itr->def != NULL)
+        {
+            index = (size_t) itr->def->objtypeid;
+        }
+        if(index < maxstats)
+        {
+            dae_count_obj_memory(itr, stats_out + index);
+        }
+        itr = dae_get_next_in_tree(root, itr);
+    }
+    return numtypes + 1;
+}
+
+//****************************************************************************
+size_t dae_get_mutable_data(
+    dae_obj_ptr obj,
+    dae_native_typeid* type_out,
+    void** data_out,
+    size_t* datalen_out)
+{
+    dae_obj_header* hdr = dae_GET_HEADER(obj);
+    const dae_obj_typedef* def = hdr->def;
+    if(def != NULL && def->datamax < 0 && def->datatypeid != dae_ID_STRING)
+    {
+        // take a private copy of a vector shared with clones
+        dae_obj_vector* vec;
+        vec = (dae_obj_vector*) (((ptrdiff_t) obj) + def->dataoffset);
+        dae_reserve_data(
+            hdr->allocator,
+            vec,
+            vec->size,
+            dae_get_native_size((dae_obj_typeid) def->datatypeid));
+    }
+    return dae_get_data(obj, type_out, data_out, datalen_out);
+}
+
 //****************************************************************************
 const char* dae_get_name(
     dae_obj_ptr obj)
@@ -1048,6 +2296,139 @@ dae_obj_typeid dae_get_typeid(
     return (def != NULL) ? (dae_obj_typeid) def->objtypeid : dae_ID_INVALID;
 }
 
+//****************************************************************************
+int dae_remove(
+    dae_obj_ptr obj)
+{
+    dae_obj_header* hdr = dae_GET_HEADER(obj);
+    int err = -1;
+    if(hdr->parent != NULL)
+    {
+        dae_unlink_obj(hdr);
+        dae_destroy_obj(hdr);
+        err = 0;
+    }
+    return err;
+}
+
+//****************************************************************************
+int dae_set_data(
+    dae_obj_ptr obj,
+    dae_native_typeid type,
+    const void* data,
+    size_t datalen)
+{
+    dae_obj_header* hdr = dae_GET_HEADER(obj);
+    const dae_obj_typedef* def = hdr->def;
+    size_t typesize;
+    void* p;
+    // strings are owned per word, so they only go through dae_set_string
+    if(def == NULL ||
+        def->datatypeid != (dae_obj_typeid) type ||
+        type == dae_NATIVE_STRING)
+    {
+        return -1;
+    }
+    typesize = dae_get_native_size((dae_obj_typeid) type);
+    p = (void*) (((ptrdiff_t) obj) + def->dataoffset);
+    if(def->datamax == -1)
+    {
+        dae_obj_vector* vec = (dae_obj_vector*) p;
+        if(vec->values != NULL &&
+            (datalen == 0 ||
+            dae_ATOMIC_LOAD(dae_GET_DATA_REFS(vec->values)) > 1))
+        {
+            // every value is replaced, so a vector shared with a clone is
+            // let go rather than copied
+            dae_release_data(hdr->allocator, vec->values);
+            vec->values = NULL;
+            vec->size = 0;
+        }
+        if(datalen > 0)
+        {
+            dae_reserve_data(hdr->allocator, vec, datalen, typesize);
+            memcpy(vec->values, data, datalen*typesize);
+        }
+        vec->size = datalen;
+    }
+    else if(datalen == (size_t) def->datamax)
+    {
+        // single value or fixed size array
+        memcpy(p, data, datalen*typesize);
+    }
+    else
+    {
+        return -1;
+    }
+    return 0;
+}
+
+//****************************************************************************
+int dae_set_hex(
+    dae_obj_ptr obj,
+    const unsigned char* bytes,
+    size_t numbytes)
+{
+    dae_obj_header* hdr = dae_GET_HEADER(obj);
+    const dae_obj_typedef* def = hdr->def;
+    void* p;
+    if(def == NULL || def->datatypeid != dae_NATIVE_HEX8)
+    {
+        return -1;
+    }
+    p = (void*) (((ptrdiff_t) obj) + def->dataoffset);
+    if(def->datamax == -1)
+    {
+        dae_obj_vector* vec = (dae_obj_vector*) p;
+        dae_reserve_data(hdr->allocator, vec, numbytes, 1);
+        memcpy(vec->values, bytes, numbytes);
+        vec->size = numbytes;
+    }
+    else
+    {
+        // single value or fixed size array
+        size_t max = (size_t) def->datamax;
+        memcpy(p, bytes, (numbytes < max) ? numbytes : max);
+    }
+    return 0;
+}
+
+//****************************************************************************
+int dae_set_instrument(
+    dae_obj_ptr obj,
+    dae_instrument* instrument)
+{
+#ifdef DAE_INSTRUMENT
+    dae_obj_header* root = dae_GET_HEADER(obj);
+    dae_obj_header* itr = root;
+    const dae_allocator* allocator = root->allocator;
+    const dae_instrument* prev = dae_get_instrument(root);
+    if(prev != NULL)
+    {
+        // never stack one instrument on top of another
+        allocator = prev->allocator;
+    }
+    if(instrument != NULL)
+    {
+        instrument->hooks.alloc = dae_instrument_alloc;
+        instrument->hooks.realloc = dae_instrument_realloc;
+        instrument->hooks.free = dae_instrument_free;
+        instrument->hooks.user = instrument;
+        instrument->allocator = allocator;
+        allocator = &instrument->hooks;
+    }
+    // objects added later inherit the hooks from their parents
+    while(itr != NULL)
+    {
+        itr->allocator = allocator;
+        itr = dae_get_next_in_tree(root, itr);
+    }
+    return 0;
+#else
+    return -1;
+#endif
+}
+
 //****************************************************************************
 void dae_set_string(
     dae_obj_ptr obj,
@@ -1055,9 +2436,15 @@ void dae_set_string(
 {
     dae_obj_header* hdr = dae_GET_HEADER(obj);
     const dae_obj_typedef* def = hdr->def;
+    const dae_allocator* allocator = hdr->allocator;
     dae_native_typeid datatype = dae_NATIVE_STRING;
     int dataoffset = -1;
     int max;
+#ifdef DAE_INSTRUMENT
+    dae_instrument* instrument = dae_get_instrument(hdr);
+    double alloctime = (instrument != NULL) ? instrument->alloctime : 0.0;
+    double t = dae_get_time();
+#endif
     if(def != NULL)
     {
         if(def->datatypeid != dae_ID_INVALID)
@@ -1088,10 +2475,18 @@ void dae_set_string(
             switch(datatype)
             {
             case dae_NATIVE_BOOL32:
-                // TODO
+                dae_convert_string_bools(data, (int*) p, 1);
                 break;
             case dae_NATIVE_HEX8:
-                // TODO
+                {
+                    // the first two digits form the byte
+                    size_t len = 0;
+                    while(len < 2 && data[len] != '\0')
+                    {
+                        ++len;
+                    }
+                    dae_decode_hex(data, len, (unsigned char*) p, NULL);
+                }
                 break;
             case dae_NATIVE_FLOAT:
                 {
@@ -1135,7 +2530,6 @@ void dae_set_string(
                 break;
             case dae_NATIVE_STRING:
                 {
-                    // TODO: free old pointer?
                     size_t len = 0;
                     // trim trailing space
                     while(data[len] != '\0' && !isspace(data[len]))
@@ -1145,9 +2539,11 @@ void dae_set_string(
                     if(len > 0)
                     {
                         char** sp = (char**) p;
-                        char* dup = (char*) malloc(len + 1);
+                        char* dup = (char*) dae_alloc(allocator, len + 1);
                         memcpy(dup, data, len);
                         dup[len] = '\0';
+                        // the previous value is owned by the object
+                        dae_free(allocator, *sp);
                         *sp = dup;
                     }
                 }
@@ -1184,22 +2580,46 @@ void dae_set_string(
             switch(datatype)
             {
             case dae_NATIVE_BOOL32:
-                // TODO
+                {
+                    size_t n = dae_count_string_bools(data);
+                    if(n > 0)
+                    {
+                        int* bv = (int*) dae_reserve_data(
+                            allocator,
+                            vec,
+                            n,
+                            sizeof(*bv));
+                        vec->size = dae_convert_string_bools(data, bv, n);
+                    }
+                }
                 break;
             case dae_NATIVE_HEX8:
-                // TODO
+                {
+                    // sized for every character being a digit, which skips
+                    // a separate counting pass over large payloads
+                    size_t len = strlen(data);
+                    size_t n = len/2;
+                    if(n > 0)
+                    {
+                        unsigned char* hv = (unsigned char*) dae_reserve_data(
+                            allocator,
+                            vec,
+                            n,
+                            sizeof(*hv));
+                        vec->size = dae_decode_hex(data, len, hv, NULL);
+                    }
+                }
                 break;
             case dae_NATIVE_FLOAT:
                 {
                     size_t n = dae_count_string_floats(data);
                     if(n > 0)
                     {
-                        float* fv = (float*) vec->values;
-                        if(n > vec->size)
-                        {
-                            fv = (float*) realloc(fv, n*sizeof(*fv));
-                            vec->values = fv;
-                        }
+                        float* fv = (float*) dae_reserve_data(
+                            allocator,
+                            vec,
+                            n,
+                            sizeof(*fv));
                         vec->size = dae_convert_string_floats(data, fv);
                     }
                 }
@@ -1209,12 +2629,11 @@ void dae_set_string(
                     size_t n = dae_count_string_int8s(data);
                     if(n > 0)
                     {
-                        char* iv = (char*) vec->values;
-                        if(n > vec->size)
-                        {
-                            iv = (char*) realloc(iv, n*sizeof(*iv));
-                            vec->values = iv;
-                        }
+                        char* iv = (char*) dae_reserve_data(
+                            allocator,
+                            vec,
+                            n,
+                            sizeof(*iv));
                         vec->size = dae_convert_string_int8s(data, iv);
                     }
                 }
@@ -1224,12 +2643,11 @@ void dae_set_string(
                     size_t n = dae_count_string_int16s(data);
                     if(n > 0)
                     {
-                        short* iv = (short*) vec->values;
-                        if(n > vec->size)
-                        {
-                            iv = (short*) realloc(iv, n*sizeof(*iv));
-                            vec->values = iv;
-                        } 
+                        short* iv = (short*) dae_reserve_data(
+                            allocator,
+                            vec,
+                            n,
+                            sizeof(*iv));
                         vec->size = dae_convert_string_int16s(data, iv);
                     }
                 }
@@ -1239,12 +2657,11 @@ void dae_set_string(
                     size_t n = dae_count_string_int32s(data);
                     if(n > 0)
                     {
-                        int* iv = (int*) vec->values;
-                        if(n > vec->size)
-                        {
-                            iv = (int*) realloc(iv, n*sizeof(*iv));
-                            vec->values = iv;
-                        }
+                        int* iv = (int*) dae_reserve_data(
+                            allocator,
+                            vec,
+                            n,
+                            sizeof(*iv));
                         vec->size = dae_convert_string_int32s(data, iv);
                     }
                 }
@@ -1254,14 +2671,25 @@ void dae_set_string(
                     size_t n = dae_count_string_words(data);
                     if(n > 0)
                     {
-                        // TODO: free old pointers?
                         char** sv = (char**) vec->values;
+                        size_t i;
+                        // the previous words are owned by the object
+                        for(i = 0; i < vec->size; ++i)
+                        {
+                            dae_free(allocator, sv[i]);
+                        }
                         if(n > vec->size)
                         {
-                            sv = (char**) realloc(sv, n*sizeof(*sv));
+                            sv = (char**) dae_realloc(
+                                allocator,
+                                sv,
+                                n*sizeof(*sv));
                             vec->values = sv;
                         }
-                        vec->size = dae_convert_string_words(data, sv);
+                        vec->size = dae_convert_string_words(
+                            allocator,
+                            data,
+                            sv);
                     }
                 }
                 break;
@@ -1270,12 +2698,11 @@ void dae_set_string(
                     size_t n = dae_count_string_uint8s(data);
                     if(n > 0)
                     {
-                        unsigned char* iv = (unsigned char*) vec->values;
-                        if(n > vec->size)
-                        {
-                            iv = (unsigned char*) realloc(iv, n*sizeof(*iv));
-                            vec->values = iv;
-                        }
+                        unsigned char* iv = (unsigned char*) dae_reserve_data(
+                            allocator,
+                            vec,
+                            n,
+                            sizeof(*iv));
                         vec->size = dae_convert_string_uint8s(data, iv);
                     }
                 }
@@ -1285,12 +2712,11 @@ void dae_set_string(
                     size_t n = dae_count_string_uint32s(data);
                     if(n > 0)
                     {
-                        unsigned* iv = (unsigned*) vec->values;
-                        if(n > vec->size)
-                        {
-                            iv = (unsigned*) realloc(iv, n*sizeof(*iv));
-                            vec->values = iv;
-                        }
+                        unsigned* iv = (unsigned*) dae_reserve_data(
+                            allocator,
+                            vec,
+                            n,
+                            sizeof(*iv));
                         vec->size = dae_convert_string_uint32s(data, iv);
                     }
                 }
@@ -1307,10 +2733,24 @@ void dae_set_string(
             switch(datatype)
             {
             case dae_NATIVE_BOOL32:
-                // TODO
+                {
+                    int n = dae_count_string_bools(data);
+                    if(n == max)
+                    {
+                        int* bv = (int*) ar;
+                        dae_convert_string_bools(data, bv, max);
+                    }
+                }
                 break;
             case dae_NATIVE_HEX8:
-                // TODO
+                {
+                    int n = dae_count_string_hex8s(data);
+                    if(n == max)
+                    {
+                        unsigned char* hv = (unsigned char*) ar;
+                        dae_decode_hex(data, strlen(data), hv, NULL);
+                    }
+                }
                 break;
             case dae_NATIVE_FLOAT:
                 {
@@ -1357,9 +2797,14 @@ void dae_set_string(
                     int n = dae_count_string_words(data);
                     if(n == max)
                     {
-                        // TODO: free old pointers?
                         char** sv = (char**) ar;
-                        dae_convert_string_words(data, sv);
+                        int i;
+                        // the previous words are owned by the object
+                        for(i = 0; i < max; ++i)
+                        {
+                            dae_free(allocator, sv[i]);
+                        }
+                        dae_convert_string_words(allocator, data, sv);
                     }
                 }
                 break;
@@ -1389,4 +2834,13 @@ void dae_set_string(
             }
         }
     }
+#ifdef DAE_INSTRUMENT
+    if(instrument != NULL && dataoffset >= 0)
+    {
+        // allocations made while converting are reported separately
+        double dt = dae_get_time() - t;
+        instrument->converttime += dt - (instrument->alloctime - alloctime);
+        instrument->convertbytes[datatype] += strlen(data);
+    }
+#endif
 }
@@ -51,6 +51,9 @@ enum dae_native_typeid_e
     dae_NATIVE_UINT32 = dae_ID_UNSIGNEDINT
 };
 
+/// number of native types, for arrays indexed by dae_native_typeid
+#define dae_NUM_NATIVE_TYPES (dae_NATIVE_UINT32 + 1)
+
 //****************************************************************************
 // typedefs
 
@@ -59,6 +62,10 @@ typedef enum dae_obj_typeid_e dae_obj_typeid;
 
 typedef void* dae_obj_ptr;
 
+typedef struct dae_allocator_s dae_allocator;
+typedef struct dae_instrument_s dae_instrument;
+typedef struct dae_memory_stats_s dae_memory_stats;
+
 /*GEN_TYPEDEFS_BGN*/
 typedef struct dae_COLLADA_S dae_COLLADA;
 /*GEN_TYPEDEFS_END*/
@@ -66,6 +73,71 @@ typedef struct dae_COLLADA_S dae_COLLADA;
 //****************************************************************************
 // structs
 
+/**
+ * @details Memory hooks for a document. Every object, vector and string the
+ * document allocates is requested through them.
+ */
+struct dae_allocator_s
+{
+    /// returns a block of at least size bytes
+    void* (*alloc)(void* user, size_t size);
+    /// resizes a block returned by alloc or realloc
+    void* (*realloc)(void* user, void* ptr, size_t size);
+    /// releases a block returned by alloc or realloc
+    void (*free)(void* user, void* ptr);
+    /// passed through to each hook
+    void* user;
+};
+
+/**
+ * @details Memory held by the objects of one type. Vector bytes are the
+ * element count times the element size, so they do not include spare
+ * capacity or the allocator's own bookkeeping.
+ */
+struct dae_memory_stats_s
+{
+    /// the type, or dae_ID_INVALID for elements with no schema type
+    dae_obj_typeid type;
+    /// number of objects
+    size_t count;
+    /// bytes of the headers that link objects into the tree
+    size_t headerbytes;
+    /// bytes of the typed structs that follow the headers
+    size_t structbytes;
+    /// bytes of child pointer vectors and data vectors. A numeric data vector
+    /// shared with clones is split evenly between the objects sharing it
+    size_t vectorbytes;
+    /// bytes of strings, including terminators
+    size_t stringbytes;
+};
+
+/**
+ * @details Counters gathered while a document is built. They are only
+ * updated when the library is compiled with DAE_INSTRUMENT defined;
+ * otherwise the code that updates them is compiled out.
+ */
+struct dae_instrument_s
+{
+    /// seconds spent matching names to member and type definitions
+    double lookuptime;
+    /// seconds spent converting text to native data, excluding allocation
+    double converttime;
+    /// seconds spent in the allocator hooks
+    double alloctime;
+    /// number of elements added
+    size_t numelements;
+    /// number of attributes added
+    size_t numattribs;
+    /// number of alloc and realloc calls
+    size_t numallocs;
+    /// bytes of text converted, indexed by dae_native_typeid
+    size_t convertbytes[dae_NUM_NATIVE_TYPES];
+    /// used internally to time the document's allocator
+    dae_allocator hooks;
+    /// used internally to time the document's allocator
+    const dae_allocator* allocator;
+};
+
 /*GEN_STRUCTS_BGN*/
 /*GEN_STRUCTS_END*/
 
@@ -85,11 +157,133 @@ dae_obj_ptr dae_add_element(
     dae_obj_ptr parent,
     const char* name);
 
+/**
+ * @details Appends a tree detached with dae_detach as the last element of a
+ * new parent, which may be in another document. Nothing is copied, so the
+ * tree and the new parent must use the same memory hooks. The element is
+ * matched against the definition of the parent by name, as in
+ * dae_add_element.
+ * @param parent the new parent
+ * @param obj the detached element
+ * @return 0 on success, -1 if the element is still attached, uses other
+ *         hooks, or its type does not fit the parent
+ */
+int dae_attach(
+    dae_obj_ptr parent,
+    dae_obj_ptr obj);
+
+/**
+ * @details Copies an object and everything below it in a single pass. Names
+ * taken from the schema are shared rather than copied. Numeric data vectors
+ * are shared with the copy when it uses the same memory hooks, and copied in
+ * bulk otherwise. Shared vectors must only be written through
+ * dae_get_mutable_data or replaced with dae_set_string or dae_set_hex, which
+ * copy them first. The copy of a document is a new document, while the copy
+ * of any other object is detached, to be attached with dae_attach or
+ * released with dae_destroy_subtree.
+ * @param obj the document or object to copy
+ * @param allocator the memory hooks of the copy. If NULL, the hooks of the
+ *        source are used
+ * @return the copy
+ */
+dae_obj_ptr dae_clone(
+    dae_obj_ptr obj,
+    const dae_allocator* allocator);
+
+/**
+ * @details Creates an empty document. Distinct documents may be created,
+ * built and destroyed on different threads at the same time. A document that
+ * is no longer being modified may be read from any number of threads, but
+ * a document being modified must not be accessed by other threads.
+ * @return the new document
+ */
 dae_COLLADA* dae_create();
 
+/**
+ * @details Creates an empty document that routes all of its memory, and the
+ * memory of everything added to it, through the given hooks. dae_create uses
+ * the C runtime's malloc, realloc and free.
+ * @param allocator the memory hooks. They are referenced rather than copied,
+ *        so they must remain valid until the document is destroyed
+ * @return the new document
+ */
+dae_COLLADA* dae_create_ex(
+    const dae_allocator* allocator);
+
+/**
+ * @details Decodes hex binary text into bytes. Whitespace between digits is
+ * skipped, and decoding stops at the first character that is neither. Runs
+ * of digits are decoded 16 at a time with SSE2 where it is available. A
+ * trailing unpaired digit is not consumed, so text that arrives in pieces
+ * can be decoded as it streams in.
+ * @param str the text to decode
+ * @param len the number of characters in str
+ * @param bytes_out buffer that receives the bytes. It must hold at least
+ *        len/2 bytes
+ * @param numchars_out if not NULL, receives the number of characters
+ *        consumed
+ * @return the number of bytes decoded
+ */
+size_t dae_decode_hex(
+    const char* str,
+    size_t len,
+    unsigned char* bytes_out,
+    size_t* numchars_out);
+
 void dae_destroy(
     dae_COLLADA* doc);
 
+/**
+ * @details Splits a document into separate trees so that it can be torn
+ * down in parallel. Every element down to a split depth is unlinked as a
+ * tree of its own. Elements above that depth are left empty, and those at
+ * it keep everything below them. The depth starts at two, the children of
+ * the top level elements, and grows one level at a time while there are
+ * fewer than mintrees trees and deeper elements remain. The root and its
+ * attributes are then destroyed. The trees do not share any memory, so
+ * distinct trees may be released with dae_destroy_subtree on different
+ * threads at the same time, as long as the document's memory hooks are
+ * thread safe. This does not hold for instrumented documents, whose
+ * counters are not atomic.
+ * @param doc the document
+ * @param mintrees the number of trees to split into if the document is deep
+ *        enough, such as a few per thread
+ * @param subtrees_out array that receives the trees. If NULL, the number of
+ *        trees is returned and the document is left untouched
+ * @return the number of trees
+ */
+size_t dae_destroy_split(
+    dae_COLLADA* doc,
+    size_t mintrees,
+    dae_obj_ptr* subtrees_out);
+
+/**
+ * @details Destroys a tree returned by dae_destroy_split or detached with
+ * dae_detach.
+ */
+void dae_destroy_subtree(
+    dae_obj_ptr subtree);
+
+/**
+ * @details Unlinks an element and everything below it from its parent in
+ * constant time. If the element was held in a vector of the parent's
+ * struct, the vector is compacted, which shifts the later elements down by
+ * one. The detached tree keeps the hooks of its document, and must be
+ * attached to a parent with dae_attach or released with dae_destroy_subtree.
+ * @param obj the element to detach
+ * @return 0 on success, -1 if obj is an attribute or has no parent
+ */
+int dae_detach(
+    dae_obj_ptr obj);
+
+/**
+ * @details Gets the memory hooks used by the document that owns an object.
+ * @param obj any object in the document
+ * @return the hooks passed to dae_create_ex
+ */
+const dae_allocator* dae_get_allocator(
+    dae_obj_ptr obj);
+
 size_t dae_get_data(
     dae_obj_ptr obj,
     dae_native_typeid* type_out,
@@ -102,6 +296,35 @@ dae_obj_ptr dae_get_first_attrib(
 dae_obj_ptr dae_get_first_element(
     dae_obj_ptr obj);
 
+/**
+ * @details Reports the memory held by an object and everything under it,
+ * broken down by type. Entry i describes type id i and the last entry
+ * describes elements with no schema type. The tree is walked without
+ * allocating, so it is safe to call on every load. A data vector shared with
+ * clones is counted in equal parts by each object that shares it, so
+ * measuring every document that shares it counts the vector once.
+ * @param obj the root of the subtree to measure
+ * @param stats_out array receiving one entry per type. May be NULL if
+ *        maxstats is 0
+ * @param maxstats the number of entries stats_out can hold
+ * @return the number of entries needed to describe every type
+ */
+size_t dae_get_memory_stats(
+    dae_obj_ptr obj,
+    dae_memory_stats* stats_out,
+    size_t maxstats);
+
+/**
+ * @details Gets the data of an object, as dae_get_data, for writing. If the
+ * object shares a numeric vector with a clone, the object is given its own
+ * copy first, so writes do not show through to other objects.
+ */
+size_t dae_get_mutable_data(
+    dae_obj_ptr obj,
+    dae_native_typeid* type_out,
+    void** data_out,
+    size_t* datalen_out);
+
 const char* dae_get_name(
     dae_obj_ptr obj);
 
@@ -114,6 +337,61 @@ dae_obj_ptr dae_get_parent(
 dae_obj_typeid dae_get_typeid(
     dae_obj_ptr obj);
 
+/**
+ * @details Unlinks an element or attribute from its parent, as dae_detach,
+ * and destroys it along with everything below it.
+ * @param obj the object to remove
+ * @return 0 on success, -1 if obj has no parent
+ */
+int dae_remove(
+    dae_obj_ptr obj);
+
+/**
+ * @details Sets the data of an element with numeric content, such as a
+ * float_array, from values that are already in their native form, without
+ * a round trip through text.
+ * @param obj the element to set
+ * @param type the type of the values, which must match the native type of
+ *        the element's data
+ * @param data the values
+ * @param datalen the number of values. Elements with a fixed number of
+ *        values must be given exactly that many
+ * @return 0 on success, -1 if the element does not hold numeric data of
+ *         the given type or datalen does not fit
+ */
+int dae_set_data(
+    dae_obj_ptr obj,
+    dae_native_typeid type,
+    const void* data,
+    size_t datalen);
+
+/**
+ * @details Sets the binary data of an element with hex binary content, such
+ * as an image hex element, without a round trip through text.
+ * @param obj the element to set
+ * @param bytes the decoded bytes
+ * @param numbytes the number of bytes
+ * @return 0 on success, -1 if the element does not hold hex binary data
+ */
+int dae_set_hex(
+    dae_obj_ptr obj,
+    const unsigned char* bytes,
+    size_t numbytes);
+
+/**
+ * @details Directs the counters of an object and everything under it,
+ * including objects added later, to an instrument. The counters are added
+ * to, so the instrument should be zeroed first.
+ * @param obj the root of the subtree to instrument, usually the document
+ * @param instrument the counters. They must remain valid until they are
+ *        detached by passing NULL or the objects are destroyed
+ * @return 0 on success, -1 if the library was compiled without
+ *         DAE_INSTRUMENT
+ */
+int dae_set_instrument(
+    dae_obj_ptr obj,
+    dae_instrument* instrument);
+
 void dae_set_string(
     dae_obj_ptr obj,
     const char* data);
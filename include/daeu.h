@@ -12,20 +12,636 @@
 
 #include "dae.h"
 
+typedef struct daeu_anim_s daeu_anim;
+typedef struct daeu_anim_clip_s daeu_anim_clip;
+typedef struct daeu_anim_track_s daeu_anim_track;
+typedef struct daeu_destroy_job_s* daeu_destroy_job;
+typedef struct daeu_geometry_mesh_s daeu_geometry_mesh;
+typedef struct daeu_mesh_s daeu_mesh;
+typedef struct daeu_mesh_attrib_s daeu_mesh_attrib;
+typedef struct daeu_mesh_group_s daeu_mesh_group;
+typedef struct daeu_morph_s daeu_morph;
+typedef struct daeu_scene_s daeu_scene;
+typedef struct daeu_skin_s daeu_skin;
+typedef struct daeu_tris_s daeu_tris;
+typedef struct daeu_xml_driver_s daeu_xml_driver;
+typedef struct daeu_xml_load_result_s daeu_xml_load_result;
 typedef struct daeu_xml_parser_s* daeu_xml_parser;
+typedef struct daeu_xml_stats_s daeu_xml_stats;
+
+enum daeu_anim_interp_e
+{
+    daeu_ANIM_STEP,
+    daeu_ANIM_LINEAR,
+    /// HERMITE and CARDINAL keys are converted to BEZIER when compiled
+    daeu_ANIM_BEZIER
+};
+typedef enum daeu_anim_interp_e daeu_anim_interp;
+
+enum daeu_morph_method_e
+{
+    daeu_MORPH_NORMALIZED,
+    daeu_MORPH_RELATIVE
+};
+typedef enum daeu_morph_method_e daeu_morph_method;
+
+enum daeu_anim_behavior_e
+{
+    daeu_ANIM_CONSTANT,
+    daeu_ANIM_CYCLE,
+    daeu_ANIM_OSCILLATE
+};
+typedef enum daeu_anim_behavior_e daeu_anim_behavior;
+
+enum daeu_up_axis_e
+{
+    daeu_X_UP,
+    daeu_Y_UP,
+    daeu_Z_UP
+};
+typedef enum daeu_up_axis_e daeu_up_axis;
+
+struct daeu_anim_track_s
+{
+    /// the channel the track was compiled from
+    dae_channel_type* channel;
+    /// the element addressed by the channel target, NULL if unresolved
+    dae_obj_ptr targetobj;
+    /// the first float of the target written by the track, NULL if
+    /// unresolved. daeu_anim_apply updates it when the data moves
+    float* target;
+    /// index of the first float written by the track within the data of
+    /// targetobj
+    size_t targetoffset;
+    /// index of the first key of the track in the times and interps arrays
+    size_t firstkey;
+    size_t numkeys;
+    /// index of the first key value of the track in the values array
+    size_t firstvalue;
+    /// index of the first tangent of the track in the tangents array, or
+    /// (size_t) -1 if the track has no curved segments
+    size_t firsttangent;
+    /// offset of the track within the buffer filled by daeu_anim_evaluate
+    size_t output;
+    /// number of floats per key
+    unsigned stride;
+    daeu_anim_behavior prebehavior;
+    daeu_anim_behavior postbehavior;
+};
+
+struct daeu_anim_s
+{
+    /// key times, numkeys entries per track
+    float* times;
+    /// interpolation of the segment beginning at each key
+    unsigned char* interps;
+    /// key values, stride floats per key
+    float* values;
+    /// bezier control points of the segment beginning at each key, four
+    /// floats per key value: the normalized times and the values of the
+    /// outgoing and incoming control points
+    float* tangents;
+    daeu_anim_track* tracks;
+    /// cached key index of each track, used by the evaluator
+    size_t* cursors;
+    size_t numtracks;
+    size_t numkeys;
+    size_t numvalues;
+    size_t numtangents;
+    /// number of floats written by daeu_anim_evaluate
+    size_t numoutputs;
+    /// earliest and latest key time of all tracks
+    float start;
+    float end;
+};
+
+struct daeu_mesh_attrib_s
+{
+    /// input semantic to gather, such as "POSITION", "NORMAL" or "TEXCOORD"
+    const char* semantic;
+    /// input set to match, or -1 to match the first input with the semantic
+    int set;
+    /// offset of the attribute within an interleaved vertex, in floats
+    unsigned offset;
+    /// number of floats in the attribute, 0 if no input matched
+    unsigned size;
+};
+
+struct daeu_mesh_group_s
+{
+    /// material symbol of the source primitive element, may be NULL
+    const char* material;
+    /// offset of the first index of the group within the index buffer
+    size_t firstindex;
+    /// number of indices in the group
+    size_t numindices;
+};
+
+struct daeu_mesh_s
+{
+    /// interleaved vertex buffer, vertexsize floats per vertex
+    float* vertices;
+    /// triangle list indices into the vertex buffer
+    unsigned* indices;
+    /// one entry per requested attribute, with offset and size resolved
+    daeu_mesh_attrib* attribs;
+    /// one entry per source primitive element
+    daeu_mesh_group* groups;
+    /// source index each attribute of each vertex was gathered from,
+    /// numattribs per vertex. The index of a position is the index used by
+    /// skin weights and morph targets
+    unsigned* sources;
+    size_t numvertices;
+    size_t numindices;
+    size_t numattribs;
+    size_t numgroups;
+    /// number of floats in a single interleaved vertex
+    unsigned vertexsize;
+};
+
+struct daeu_anim_clip_s
+{
+    /// frame major samples, framesize floats per frame. NULL if quantized
+    float* samples;
+    /// frame major samples, framesize values per frame. NULL unless quantized
+    unsigned short* quantized;
+    /// the range of each track of a quantized clip as (min, scale) pairs, so
+    /// that a value is min + quantized*scale. NULL unless quantized
+    float* ranges;
+    size_t numframes;
+    /// values per frame, each track stored at its output offset
+    size_t framesize;
+    /// time of the first frame
+    float start;
+    /// frames per second
+    float rate;
+};
+
+struct daeu_geometry_mesh_s
+{
+    /// the geometry the mesh was compiled from
+    dae_geometry_type* geometry;
+    /// the compiled buffers, empty if err is nonzero
+    daeu_mesh mesh;
+    /// the result of daeu_mesh_compile for this geometry
+    int err;
+};
+
+struct daeu_morph_s
+{
+    /// the geometry being morphed, NULL if unresolved
+    dae_geometry_type* base;
+    /// the target geometries, NULL entries if unresolved
+    dae_geometry_type** targets;
+    /// the default weight of each target
+    float* weights;
+    size_t numtargets;
+    daeu_morph_method method;
+};
+
+struct daeu_scene_s
+{
+    /// nodes in breadth first order, so parents precede their children
+    dae_node_type** nodes;
+    /// index of the parent of each node, or -1 for the root nodes
+    int* parents;
+    /// local transform of each node, 16 floats per node, 64 byte aligned
+    float* local;
+    /// world transform of each node, 16 floats per node, 64 byte aligned
+    float* world;
+    size_t numnodes;
+};
+
+struct daeu_skin_s
+{
+    /// bind shape matrix, row major
+    float bindshape[16];
+    /// inverse bind matrix of each joint, 16 floats per joint, 64 byte
+    /// aligned
+    float* invbind;
+    /// name of each joint, as given by the joints source
+    const char** jointnames;
+    /// index of each joint's node within the scene, or -1 if unresolved
+    int* jointnodes;
+    /// joint indices, influences per vertex, 64 byte aligned
+    unsigned short* indices;
+    /// joint weights, influences per vertex, 64 byte aligned. The weights of
+    /// a vertex sum to one, unless it has no influences at all
+    float* weights;
+    size_t numjoints;
+    /// number of vertices, matching the positions of the skinned mesh
+    size_t numvertices;
+    /// number of influences per vertex
+    unsigned influences;
+};
+
+struct daeu_tris_s
+{
+    /// index tuples of the triangle corners, tuplesize indices per corner
+    unsigned* indices;
+    /// number of triangles, the indices array holds numtris*3 tuples
+    size_t numtris;
+    /// number of indices per corner, one more than the largest input offset
+    unsigned tuplesize;
+};
+
+struct daeu_xml_stats_s
+{
+    /// seconds between callbacks, spent in the xml tokenizer or in the
+    /// application between pieces of a streamed document
+    double tokenizetime;
+    /// seconds spent inside the callbacks
+    double handlertime;
+    /// number of start element, end element and character data callbacks
+    size_t numcallbacks;
+    /// counters gathered by the document while it was built
+    dae_instrument document;
+};
+
+/**
+ * @details Glue between daeu_xml_load_batch and a SAX parser. Each worker
+ * thread creates one tokenizer and reuses it for every file it loads.
+ */
+struct daeu_xml_driver_s
+{
+    /// returns a new tokenizer, or NULL on failure
+    void* (*create)(void* user);
+    /// parses size bytes of xml, passing the daeu_xml callbacks the given
+    /// parser as their userdata. Returns 0 on success, nonzero on failure
+    int (*parse)(
+        void* user,
+        void* tokenizer,
+        daeu_xml_parser parser,
+        const char* data,
+        size_t size);
+    /// releases a tokenizer returned by create
+    void (*destroy)(void* user, void* tokenizer);
+    /// passed through to each function
+    void* user;
+};
+
+struct daeu_xml_load_result_s
+{
+    /// the loaded document, NULL if err is nonzero
+    dae_COLLADA* doc;
+    /// size of the file in bytes
+    size_t size;
+    /// seconds spent opening and mapping the file and its binary sidecars
+    double readtime;
+    /// seconds spent parsing the file into the document
+    double parsetime;
+    /// counters of the parse, zeroed unless the library is compiled with
+    /// DAE_INSTRUMENT
+    daeu_xml_stats stats;
+    /// 0 on success, -1 if the file or a binary sidecar it refers to could
+    /// not be read or the tokenizer could not be created, otherwise the
+    /// result of the driver's parse
+    int err;
+};
 
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
 
+/**
+ * @details Evaluates every track at the given time, as daeu_anim_evaluate,
+ * and writes the values to the channel targets in the document. Tracks with
+ * unresolved targets are skipped. A target whose values are shared with a
+ * clone is given its own copy before it is written, so the clone keeps its
+ * values.
+ */
+void daeu_anim_apply(
+    daeu_anim* anim,
+    float t);
+
+/**
+ * @details Compiles the samplers of every channel of every animation in a
+ * document into contiguous tracks. Key times, interpolations and values are
+ * stored in separate arrays, and the control points of curved segments are
+ * computed once here rather than at every evaluation. Channel targets are
+ * resolved to the addressed float data of the document elements, so the
+ * document must outlive the compiled animation. BSPLINE keys are evaluated
+ * as LINEAR.
+ * @param anim_out out param that will be filled with the compiled tracks. It
+ *        must be released with daeu_anim_destroy
+ * @return 0 if every channel was compiled and resolved, -1 if any channel
+ *         was skipped because of an invalid sampler or left unresolved
+ */
+int daeu_anim_compile(
+    dae_COLLADA* doc,
+    daeu_anim* anim_out);
+
+/**
+ * @details Resamples every track of a compiled animation at a fixed rate,
+ * from the start of the animation through its end. Tracks are independent,
+ * so they are distributed across a work stealing thread pool, each sampling
+ * with its own key cursor. Quantized clips store each value in 16 bits,
+ * relative to the range of its track.
+ * @param rate frames per second
+ * @param quantize nonzero to quantize the samples
+ * @param numthreads the number of threads to use, including the calling
+ *        thread. If less than 1, one thread per processor is used
+ * @param clip_out out param that will be filled with the baked frames. It
+ *        must be released with daeu_anim_clip_destroy
+ * @return 0 on success, -1 if the rate was not positive
+ */
+int daeu_anim_bake(
+    const daeu_anim* anim,
+    float rate,
+    int quantize,
+    int numthreads,
+    daeu_anim_clip* clip_out);
+
+void daeu_anim_clip_destroy(
+    daeu_anim_clip* clip);
+
+void daeu_anim_destroy(
+    daeu_anim* anim);
+
+/**
+ * @details Fills the arrays of a document whose values are kept in binary
+ * sidecar files, as written by daeu_binary_store. A source refers to its
+ * sidecar from a technique with the profile "libdae":
+ *
+ *     <technique profile="libdae">
+ *       <binary_array source="#positions-array" file="scan.bin"
+ *         offset="0" count="300000"/>
+ *     </technique>
+ *
+ * The offset is in bytes and the values are little endian, in the native
+ * type of the float_array or int_array named by source. Each file is memory
+ * mapped and the values are copied into the array without going through
+ * text. daeu_xml_load_batch calls this for every document it loads.
+ * @param path the path of the document, which relative file names are
+ *        resolved against
+ * @return 0 on success, -1 if any reference could not be resolved or read
+ */
+int daeu_binary_load(
+    dae_COLLADA* doc,
+    const char* path);
+
+/**
+ * @details Moves the values of every float_array and int_array with an id
+ * and at least minvalues values into a binary sidecar file, and adds the
+ * references described in daeu_binary_load to their sources. The arrays are
+ * left empty with their count attributes intact, so a document written out
+ * afterwards only holds the references. The document is not changed if the
+ * file cannot be written.
+ * @param path the sidecar file to create. The references name it without
+ *        its directory, so it must be next to the document
+ * @param minvalues arrays with fewer values stay in the document
+ * @return the number of arrays moved, or -1 if the file could not be written
+ */
+int daeu_binary_store(
+    dae_COLLADA* doc,
+    const char* path,
+    size_t minvalues);
+
+/**
+ * @details Samples every track at the given time. Each track caches the key
+ * it last sampled, so playback that moves forward or backward by small
+ * steps finds its keys without a search. Because of the cache, a compiled
+ * animation must not be evaluated by several threads at once.
+ * @param values_out array of numoutputs floats that will be filled with the
+ *        value of each track, at the track's output offset
+ */
+void daeu_anim_evaluate(
+    daeu_anim* anim,
+    float t,
+    float* values_out);
+
 void daeu_calc_transform_matrix(
     dae_obj_ptr obj,
     float* mtx_out);
 
+/**
+ * @details Removes duplicate sources and geometries from a document, as
+ * exporters often write the same arrays many times. Each candidate is
+ * hashed over the names and values of everything below it, including the
+ * numeric payload and the accessor layout, with the ids ignored and
+ * references inside the candidate compared by position. Candidates with the
+ * same hash are then compared in full. The first of each set of duplicates
+ * in document order is kept and the others are removed. Every anyURI,
+ * urifragment, IDREF_array and SIDREF value that named a removed element,
+ * or an element below it, is retargeted to the counterpart in the kept
+ * copy. Sources are only merged with sources of the same parent element,
+ * because inputs are resolved within their parent. Elements without an id
+ * are left alone.
+ * @param numthreads the number of threads used to hash the payloads,
+ *        including the calling thread. If less than 1, one thread per
+ *        processor is used
+ * @return the number of elements removed
+ */
+size_t daeu_dedup(
+    dae_COLLADA* doc,
+    int numthreads);
+
+/**
+ * @details Destroys a document on a work stealing thread pool. The document
+ * is split with dae_destroy_split and its trees are released concurrently,
+ * so its memory hooks must be thread safe. Instrumented documents must be
+ * destroyed with dae_destroy instead.
+ * @param numthreads the number of threads to use, including the calling
+ *        thread. If less than 1, one thread per processor is used
+ */
+void daeu_destroy(
+    dae_COLLADA* doc,
+    int numthreads);
+
+/**
+ * @details Destroys a document with daeu_destroy on a background thread,
+ * and returns without waiting for it. If the thread cannot be created, the
+ * document is destroyed before returning. The document must not be accessed
+ * after the call.
+ * @param numthreads passed through to daeu_destroy
+ * @param job_out out param receiving the job, which must be passed to
+ *        daeu_destroy_wait
+ */
+void daeu_destroy_async(
+    dae_COLLADA* doc,
+    int numthreads,
+    daeu_destroy_job* job_out);
+
+/**
+ * @details Waits for a background teardown to finish and releases the job.
+ */
+void daeu_destroy_wait(
+    daeu_destroy_job job);
+
 void daeu_lookat_to_matrix(
     const dae_lookat_type* lookat,
     float* mtx_out);
 
+/**
+ * @details Resolves a hierarchy of row major 4x4 matrices in one forward
+ * pass, computing world[i] = world[parents[i]] * local[i]. Uses SSE or AVX
+ * when available, the latter selected at run time.
+ * @param parents the index of the parent of each matrix, or -1 for a root.
+ *        Parents must precede their children
+ * @param world out param receiving count matrices. It must not overlap local
+ */
+void daeu_matrix_compose_batch(
+    const int* parents,
+    const float* local,
+    float* world,
+    size_t count);
+
+/**
+ * @details Inverts count row major 4x4 matrices. Singular matrices produce
+ * non-finite values. Uses SSE or AVX when available, the latter selected at
+ * run time.
+ * @param out out param receiving count matrices. It may be the same array
+ *        as m
+ */
+void daeu_matrix_invert_batch(
+    const float* m,
+    float* out,
+    size_t count);
+
+/**
+ * @details Multiplies count pairs of row major 4x4 matrices, computing
+ * out[i] = a[i] * b[i]. Uses SSE or AVX when available, the latter selected
+ * at run time.
+ * @param out out param receiving count matrices. It may be the same array
+ *        as a or b
+ */
+void daeu_matrix_multiply_batch(
+    const float* a,
+    const float* b,
+    float* out,
+    size_t count);
+
+/**
+ * @details Moves the content of every library in src into the first library
+ * of the same name in dst, adding the library to dst if it has none. Before
+ * anything is moved, each id in src that is already used in dst is renamed
+ * by appending a numeric suffix, and every anyURI, urifragment, IDREF_array
+ * and SIDREF value in src that refers to a renamed id is rewritten to match.
+ * Ids are looked up in hash tables, so the cost is linear in the size of
+ * the two documents. The assets of the libraries, the scene and any other
+ * content outside the libraries stay in src, which must still be destroyed
+ * by the caller. Units and axes are not converted; see
+ * daeu_normalize_units. If the documents use different hooks, the moved
+ * elements are cloned into the hooks of dst. An element that the library
+ * of dst does not accept is left at the end of its library in src.
+ * @return the number of ids that were renamed
+ */
+size_t daeu_merge(
+    dae_COLLADA* dst,
+    dae_COLLADA* src);
+
+/**
+ * @details Compiles the polygonal primitives of a mesh into a single
+ * interleaved vertex buffer and a 32 bit index buffer. Primitive elements
+ * other than triangles are converted with daeu_triangulate, while lines and
+ * linestrips are ignored. Each corner of each
+ * triangle is identified by the tuple of source indices it references for
+ * the requested attributes, and identical tuples are welded into a single
+ * vertex using a hash table, so the output contains no duplicate vertices.
+ * Attributes are laid out in the order they were requested.
+ * @param attribs the semantics to gather. The offset and size fields are
+ *        ignored on input; the resolved values are written to the attribs
+ *        array of the output mesh
+ * @param mesh_out out param that will be filled with the compiled buffers.
+ *        It must be released with daeu_mesh_destroy
+ * @return 0 on success, -1 if the mesh contained no usable primitives
+ */
+int daeu_mesh_compile(
+    dae_mesh_type* mesh,
+    const daeu_mesh_attrib* attribs,
+    size_t numattribs,
+    daeu_mesh* mesh_out);
+
+/**
+ * @details Compiles the mesh of every geometry in every geometry library of
+ * a document with daeu_mesh_compile. Geometries are independent, so they
+ * are distributed across a work stealing thread pool, largest first, and
+ * each produces its own output buffers. The document is only read.
+ * @param numthreads the number of threads to use, including the calling
+ *        thread. If less than 1, one thread per processor is used
+ * @param meshes_out out param that will be filled with an array holding
+ *        one entry per geometry that has a mesh, in document order. It must
+ *        be released with daeu_mesh_destroy_all
+ * @return 0 if every mesh compiled, -1 if any entry has a nonzero err
+ */
+int daeu_mesh_compile_all(
+    dae_COLLADA* doc,
+    const daeu_mesh_attrib* attribs,
+    size_t numattribs,
+    int numthreads,
+    daeu_geometry_mesh** meshes_out,
+    size_t* nummeshes_out);
+
+void daeu_mesh_destroy(
+    daeu_mesh* mesh);
+
+void daeu_mesh_destroy_all(
+    daeu_geometry_mesh* meshes,
+    size_t nummeshes);
+
+/**
+ * @details Blends morph targets into a compiled vertex buffer. Every float of
+ * the interleaved vertices is blended, as
+ * base*(1 - sum(weights)) + sum(weights[i]*targets[i]) for NORMALIZED and
+ * base + sum(weights[i]*targets[i]) for RELATIVE. The buffer is split into
+ * ranges that are blended on a work stealing thread pool, using SSE or AVX
+ * when available.
+ * @param targets the compiled target meshes. They must share the vertex
+ *        layout of the base, as they do when compiled with the same
+ *        attributes from geometries with the same primitives
+ * @param numthreads the number of threads to use, including the calling
+ *        thread. If less than 1, one thread per processor is used
+ * @param vertices_out buffer of base->numvertices*base->vertexsize floats
+ *        that will receive the blended vertices
+ * @return 0 on success, -1 if a target layout differs from the base
+ */
+int daeu_morph_blend(
+    const daeu_mesh* base,
+    const daeu_mesh* targets,
+    const float* weights,
+    size_t numtargets,
+    daeu_morph_method method,
+    int numthreads,
+    float* vertices_out);
+
+/**
+ * @details Resolves the base geometry, target geometries, default weights
+ * and method of a morph controller.
+ * @param morph_out out param that will be filled with the morph. It must be
+ *        released with daeu_morph_destroy
+ * @return 0 on success, -1 if any geometry could not be resolved
+ */
+int daeu_morph_compile(
+    dae_COLLADA* doc,
+    dae_morph_type* morph,
+    daeu_morph* morph_out);
+
+void daeu_morph_destroy(
+    daeu_morph* morph);
+
+/**
+ * @details Converts a document in place to the given unit and up axis. The
+ * data of each element is converted from the unit and up axis of the nearest
+ * asset that defines them, so documents merged from differing sources are
+ * normalized in a single pass. POSITION, NORMAL, TANGENT, BINORMAL and
+ * INV_BIND_MATRIX sources, translate, rotate, scale, matrix, lookat and skew
+ * elements, skin bind shape matrices, and the animation outputs that target
+ * them are converted. Channels targeting a single component are retargeted
+ * when the axes are swapped. Arrays are converted in parallel, and every
+ * asset is updated to the new unit and up axis when done.
+ * @param doc the document to convert
+ * @param meter the size of the new unit in meters
+ * @param upaxis the new up axis
+ * @param numthreads the number of threads to use, including the calling
+ *        thread. If less than 1, one thread per processor is used
+ * @return 0 on success, -1 if meter is not positive or upaxis is invalid
+ */
+int daeu_normalize_units(
+    dae_COLLADA* doc,
+    float meter,
+    daeu_up_axis upaxis,
+    int numthreads);
+
 void daeu_rotate_to_matrix(
     const dae_rotate_type* rotate,
     float* mtx_out);
@@ -38,6 +654,49 @@ void daeu_translate_to_matrix(
     const dae_translate_type* translate,
     float* mtx_out);
 
+/**
+ * @details Converts a triangles, polylist, polygons, trifans or tristrips
+ * element into a triangle list of index tuples. The output is sized exactly
+ * before conversion so no allocation occurs per polygon. Polygons are fan
+ * triangulated, while polygons with holes (ph) are bridged into a single
+ * ring and ear clipped in the plane of the POSITION input of the mesh.
+ * @param mesh the mesh that owns the primitive element
+ * @param prim the primitive element to convert
+ * @param tris_out out param that will be filled with the triangle list.
+ *        It must be released with daeu_tris_destroy
+ * @return 0 on success, -1 if prim is not a supported primitive element
+ */
+int daeu_triangulate(
+    dae_mesh_type* mesh,
+    dae_obj_ptr prim,
+    daeu_tris* tris_out);
+
+void daeu_tris_destroy(
+    daeu_tris* tris);
+
+/**
+ * @details Flattens the node hierarchy of a visual scene into arrays of
+ * nodes, parent indices, and local and world transform matrices, using the
+ * same row major convention as daeu_calc_transform_matrix. Instanced nodes
+ * are not expanded.
+ * @param scene_out out param that will be filled with the flattened scene.
+ *        It must be released with daeu_scene_destroy
+ */
+void daeu_scene_flatten(
+    dae_visual_scene_type* scene,
+    daeu_scene* scene_out);
+
+void daeu_scene_destroy(
+    daeu_scene* scene);
+
+/**
+ * @details Recalculates the local and world matrices of a flattened scene
+ * from the current transform elements of its nodes, for instance after
+ * animation values have been written to them.
+ */
+void daeu_scene_update(
+    daeu_scene* scene);
+
 /**
  * @details This function can be used to perform a sid search that targets an
  * element and possibly a data component within that element. For example, if
@@ -45,7 +704,8 @@ void daeu_translate_to_matrix(
  * output parameters so that obj_out points to the object with id "translate"
  * within "node_0", and dataindex_out will be set to 0, representing an index
  * to the first float value in the data array of
- * "translate". The data_out parameter is optional.
+ * "translate". Matrix elements may be addressed as "(column)(row)". The
+ * data_out parameter is optional.
  * @param obj_out out param that will be filled with target object
  * @param data_out optional out param that will be filled with the array index
  *        of the target data component referenced by the search string. If no
@@ -64,6 +724,63 @@ dae_obj_ptr daeu_search_uri(
     dae_obj_ptr searchroot,
     const char* uri);
 
+/**
+ * @details Compiles the variable length vertex weights of a skin into fixed
+ * width arrays. The influences of each vertex are sorted by weight, those
+ * below minweight are dropped, only the largest are kept, and the remaining
+ * weights are renormalized. Unused influence slots have a weight of zero.
+ * Influences of joint -1, which refer to the bind shape, are dropped.
+ * Joints are resolved to scene nodes by sid, then by id.
+ * @param scene optional flattened scene used to resolve joint nodes
+ * @param influences the number of influences per vertex, from 1 to 8
+ * @param skin_out out param that will be filled with the compiled skin. It
+ *        must be released with daeu_skin_destroy
+ * @return 0 on success, -1 if the skin was missing joints or weights, or
+ *         influences was out of range
+ */
+int daeu_skin_compile(
+    dae_skin_type* skin,
+    const daeu_scene* scene,
+    unsigned influences,
+    float minweight,
+    daeu_skin* skin_out);
+
+/**
+ * @details Applies linear blend skinning to a compiled mesh. The positions
+ * and normals of each vertex are transformed by the weighted sum of the
+ * palette matrices of its influences, and the other attributes are copied.
+ * Vertices are mapped to skin vertices through the source index of their
+ * positions. The vertex buffer is split into ranges that are skinned on a
+ * work stealing thread pool, using SSE or AVX when available.
+ * @param palette skinning matrix of each joint, as computed by
+ *        daeu_skin_palette
+ * @param numthreads the number of threads to use, including the calling
+ *        thread. If less than 1, one thread per processor is used
+ * @param vertices_out buffer of mesh->numvertices*mesh->vertexsize floats
+ *        that will receive the skinned vertices. It may be mesh->vertices
+ * @return 0 on success, -1 if the mesh has no positions
+ */
+int daeu_skin_deform(
+    const daeu_skin* skin,
+    const float* palette,
+    const daeu_mesh* mesh,
+    int numthreads,
+    float* vertices_out);
+
+void daeu_skin_destroy(
+    daeu_skin* skin);
+
+/**
+ * @details Computes the skinning matrix of each joint as the world matrix of
+ * its node, times its inverse bind matrix, times the bind shape matrix.
+ * Joints without a node use the bind shape matrix alone.
+ * @param palette_out out param receiving 16 floats per joint
+ */
+void daeu_skin_palette(
+    const daeu_skin* skin,
+    const daeu_scene* scene,
+    float* palette_out);
+
 void daeu_xml_chardata(
     void *userdata,
      const char *s,
@@ -73,6 +790,26 @@ void daeu_xml_create(
     dae_COLLADA* root,
     daeu_xml_parser* parser_out);
 
+/**
+ * @details Creates a parser whose own buffers come from the given hooks.
+ * daeu_xml_create uses the hooks of the document being loaded.
+ * @param root the document that receives the parsed content
+ * @param allocator the memory hooks. They must remain valid until the
+ *        parser is destroyed
+ * @param parser_out out param receiving the parser
+ */
+void daeu_xml_create_ex(
+    dae_COLLADA* root,
+    const dae_allocator* allocator,
+    daeu_xml_parser* parser_out);
+
+/**
+ * @details Destroys a parser. It must be destroyed before the document it
+ * loads into, or released from that document first by daeu_xml_reset with
+ * NULL, because it detaches its load counters from the document when the
+ * library is compiled with DAE_INSTRUMENT defined.
+ * @param parser the parser to destroy
+ */
 void daeu_xml_destroy(
     daeu_xml_parser parser);
 
@@ -80,6 +817,54 @@ void daeu_xml_endelement(
     void* userdata,
     const char* el);
 
+/**
+ * @details Gets the load counters of a parser. The counters are only
+ * gathered when the library is compiled with DAE_INSTRUMENT defined.
+ * @param parser the parser
+ * @param stats_out out param receiving the counters, zeroed if they are not
+ *        gathered
+ * @return 0 on success, -1 if the library was compiled without
+ *         DAE_INSTRUMENT
+ */
+int daeu_xml_get_stats(
+    daeu_xml_parser parser,
+    daeu_xml_stats* stats_out);
+
+/**
+ * @details Loads a list of files into separate documents. The files are
+ * memory mapped and parsed on a work stealing thread pool, largest first.
+ * Each worker keeps its tokenizer and its daeu_xml_parser, with the buffers
+ * they have grown, from one file to the next. Arrays kept in binary sidecar
+ * files are loaded with daeu_binary_load.
+ * @param paths the files to load
+ * @param driver drives the SAX parser of each worker
+ * @param allocator optional memory hooks for the documents and parsers. If
+ *        NULL, the hooks of dae_create are used
+ * @param numthreads the number of threads to use, including the calling
+ *        thread. If less than 1, one thread per processor is used
+ * @param results_out array of numpaths results that will receive the
+ *        documents, which must be released with dae_destroy
+ * @return 0 if every file was loaded, -1 otherwise
+ */
+int daeu_xml_load_batch(
+    const char* const* paths,
+    size_t numpaths,
+    const daeu_xml_driver* driver,
+    const dae_allocator* allocator,
+    int numthreads,
+    daeu_xml_load_result* results_out);
+
+/**
+ * @details Points a parser at another document, as if it had been destroyed
+ * and created again, but keeps the buffers it has already grown. This saves
+ * the setup cost when loading many small files in a row.
+ * @param root the document that receives the parsed content, or NULL to
+ *        only release the previous document from the parser
+ */
+void daeu_xml_reset(
+    daeu_xml_parser parser,
+    dae_COLLADA* root);
+
 void daeu_xml_startelement(
     void* userdata,
     const char* el,
@@ -6,13 +6,320 @@
  ****************************************************************************/
 #include <daeu.h>
 #include <assert.h>
+#include <ctype.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// SSE is part of every x64 target, while AVX kernels are compiled with a
+// per function target and only called when the processor supports them
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define daeu_SSE
+#include <xmmintrin.h>
+#if defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1600)
+#define daeu_AVX
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define daeu_AVX_FN
+#else
+#define daeu_AVX_FN __attribute__((target("avx")))
+#endif
+#endif
+#endif
+
+#ifdef _WIN32
+typedef HANDLE daeu_thread;
+typedef CRITICAL_SECTION daeu_mutex;
+#else
+typedef pthread_t daeu_thread;
+typedef pthread_mutex_t daeu_mutex;
+#endif
+
+#ifdef _MSC_VER
+#define daeu_ATOMIC_LOAD(p_) _InterlockedCompareExchange((p_), 0, 0)
+#define daeu_ATOMIC_STORE(p_, v_) _InterlockedExchange((p_), (v_))
+#else
+#define daeu_ATOMIC_LOAD(p_) __atomic_load_n((p_), __ATOMIC_ACQUIRE)
+#define daeu_ATOMIC_STORE(p_, v_) \
+    __atomic_store_n((p_), (v_), __ATOMIC_RELEASE)
+#endif
+
+typedef void (*daeu_task_fn)(
+    void* userdata,
+    size_t index,
+    int worker);
+
+typedef struct daeu_anim_batch_s daeu_anim_batch;
+typedef struct daeu_anim_binding_s daeu_anim_binding;
+typedef struct daeu_dedup_batch_s daeu_dedup_batch;
+typedef struct daeu_dedup_ids_s daeu_dedup_ids;
+typedef struct daeu_dedup_item_s daeu_dedup_item;
+typedef struct daeu_idmap_s daeu_idmap;
+typedef struct daeu_merge_state_s daeu_merge_state;
+typedef struct daeu_mesh_batch_s daeu_mesh_batch;
+typedef struct daeu_mesh_binding_s daeu_mesh_binding;
+typedef struct daeu_mesh_cost_s daeu_mesh_cost;
+typedef struct daeu_morph_batch_s daeu_morph_batch;
+typedef struct daeu_skin_batch_s daeu_skin_batch;
+typedef struct daeu_source_binding_s daeu_source_binding;
+typedef struct daeu_tri_scratch_s daeu_tri_scratch;
+typedef struct daeu_units_s daeu_units;
+typedef struct daeu_units_batch_s daeu_units_batch;
+typedef struct daeu_units_task_s daeu_units_task;
+typedef struct daeu_xml_batch_s daeu_xml_batch;
+typedef struct daeu_xml_worker_s daeu_xml_worker;
+typedef struct daeu_pool_s daeu_pool;
+typedef struct daeu_pool_worker_s daeu_pool_worker;
+
+struct daeu_anim_batch_s
+{
+    const daeu_anim* anim;
+    daeu_anim_clip* clip;
+};
+
+struct daeu_dedup_batch_s
+{
+    daeu_dedup_item* items;
+    int avx;
+};
+
+struct daeu_dedup_ids_s
+{
+    // ids within a subtree in preorder, with the elements that hold them
+    const char** ids;
+    dae_obj_ptr* objs;
+    size_t size;
+    size_t cap;
+};
+
+struct daeu_dedup_item_s
+{
+    dae_obj_ptr obj;
+    // only set when duplicates must share a parent
+    dae_obj_ptr parent;
+    dae_obj_ptr keep;
+    size_t order;
+    unsigned hash;
+};
+
+struct daeu_destroy_job_s
+{
+    daeu_thread thread;
+    dae_COLLADA* doc;
+    int numthreads;
+    int started;
+};
+
+struct daeu_source_binding_s
+{
+    dae_source_type* source;
+    const float* data;
+    char* const* names;
+    size_t count;
+    size_t stride;
+};
+
+struct daeu_anim_binding_s
+{
+    dae_channel_type* channel;
+    dae_sampler_type* sampler;
+    daeu_source_binding input;
+    daeu_source_binding output;
+    daeu_source_binding interp;
+    daeu_source_binding intangent;
+    daeu_source_binding outtangent;
+    size_t numkeys;
+    int iscurved;
+};
+
+struct daeu_idmap_s
+{
+    const char** keys;
+    dae_obj_ptr* objs;
+    size_t cap;
+    size_t size;
+};
+
+struct daeu_merge_state_s
+{
+    // old ids of renamed objects in the source document
+    daeu_idmap renames;
+    // owned copies of each old id followed by its replacement
+    char** names;
+    size_t numnames;
+    size_t capnames;
+    // scratch for rewriting reference values
+    char* text;
+    size_t textlen;
+    size_t textcap;
+};
+
+struct daeu_mesh_binding_s
+{
+    const float* data;
+    size_t datalen;
+    size_t count;
+    size_t offset;
+    size_t stride;
+    unsigned params[16];
+    unsigned numparams;
+    unsigned tupleoffset;
+};
+
+struct daeu_mesh_batch_s
+{
+    daeu_geometry_mesh* meshes;
+    const daeu_mesh_attrib* attribs;
+    size_t numattribs;
+};
+
+struct daeu_mesh_cost_s
+{
+    size_t cost;
+    size_t index;
+};
+
+struct daeu_morph_batch_s
+{
+    const daeu_mesh* base;
+    const daeu_mesh* targets;
+    const float* weights;
+    size_t numtargets;
+    float baseweight;
+    float* vertices;
+    // number of floats in the vertex buffer, and per task
+    size_t count;
+    size_t chunk;
+    int avx;
+};
+
+struct daeu_skin_batch_s
+{
+    const daeu_skin* skin;
+    const daeu_mesh* mesh;
+    // transposed palette, 16 floats per joint
+    float* cols;
+    float* vertices;
+    // vertices per task
+    size_t chunk;
+    // attribute index of the positions, and offset of the normals
+    unsigned position;
+    int normal;
+    int avx;
+};
+
+struct daeu_tri_scratch_s
+{
+    const unsigned** ring;
+    float* xy;
+    int* prev;
+    int* next;
+    size_t cap;
+};
+
+enum daeu_units_kind_e
+{
+    // lengths and directions have 3 values, converted by axis and scale
+    daeu_UNITS_POINT,
+    daeu_UNITS_DIRECTION,
+    // transform elements
+    daeu_UNITS_LOOKAT,
+    daeu_UNITS_MATRIX,
+    daeu_UNITS_ROTATE,
+    daeu_UNITS_SCALE,
+    daeu_UNITS_SKEW,
+    // a single value multiplied by the task factor
+    daeu_UNITS_FACTOR
+};
+
+struct daeu_units_s
+{
+    // v'[i] = sign[i]*v[perm[i]], with lengths also multiplied by scale
+    unsigned perm[3];
+    float sign[3];
+    float scale;
+};
+
+struct daeu_units_task_s
+{
+    float* data;
+    size_t count;
+    size_t stride;
+    // position of each converted value within a tuple
+    unsigned offsets[16];
+    unsigned numoffsets;
+    int kind;
+    // multiplier for single values of animated components
+    float factor;
+    daeu_units units;
+    // document order, the first task for an array wins
+    size_t seq;
+};
+
+struct daeu_units_batch_s
+{
+    daeu_units_task* tasks;
+    size_t size;
+    size_t cap;
+};
+
+struct daeu_pool_worker_s
+{
+    daeu_mutex lock;
+    daeu_pool* pool;
+    daeu_thread thread;
+    size_t begin;
+    size_t end;
+    int index;
+    int started;
+    // keep each worker's range on its own cache line
+    char pad[64];
+};
+
+struct daeu_xml_worker_s
+{
+    // created by the first file the worker loads, then reused
+    void* tokenizer;
+    daeu_xml_parser parser;
+    int failed;
+    // keeps each worker's state on its own cache line
+    char pad[64];
+};
+
+struct daeu_xml_batch_s
+{
+    const char* const* paths;
+    const daeu_xml_driver* driver;
+    const dae_allocator* allocator;
+    daeu_xml_load_result* results;
+    daeu_xml_worker* workers;
+};
+
+struct daeu_pool_s
+{
+    daeu_pool_worker* workers;
+    const size_t* order;
+    daeu_task_fn fn;
+    void* userdata;
+    int numworkers;
+};
 
 struct daeu_xml_parser_s
 {
+    const dae_allocator* allocator;
     dae_COLLADA* root;
     dae_obj_ptr current;
     struct
@@ -21,8 +328,280 @@ struct daeu_xml_parser_s
         size_t len;
         size_t cap;
     } chardata;
+    struct
+    {
+        // hex binary content is decoded into chardata as it arrives
+        int active;
+        int error;
+        // a digit whose pair has not arrived yet
+        char carry;
+    } hex;
+#ifdef DAE_INSTRUMENT
+    daeu_xml_stats stats;
+    // times at which the current callback was entered and the previous
+    // callback returned
+    double entered;
+    double left;
+#endif
 };
 
+//****************************************************************************
+static void daeu_mutex_create(
+    daeu_mutex* mutex)
+{
+#ifdef _WIN32
+    InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+//****************************************************************************
+static void daeu_mutex_destroy(
+    daeu_mutex* mutex)
+{
+#ifdef _WIN32
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+//****************************************************************************
+static void daeu_mutex_lock(
+    daeu_mutex* mutex)
+{
+#ifdef _WIN32
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+//****************************************************************************
+static void daeu_mutex_unlock(
+    daeu_mutex* mutex)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+//****************************************************************************
+static int daeu_get_num_cpus()
+{
+    int n;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    n = (int) info.dwNumberOfProcessors;
+#else
+    n = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return (n > 0) ? n : 1;
+}
+
+//****************************************************************************
+static int daeu_pool_take(
+    daeu_pool_worker* w,
+    size_t* index_out)
+{
+    // pops a task from the front of the worker's own range
+    int result = 0;
+    daeu_mutex_lock(&w->lock);
+    if(w->begin < w->end)
+    {
+        *index_out = w->begin;
+        ++w->begin;
+        result = 1;
+    }
+    daeu_mutex_unlock(&w->lock);
+    return result;
+}
+
+//****************************************************************************
+static int daeu_pool_steal(
+    daeu_pool_worker* w,
+    size_t* index_out)
+{
+    // moves the back half of the largest remaining range to this worker
+    daeu_pool* pool = w->pool;
+    int result = 0;
+    while(!result)
+    {
+        daeu_pool_worker* victim = NULL;
+        size_t most = 0;
+        size_t begin = 0;
+        size_t end = 0;
+        int i;
+        for(i = 0; i < pool->numworkers; ++i)
+        {
+            daeu_pool_worker* v = pool->workers + i;
+            if(v != w)
+            {
+                size_t n;
+                daeu_mutex_lock(&v->lock);
+                n = v->end - v->begin;
+                daeu_mutex_unlock(&v->lock);
+                if(n > most)
+                {
+                    most = n;
+                    victim = v;
+                }
+            }
+        }
+        if(victim == NULL)
+        {
+            break;
+        }
+        daeu_mutex_lock(&victim->lock);
+        if(victim->begin < victim->end)
+        {
+            size_t n = victim->end - victim->begin;
+            begin = victim->end - (n + 1)/2;
+            end = victim->end;
+            victim->end = begin;
+            result = 1;
+        }
+        daeu_mutex_unlock(&victim->lock);
+        if(result)
+        {
+            // only one lock is held at a time, so workers stealing from
+            // each other cannot deadlock
+            *index_out = begin;
+            daeu_mutex_lock(&w->lock);
+            w->begin = begin + 1;
+            w->end = end;
+            daeu_mutex_unlock(&w->lock);
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+#ifdef _WIN32
+static DWORD WINAPI daeu_pool_main(
+    LPVOID arg)
+#else
+static void* daeu_pool_main(
+    void* arg)
+#endif
+{
+    daeu_pool_worker* w = (daeu_pool_worker*) arg;
+    daeu_pool* pool = w->pool;
+    size_t i;
+    while(daeu_pool_take(w, &i) || daeu_pool_steal(w, &i))
+    {
+        size_t task = (pool->order != NULL) ? pool->order[i] : i;
+        pool->fn(pool->userdata, task, w->index);
+    }
+    return 0;
+}
+
+//****************************************************************************
+static int daeu_pool_count_workers(
+    size_t count,
+    int numthreads)
+{
+    int n = (numthreads > 0) ? numthreads : daeu_get_num_cpus();
+    if((size_t) n > count)
+    {
+        n = (int) count;
+    }
+    return (n > 0) ? n : 1;
+}
+
+//****************************************************************************
+static void daeu_pool_run(
+    size_t count,
+    const size_t* order,
+    int numworkers,
+    daeu_task_fn fn,
+    void* userdata)
+{
+    // runs fn for each of count tasks on a work stealing pool. the calling
+    // thread acts as worker 0. tasks are dispatched in the sequence given
+    // by order, if provided, and each worker starts with a contiguous share
+    daeu_pool pool;
+    int i;
+    pool.fn = fn;
+    pool.userdata = userdata;
+    pool.order = order;
+    pool.numworkers = numworkers;
+    pool.workers = (daeu_pool_worker*) malloc(
+        numworkers*sizeof(*pool.workers));
+    for(i = 0; i < numworkers; ++i)
+    {
+        daeu_pool_worker* w = pool.workers + i;
+        daeu_mutex_create(&w->lock);
+        w->pool = &pool;
+        w->index = i;
+        w->begin = (count*i)/numworkers;
+        w->end = (count*(i + 1))/numworkers;
+    }
+    for(i = 1; i < numworkers; ++i)
+    {
+        daeu_pool_worker* w = pool.workers + i;
+#ifdef _WIN32
+        w->thread = CreateThread(NULL, 0, daeu_pool_main, w, 0, NULL);
+        w->started = (w->thread != NULL);
+#else
+        w->started = (pthread_create(&w->thread, NULL, daeu_pool_main, w)==0);
+#endif
+    }
+    daeu_pool_main(pool.workers);
+    for(i = 1; i < numworkers; ++i)
+    {
+        daeu_pool_worker* w = pool.workers + i;
+        if(!w->started)
+        {
+            // the share of a worker that could not be started is usually
+            // stolen by the others already, anything left runs here
+            daeu_pool_main(w);
+            continue;
+        }
+#ifdef _WIN32
+        WaitForSingleObject(w->thread, INFINITE);
+        CloseHandle(w->thread);
+#else
+        pthread_join(w->thread, NULL);
+#endif
+    }
+    for(i = 0; i < numworkers; ++i)
+    {
+        daeu_mutex_destroy(&pool.workers[i].lock);
+    }
+    free(pool.workers);
+}
+
+//****************************************************************************
+static void* daeu_aligned_alloc(
+    size_t size)
+{
+    // 64 byte alignment keeps each 4x4 float matrix on its own cache line.
+    // the pointer returned by malloc is stored just before the aligned block
+    char* raw = (char*) malloc(size + 64 + sizeof(void*));
+    char* ptr = NULL;
+    if(raw != NULL)
+    {
+        ptr = (char*) (((size_t) (raw + sizeof(void*) + 63)) & ~((size_t) 63));
+        ((void**) ptr)[-1] = raw;
+    }
+    return ptr;
+}
+
+//****************************************************************************
+static void daeu_aligned_free(
+    void* ptr)
+{
+    if(ptr != NULL)
+    {
+        free(((void**) ptr)[-1]);
+    }
+}
+
 //****************************************************************************
 static void daeu_cross3(
     const float* a,
@@ -59,13 +638,65 @@ static void daeu_matrix_identity(
 
 
 //****************************************************************************
-static void daeu_matrix_multiply(
+#ifndef daeu_SSE
+static void daeu_matrix_invert_scalar(
+    const float* m,
+    float* out)
+{
+    float inv[16];
+    float det;
+    int i;
+    inv[ 0] =  m[5]*m[10]*m[15] - m[5]*m[11]*m[14] - m[9]*m[6]*m[15]
+            +  m[9]*m[7]*m[14] + m[13]*m[6]*m[11] - m[13]*m[7]*m[10];
+    inv[ 4] = -m[4]*m[10]*m[15] + m[4]*m[11]*m[14] + m[8]*m[6]*m[15]
+            -  m[8]*m[7]*m[14] - m[12]*m[6]*m[11] + m[12]*m[7]*m[10];
+    inv[ 8] =  m[4]*m[ 9]*m[15] - m[4]*m[11]*m[13] - m[8]*m[5]*m[15]
+            +  m[8]*m[7]*m[13] + m[12]*m[5]*m[11] - m[12]*m[7]*m[ 9];
+    inv[12] = -m[4]*m[ 9]*m[14] + m[4]*m[10]*m[13] + m[8]*m[5]*m[14]
+            -  m[8]*m[6]*m[13] - m[12]*m[5]*m[10] + m[12]*m[6]*m[ 9];
+    inv[ 1] = -m[1]*m[10]*m[15] + m[1]*m[11]*m[14] + m[9]*m[2]*m[15]
+            -  m[9]*m[3]*m[14] - m[13]*m[2]*m[11] + m[13]*m[3]*m[10];
+    inv[ 5] =  m[0]*m[10]*m[15] - m[0]*m[11]*m[14] - m[8]*m[2]*m[15]
+            +  m[8]*m[3]*m[14] + m[12]*m[2]*m[11] - m[12]*m[3]*m[10];
+    inv[ 9] = -m[0]*m[ 9]*m[15] + m[0]*m[11]*m[13] + m[8]*m[1]*m[15]
+            -  m[8]*m[3]*m[13] - m[12]*m[1]*m[11] + m[12]*m[3]*m[ 9];
+    inv[13] =  m[0]*m[ 9]*m[14] - m[0]*m[10]*m[13] - m[8]*m[1]*m[14]
+            +  m[8]*m[2]*m[13] + m[12]*m[1]*m[10] - m[12]*m[2]*m[ 9];
+    inv[ 2] =  m[1]*m[ 6]*m[15] - m[1]*m[ 7]*m[14] - m[5]*m[2]*m[15]
+            +  m[5]*m[3]*m[14] + m[13]*m[2]*m[ 7] - m[13]*m[3]*m[ 6];
+    inv[ 6] = -m[0]*m[ 6]*m[15] + m[0]*m[ 7]*m[14] + m[4]*m[2]*m[15]
+            -  m[4]*m[3]*m[14] - m[12]*m[2]*m[ 7] + m[12]*m[3]*m[ 6];
+    inv[10] =  m[0]*m[ 5]*m[15] - m[0]*m[ 7]*m[13] - m[4]*m[1]*m[15]
+            +  m[4]*m[3]*m[13] + m[12]*m[1]*m[ 7] - m[12]*m[3]*m[ 5];
+    inv[14] = -m[0]*m[ 5]*m[14] + m[0]*m[ 6]*m[13] + m[4]*m[1]*m[14]
+            -  m[4]*m[2]*m[13] - m[12]*m[1]*m[ 6] + m[12]*m[2]*m[ 5];
+    inv[ 3] = -m[1]*m[ 6]*m[11] + m[1]*m[ 7]*m[10] + m[5]*m[2]*m[11]
+            -  m[5]*m[3]*m[10] - m[ 9]*m[2]*m[ 7] + m[ 9]*m[3]*m[ 6];
+    inv[ 7] =  m[0]*m[ 6]*m[11] - m[0]*m[ 7]*m[10] - m[4]*m[2]*m[11]
+            +  m[4]*m[3]*m[10] + m[ 8]*m[2]*m[ 7] - m[ 8]*m[3]*m[ 6];
+    inv[11] = -m[0]*m[ 5]*m[11] + m[0]*m[ 7]*m[ 9] + m[4]*m[1]*m[11]
+            -  m[4]*m[3]*m[ 9] - m[ 8]*m[1]*m[ 7] + m[ 8]*m[3]*m[ 5];
+    inv[15] =  m[0]*m[ 5]*m[10] - m[0]*m[ 6]*m[ 9] - m[4]*m[1]*m[10]
+            +  m[4]*m[2]*m[ 9] + m[ 8]*m[1]*m[ 6] - m[ 8]*m[2]*m[ 5];
+    det = m[0]*inv[0] + m[1]*inv[4] + m[2]*inv[8] + m[3]*inv[12];
+    det = 1.0f/det;
+    for(i = 0; i < 16; ++i)
+    {
+        out[i] = inv[i]*det;
+    }
+}
+#endif
+
+//****************************************************************************
+#ifndef daeu_SSE
+static void daeu_matrix_multiply_scalar(
     const float* a,
     const float* b,
     float* out)
 {
+    float tmp[16];
 #define daeu_MATRIXMUL_COMP(r_, c_) \
-    out[(r_)*4 + (c_)] = \
+    tmp[(r_)*4 + (c_)] = \
         a[(r_)*4+0]*b[0*4+(c_)] + \
         a[(r_)*4+1]*b[1*4+(c_)] + \
         a[(r_)*4+2]*b[2*4+(c_)] + \
@@ -87,6 +718,375 @@ static void daeu_matrix_multiply(
     daeu_MATRIXMUL_COMP(3,2);
     daeu_MATRIXMUL_COMP(3,3);
 #undef daeu_MATRIXMUL_COMP
+    memcpy(out, tmp, sizeof(tmp));
+}
+#endif
+
+//****************************************************************************
+#ifdef daeu_SSE
+static void daeu_matrix_multiply_sse(
+    const float* a,
+    const float* b,
+    float* out)
+{
+    // every row of b is loaded before anything is stored, and each row of
+    // a is loaded before the matching output row, so out may alias a or b
+    __m128 b0 = _mm_loadu_ps(b + 0);
+    __m128 b1 = _mm_loadu_ps(b + 4);
+    __m128 b2 = _mm_loadu_ps(b + 8);
+    __m128 b3 = _mm_loadu_ps(b + 12);
+    int r;
+    for(r = 0; r < 16; r += 4)
+    {
+        __m128 ar = _mm_loadu_ps(a + r);
+        __m128 o = _mm_mul_ps(_mm_shuffle_ps(ar, ar, 0x00), b0);
+        o = _mm_add_ps(o, _mm_mul_ps(_mm_shuffle_ps(ar, ar, 0x55), b1));
+        o = _mm_add_ps(o, _mm_mul_ps(_mm_shuffle_ps(ar, ar, 0xAA), b2));
+        o = _mm_add_ps(o, _mm_mul_ps(_mm_shuffle_ps(ar, ar, 0xFF), b3));
+        _mm_storeu_ps(out + r, o);
+    }
+}
+#endif
+
+//****************************************************************************
+#ifdef daeu_SSE
+// shuffles for the 2x2 block inverse. A 2x2 matrix is held in one register
+// as (m00, m01, m10, m11)
+#define daeu_SHUF(x_, y_, z_, w_) ((x_) | ((y_)<<2) | ((z_)<<4) | ((w_)<<6))
+#define daeu_SWZ(v_, x_, y_, z_, w_) \
+    _mm_shuffle_ps(v_, v_, daeu_SHUF(x_, y_, z_, w_))
+// a * b
+#define daeu_MAT2MUL(a_, b_) \
+    _mm_add_ps( \
+        _mm_mul_ps(a_, daeu_SWZ(b_, 0,3,0,3)), \
+        _mm_mul_ps(daeu_SWZ(a_, 1,0,3,2), daeu_SWZ(b_, 2,1,2,1)))
+// adj(a) * b
+#define daeu_MAT2ADJMUL(a_, b_) \
+    _mm_sub_ps( \
+        _mm_mul_ps(daeu_SWZ(a_, 3,3,0,0), b_), \
+        _mm_mul_ps(daeu_SWZ(a_, 1,1,2,2), daeu_SWZ(b_, 2,3,0,1)))
+// a * adj(b)
+#define daeu_MAT2MULADJ(a_, b_) \
+    _mm_sub_ps( \
+        _mm_mul_ps(a_, daeu_SWZ(b_, 3,0,3,0)), \
+        _mm_mul_ps(daeu_SWZ(a_, 1,0,3,2), daeu_SWZ(b_, 2,1,2,1)))
+
+static void daeu_matrix_invert_sse(
+    const float* m,
+    float* out)
+{
+    // block matrix inverse: M = |A B|, inv(M) = 1/|M| * |X Y|
+    //                           |C D|                   |Z W|
+    __m128 r0 = _mm_loadu_ps(m + 0);
+    __m128 r1 = _mm_loadu_ps(m + 4);
+    __m128 r2 = _mm_loadu_ps(m + 8);
+    __m128 r3 = _mm_loadu_ps(m + 12);
+    __m128 a = _mm_movelh_ps(r0, r1);
+    __m128 b = _mm_movehl_ps(r1, r0);
+    __m128 c = _mm_movelh_ps(r2, r3);
+    __m128 d = _mm_movehl_ps(r3, r2);
+    __m128 detsub, deta, detb, detc, detd, dc, ab, x, y, z, w, detm, tr;
+    // (|A|, |B|, |C|, |D|)
+    detsub = _mm_sub_ps(
+        _mm_mul_ps(
+            _mm_shuffle_ps(r0, r2, daeu_SHUF(0,2,0,2)),
+            _mm_shuffle_ps(r1, r3, daeu_SHUF(1,3,1,3))),
+        _mm_mul_ps(
+            _mm_shuffle_ps(r0, r2, daeu_SHUF(1,3,1,3)),
+            _mm_shuffle_ps(r1, r3, daeu_SHUF(0,2,0,2))));
+    deta = daeu_SWZ(detsub, 0,0,0,0);
+    detb = daeu_SWZ(detsub, 1,1,1,1);
+    detc = daeu_SWZ(detsub, 2,2,2,2);
+    detd = daeu_SWZ(detsub, 3,3,3,3);
+    dc = daeu_MAT2ADJMUL(d, c);
+    ab = daeu_MAT2ADJMUL(a, b);
+    // adj(X) = |D|A - B adj(D)C, adj(W) = |A|D - C adj(A)B
+    x = _mm_sub_ps(_mm_mul_ps(detd, a), daeu_MAT2MUL(b, dc));
+    w = _mm_sub_ps(_mm_mul_ps(deta, d), daeu_MAT2MUL(c, ab));
+    // adj(Y) = |B|C - D adj(adj(A)B), adj(Z) = |C|B - A adj(adj(D)C)
+    y = _mm_sub_ps(_mm_mul_ps(detb, c), daeu_MAT2MULADJ(d, ab));
+    z = _mm_sub_ps(_mm_mul_ps(detc, b), daeu_MAT2MULADJ(a, dc));
+    // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+    detm = _mm_add_ps(_mm_mul_ps(deta, detd), _mm_mul_ps(detb, detc));
+    tr = _mm_mul_ps(ab, daeu_SWZ(dc, 0,2,1,3));
+    tr = _mm_add_ps(tr, daeu_SWZ(tr, 1,0,3,2));
+    tr = _mm_add_ps(tr, daeu_SWZ(tr, 2,3,0,1));
+    detm = _mm_div_ps(
+        _mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f),
+        _mm_sub_ps(detm, tr));
+    x = _mm_mul_ps(x, detm);
+    y = _mm_mul_ps(y, detm);
+    z = _mm_mul_ps(z, detm);
+    w = _mm_mul_ps(w, detm);
+    // the final shuffle applies the adjugates and reassembles the rows
+    _mm_storeu_ps(out + 0, _mm_shuffle_ps(x, y, daeu_SHUF(3,1,3,1)));
+    _mm_storeu_ps(out + 4, _mm_shuffle_ps(x, y, daeu_SHUF(2,0,2,0)));
+    _mm_storeu_ps(out + 8, _mm_shuffle_ps(z, w, daeu_SHUF(3,1,3,1)));
+    _mm_storeu_ps(out + 12, _mm_shuffle_ps(z, w, daeu_SHUF(2,0,2,0)));
+}
+
+#undef daeu_MAT2MULADJ
+#undef daeu_MAT2ADJMUL
+#undef daeu_MAT2MUL
+#undef daeu_SWZ
+#undef daeu_SHUF
+#endif
+
+//****************************************************************************
+#ifdef daeu_AVX
+static daeu_AVX_FN void daeu_matrix_multiply_avx(
+    const float* a,
+    const float* b,
+    float* out)
+{
+    // two output rows per register, each lane computing one of them. As
+    // with the SSE kernel, out may alias a or b
+    __m256 b0 = _mm256_broadcast_ps((const __m128*) (b + 0));
+    __m256 b1 = _mm256_broadcast_ps((const __m128*) (b + 4));
+    __m256 b2 = _mm256_broadcast_ps((const __m128*) (b + 8));
+    __m256 b3 = _mm256_broadcast_ps((const __m128*) (b + 12));
+    __m256 a01 = _mm256_loadu_ps(a + 0);
+    __m256 a23 = _mm256_loadu_ps(a + 8);
+    __m256 o01, o23;
+    o01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x00), b0);
+    o23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x00), b0);
+    o01 = _mm256_add_ps(o01,
+        _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x55), b1));
+    o23 = _mm256_add_ps(o23,
+        _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x55), b1));
+    o01 = _mm256_add_ps(o01,
+        _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xAA), b2));
+    o23 = _mm256_add_ps(o23,
+        _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xAA), b2));
+    o01 = _mm256_add_ps(o01,
+        _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xFF), b3));
+    o23 = _mm256_add_ps(o23,
+        _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xFF), b3));
+    _mm256_storeu_ps(out + 0, o01);
+    _mm256_storeu_ps(out + 8, o23);
+}
+#endif
+
+//****************************************************************************
+#ifdef daeu_AVX
+#define daeu_SHUF(x_, y_, z_, w_) ((x_) | ((y_)<<2) | ((z_)<<4) | ((w_)<<6))
+#define daeu_SWZ(v_, x_, y_, z_, w_) \
+    _mm256_shuffle_ps(v_, v_, daeu_SHUF(x_, y_, z_, w_))
+#define daeu_MOVELH(a_, b_) \
+    _mm256_castpd_ps(_mm256_unpacklo_pd( \
+        _mm256_castps_pd(a_), _mm256_castps_pd(b_)))
+#define daeu_MOVEHL(a_, b_) \
+    _mm256_castpd_ps(_mm256_unpackhi_pd( \
+        _mm256_castps_pd(b_), _mm256_castps_pd(a_)))
+#define daeu_MAT2MUL(a_, b_) \
+    _mm256_add_ps( \
+        _mm256_mul_ps(a_, daeu_SWZ(b_, 0,3,0,3)), \
+        _mm256_mul_ps(daeu_SWZ(a_, 1,0,3,2), daeu_SWZ(b_, 2,1,2,1)))
+#define daeu_MAT2ADJMUL(a_, b_) \
+    _mm256_sub_ps( \
+        _mm256_mul_ps(daeu_SWZ(a_, 3,3,0,0), b_), \
+        _mm256_mul_ps(daeu_SWZ(a_, 1,1,2,2), daeu_SWZ(b_, 2,3,0,1)))
+#define daeu_MAT2MULADJ(a_, b_) \
+    _mm256_sub_ps( \
+        _mm256_mul_ps(a_, daeu_SWZ(b_, 3,0,3,0)), \
+        _mm256_mul_ps(daeu_SWZ(a_, 1,0,3,2), daeu_SWZ(b_, 2,1,2,1)))
+#define daeu_LOAD2(m0_, m1_) \
+    _mm256_insertf128_ps( \
+        _mm256_castps128_ps256(_mm_loadu_ps(m0_)), _mm_loadu_ps(m1_), 1)
+#define daeu_STORE2(m0_, m1_, v_) \
+    _mm_storeu_ps(m0_, _mm256_castps256_ps128(v_)); \
+    _mm_storeu_ps(m1_, _mm256_extractf128_ps(v_, 1))
+
+static daeu_AVX_FN void daeu_matrix_invert2_avx(
+    const float* m0,
+    const float* m1,
+    float* out0,
+    float* out1)
+{
+    // the SSE block inverse with each 128 bit lane working on a different
+    // matrix, since every shuffle it uses stays within a lane
+    __m256 r0 = daeu_LOAD2(m0 + 0, m1 + 0);
+    __m256 r1 = daeu_LOAD2(m0 + 4, m1 + 4);
+    __m256 r2 = daeu_LOAD2(m0 + 8, m1 + 8);
+    __m256 r3 = daeu_LOAD2(m0 + 12, m1 + 12);
+    __m256 a = daeu_MOVELH(r0, r1);
+    __m256 b = daeu_MOVEHL(r1, r0);
+    __m256 c = daeu_MOVELH(r2, r3);
+    __m256 d = daeu_MOVEHL(r3, r2);
+    __m256 detsub, deta, detb, detc, detd, dc, ab, x, y, z, w, detm, tr;
+    detsub = _mm256_sub_ps(
+        _mm256_mul_ps(
+            _mm256_shuffle_ps(r0, r2, daeu_SHUF(0,2,0,2)),
+            _mm256_shuffle_ps(r1, r3, daeu_SHUF(1,3,1,3))),
+        _mm256_mul_ps(
+            _mm256_shuffle_ps(r0, r2, daeu_SHUF(1,3,1,3)),
+            _mm256_shuffle_ps(r1, r3, daeu_SHUF(0,2,0,2))));
+    deta = daeu_SWZ(detsub, 0,0,0,0);
+    detb = daeu_SWZ(detsub, 1,1,1,1);
+    detc = daeu_SWZ(detsub, 2,2,2,2);
+    detd = daeu_SWZ(detsub, 3,3,3,3);
+    dc = daeu_MAT2ADJMUL(d, c);
+    ab = daeu_MAT2ADJMUL(a, b);
+    x = _mm256_sub_ps(_mm256_mul_ps(detd, a), daeu_MAT2MUL(b, dc));
+    w = _mm256_sub_ps(_mm256_mul_ps(deta, d), daeu_MAT2MUL(c, ab));
+    y = _mm256_sub_ps(_mm256_mul_ps(detb, c), daeu_MAT2MULADJ(d, ab));
+    z = _mm256_sub_ps(_mm256_mul_ps(detc, b), daeu_MAT2MULADJ(a, dc));
+    detm = _mm256_add_ps(
+        _mm256_mul_ps(deta, detd),
+        _mm256_mul_ps(detb, detc));
+    tr = _mm256_mul_ps(ab, daeu_SWZ(dc, 0,2,1,3));
+    tr = _mm256_add_ps(tr, daeu_SWZ(tr, 1,0,3,2));
+    tr = _mm256_add_ps(tr, daeu_SWZ(tr, 2,3,0,1));
+    detm = _mm256_div_ps(
+        _mm256_setr_ps(1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f),
+        _mm256_sub_ps(detm, tr));
+    x = _mm256_mul_ps(x, detm);
+    y = _mm256_mul_ps(y, detm);
+    z = _mm256_mul_ps(z, detm);
+    w = _mm256_mul_ps(w, detm);
+    r0 = _mm256_shuffle_ps(x, y, daeu_SHUF(3,1,3,1));
+    r1 = _mm256_shuffle_ps(x, y, daeu_SHUF(2,0,2,0));
+    r2 = _mm256_shuffle_ps(z, w, daeu_SHUF(3,1,3,1));
+    r3 = _mm256_shuffle_ps(z, w, daeu_SHUF(2,0,2,0));
+    daeu_STORE2(out0 + 0, out1 + 0, r0);
+    daeu_STORE2(out0 + 4, out1 + 4, r1);
+    daeu_STORE2(out0 + 8, out1 + 8, r2);
+    daeu_STORE2(out0 + 12, out1 + 12, r3);
+}
+
+#undef daeu_STORE2
+#undef daeu_LOAD2
+#undef daeu_MAT2MULADJ
+#undef daeu_MAT2ADJMUL
+#undef daeu_MAT2MUL
+#undef daeu_MOVEHL
+#undef daeu_MOVELH
+#undef daeu_SWZ
+#undef daeu_SHUF
+#endif
+
+//****************************************************************************
+#ifdef daeu_AVX
+static daeu_AVX_FN void daeu_matrix_compose_batch_avx(
+    const int* parents,
+    const float* local,
+    float* world,
+    size_t count)
+{
+    size_t i;
+    for(i = 0; i < count; ++i)
+    {
+        if(parents[i] < 0)
+        {
+            memcpy(world + i*16, local + i*16, 16*sizeof(float));
+        }
+        else
+        {
+            daeu_matrix_multiply_avx(
+                world + parents[i]*16,
+                local + i*16,
+                world + i*16);
+        }
+    }
+}
+#endif
+
+//****************************************************************************
+#ifdef daeu_AVX
+static daeu_AVX_FN void daeu_matrix_invert_batch_avx(
+    const float* m,
+    float* out,
+    size_t count)
+{
+    size_t i;
+    for(i = 0; i + 1 < count; i += 2)
+    {
+        daeu_matrix_invert2_avx(
+            m + i*16,
+            m + i*16 + 16,
+            out + i*16,
+            out + i*16 + 16);
+    }
+    if(i < count)
+    {
+        daeu_matrix_invert_sse(m + i*16, out + i*16);
+    }
+}
+#endif
+
+//****************************************************************************
+#ifdef daeu_AVX
+static daeu_AVX_FN void daeu_matrix_multiply_batch_avx(
+    const float* a,
+    const float* b,
+    float* out,
+    size_t count)
+{
+    size_t i;
+    for(i = 0; i < count; ++i)
+    {
+        daeu_matrix_multiply_avx(a + i*16, b + i*16, out + i*16);
+    }
+}
+#endif
+
+//****************************************************************************
+#ifdef daeu_AVX
+static int daeu_matrix_detect_avx()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    // AVX and OSXSAVE, then the OS must be saving the xmm and ymm state
+    if((info[2] & (1 << 28)) == 0 || (info[2] & (1 << 27)) == 0)
+    {
+        return 0;
+    }
+    return (_xgetbv(0) & 6) == 6;
+#else
+    return __builtin_cpu_supports("avx") != 0;
+#endif
+}
+
+//****************************************************************************
+static int daeu_matrix_has_avx()
+{
+    // the kernels ask on every call, so cpuid is only run by the first
+    // callers. any that race it detect the same answer and store it again
+    static volatile long s_avx = -1;
+    long avx = daeu_ATOMIC_LOAD(&s_avx);
+    if(avx < 0)
+    {
+        avx = daeu_matrix_detect_avx();
+        daeu_ATOMIC_STORE(&s_avx, avx);
+    }
+    return (int) avx;
+}
+#endif
+
+//****************************************************************************
+static void daeu_matrix_invert(
+    const float* m,
+    float* out)
+{
+#ifdef daeu_SSE
+    daeu_matrix_invert_sse(m, out);
+#else
+    daeu_matrix_invert_scalar(m, out);
+#endif
+}
+
+//****************************************************************************
+static void daeu_matrix_multiply(
+    const float* a,
+    const float* b,
+    float* out)
+{
+#ifdef daeu_SSE
+    daeu_matrix_multiply_sse(a, b, out);
+#else
+    daeu_matrix_multiply_scalar(a, b, out);
+#endif
 }
 
 //****************************************************************************
@@ -119,13 +1119,1474 @@ void daeu_lookat_to_matrix(
 }
 
 //****************************************************************************
-void daeu_rotate_to_matrix(
-    const dae_rotate_type* rotate,
-    float* mtx_out)
+void daeu_matrix_compose_batch(
+    const int* parents,
+    const float* local,
+    float* world,
+    size_t count)
 {
-    const float* axis = rotate->data;
-    float rad = rotate->data[3] * (3.14159265f/180.0f);
-    float c = cosf(rad);
+    size_t i;
+#ifdef daeu_AVX
+    if(daeu_matrix_has_avx())
+    {
+        daeu_matrix_compose_batch_avx(parents, local, world, count);
+        return;
+    }
+#endif
+    for(i = 0; i < count; ++i)
+    {
+        if(parents[i] < 0)
+        {
+            memcpy(world + i*16, local + i*16, 16*sizeof(float));
+        }
+        else
+        {
+            daeu_matrix_multiply(
+                world + parents[i]*16,
+                local + i*16,
+                world + i*16);
+        }
+    }
+}
+
+//****************************************************************************
+void daeu_matrix_invert_batch(
+    const float* m,
+    float* out,
+    size_t count)
+{
+    size_t i;
+#ifdef daeu_AVX
+    if(daeu_matrix_has_avx())
+    {
+        daeu_matrix_invert_batch_avx(m, out, count);
+        return;
+    }
+#endif
+    for(i = 0; i < count; ++i)
+    {
+        daeu_matrix_invert(m + i*16, out + i*16);
+    }
+}
+
+//****************************************************************************
+void daeu_matrix_multiply_batch(
+    const float* a,
+    const float* b,
+    float* out,
+    size_t count)
+{
+    size_t i;
+#ifdef daeu_AVX
+    if(daeu_matrix_has_avx())
+    {
+        daeu_matrix_multiply_batch_avx(a, b, out, count);
+        return;
+    }
+#endif
+    for(i = 0; i < count; ++i)
+    {
+        daeu_matrix_multiply(a + i*16, b + i*16, out + i*16);
+    }
+}
+
+//****************************************************************************
+static int daeu_prim_get_inputs(
+    dae_obj_ptr prim,
+    dae_input_local_offset_type*** inputs_out,
+    size_t* numinputs_out,
+    const char** material_out)
+{
+    int result = 1;
+#define daeu_PRIM_INPUTS(type_) \
+    { \
+        type_* p_ = (type_*) prim; \
+        *inputs_out = p_->el_input.values; \
+        *numinputs_out = p_->el_input.size; \
+        *material_out = (p_->at_material!=NULL) ? *p_->at_material : NULL; \
+    }
+    switch(dae_get_typeid(prim))
+    {
+    case dae_ID_POLYGONS_TYPE:
+        daeu_PRIM_INPUTS(dae_polygons_type);
+        break;
+    case dae_ID_POLYLIST_TYPE:
+        daeu_PRIM_INPUTS(dae_polylist_type);
+        break;
+    case dae_ID_TRIANGLES_TYPE:
+        daeu_PRIM_INPUTS(dae_triangles_type);
+        break;
+    case dae_ID_TRIFANS_TYPE:
+        daeu_PRIM_INPUTS(dae_trifans_type);
+        break;
+    case dae_ID_TRISTRIPS_TYPE:
+        daeu_PRIM_INPUTS(dae_tristrips_type);
+        break;
+    default:
+        *inputs_out = NULL;
+        *numinputs_out = 0;
+        *material_out = NULL;
+        result = 0;
+        break;
+    }
+#undef daeu_PRIM_INPUTS
+    return result;
+}
+
+//****************************************************************************
+static dae_source_type* daeu_find_source(
+    dae_source_type** sources,
+    size_t numsources,
+    const char* uri)
+{
+    // urifragments reference sources by id within the parent element
+    dae_source_type* result = NULL;
+    size_t i;
+    if(uri != NULL && *uri == '#')
+    {
+        ++uri;
+        for(i = 0; i < numsources; ++i)
+        {
+            dae_source_type* src = sources[i];
+            if(src->at_id != NULL && *src->at_id != NULL)
+            {
+                if(!strcmp(*src->at_id, uri))
+                {
+                    result = src;
+                    break;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+static dae_source_type* daeu_mesh_find_source(
+    dae_mesh_type* mesh,
+    const char* uri)
+{
+    return daeu_find_source(mesh->el_source.values, mesh->el_source.size, uri);
+}
+
+//****************************************************************************
+static int daeu_mesh_bind_source(
+    dae_source_type* src,
+    unsigned tupleoffset,
+    daeu_mesh_binding* binding_out)
+{
+    int result = 0;
+    if(src != NULL && src->el_float_array != NULL)
+    {
+        dae_accessor_type* acc = NULL;
+        daeu_mesh_binding* b = binding_out;
+        memset(b, 0, sizeof(*b));
+        b->data = src->el_float_array->data.values;
+        b->datalen = src->el_float_array->data.size;
+        b->stride = 1;
+        if(src->el_technique_common != NULL)
+        {
+            acc = src->el_technique_common->el_accessor;
+        }
+        if(acc != NULL)
+        {
+            size_t i;
+            if(acc->at_stride != NULL && *acc->at_stride > 0)
+            {
+                b->stride = *acc->at_stride;
+            }
+            if(acc->at_offset != NULL)
+            {
+                b->offset = *acc->at_offset;
+            }
+            // unnamed params are skipped per the spec
+            for(i = 0; i < acc->el_param.size; ++i)
+            {
+                dae_param_type* param = acc->el_param.values[i];
+                if(param->at_name != NULL && *param->at_name != NULL)
+                {
+                    if(b->numparams < sizeof(b->params)/sizeof(*b->params))
+                    {
+                        b->params[b->numparams] = (unsigned) i;
+                        ++b->numparams;
+                    }
+                }
+            }
+        }
+        if(b->numparams == 0)
+        {
+            // no usable params, treat every value within the stride as one
+            size_t n = sizeof(b->params)/sizeof(*b->params);
+            n = (b->stride < n) ? b->stride : n;
+            for(b->numparams = 0; b->numparams < n; ++b->numparams)
+            {
+                b->params[b->numparams] = b->numparams;
+            }
+        }
+        b->count = (b->datalen > b->offset)
+            ? (b->datalen - b->offset) / b->stride
+            : 0;
+        if(acc != NULL && acc->at_count != NULL && *acc->at_count < b->count)
+        {
+            b->count = *acc->at_count;
+        }
+        b->tupleoffset = tupleoffset;
+        result = 1;
+    }
+    return result;
+}
+
+//****************************************************************************
+static int daeu_mesh_bind_input(
+    dae_mesh_type* mesh,
+    dae_input_local_offset_type** inputs,
+    size_t numinputs,
+    const daeu_mesh_attrib* attrib,
+    daeu_mesh_binding* binding_out)
+{
+    int result = 0;
+    size_t i;
+    for(i = 0; i < numinputs && !result; ++i)
+    {
+        dae_input_local_offset_type* in = inputs[i];
+        const char* semantic;
+        const char* source;
+        unsigned offset;
+        if(in->at_semantic == NULL || in->at_source == NULL)
+        {
+            continue;
+        }
+        semantic = *in->at_semantic;
+        source = *in->at_source;
+        offset = (in->at_offset != NULL) ? *in->at_offset : 0;
+        if(semantic == NULL)
+        {
+            continue;
+        }
+        if(!strcmp(semantic, "VERTEX") && mesh->el_vertices != NULL)
+        {
+            // the vertices element shares a single index for all inputs
+            dae_vertices_type* verts = mesh->el_vertices;
+            size_t j;
+            for(j = 0; j < verts->el_input.size && !result; ++j)
+            {
+                dae_input_local_type* vin = verts->el_input.values[j];
+                if(vin->at_semantic != NULL && *vin->at_semantic != NULL &&
+                   vin->at_source != NULL &&
+                   !strcmp(*vin->at_semantic, attrib->semantic))
+                {
+                    result = daeu_mesh_bind_source(
+                        daeu_mesh_find_source(mesh, *vin->at_source),
+                        offset,
+                        binding_out);
+                }
+            }
+        }
+        else if(!strcmp(semantic, attrib->semantic))
+        {
+            int set = (in->at_set != NULL) ? (int) *in->at_set : 0;
+            if(attrib->set < 0 || attrib->set == set)
+            {
+                result = daeu_mesh_bind_source(
+                    daeu_mesh_find_source(mesh, source),
+                    offset,
+                    binding_out);
+            }
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+static unsigned daeu_mesh_calc_tuplesize(
+    dae_input_local_offset_type** inputs,
+    size_t numinputs)
+{
+    // the number of indices per vertex is one more than the largest offset
+    unsigned tuplesize = 0;
+    size_t i;
+    for(i = 0; i < numinputs; ++i)
+    {
+        dae_input_local_offset_type* in = inputs[i];
+        unsigned off = (in->at_offset != NULL) ? *in->at_offset : 0;
+        if(off + 1 > tuplesize)
+        {
+            tuplesize = off + 1;
+        }
+    }
+    return tuplesize;
+}
+
+//****************************************************************************
+static size_t daeu_tri_count_ph(
+    dae_polygons_type_ph* ph,
+    unsigned tuplesize)
+{
+    // bridging each hole into the outer ring adds two vertices
+    size_t n = 0;
+    if(ph->el_p != NULL && ph->el_p->data.size/tuplesize >= 3)
+    {
+        size_t i;
+        n = ph->el_p->data.size/tuplesize;
+        for(i = 0; i < ph->el_h.size; ++i)
+        {
+            size_t h = ph->el_h.values[i]->data.size/tuplesize;
+            if(h >= 3)
+            {
+                n += h + 2;
+            }
+        }
+        n -= 2;
+    }
+    return n;
+}
+
+//****************************************************************************
+static size_t daeu_tri_count_p(
+    dae_p_type** p,
+    size_t nump,
+    unsigned tuplesize)
+{
+    // each polygon, fan or strip of n vertices produces n-2 triangles
+    size_t n = 0;
+    size_t i;
+    for(i = 0; i < nump; ++i)
+    {
+        size_t nv = p[i]->data.size/tuplesize;
+        if(nv >= 3)
+        {
+            n += nv - 2;
+        }
+    }
+    return n;
+}
+
+//****************************************************************************
+static size_t daeu_tri_count(
+    dae_obj_ptr prim,
+    unsigned tuplesize)
+{
+    size_t numtris = 0;
+    size_t i;
+    switch(dae_get_typeid(prim))
+    {
+    case dae_ID_POLYGONS_TYPE:
+        {
+            dae_polygons_type* poly = (dae_polygons_type*) prim;
+            numtris = daeu_tri_count_p(
+                poly->el_p.values,
+                poly->el_p.size,
+                tuplesize);
+            for(i = 0; i < poly->el_ph.size; ++i)
+            {
+                numtris += daeu_tri_count_ph(poly->el_ph.values[i],tuplesize);
+            }
+        }
+        break;
+    case dae_ID_POLYLIST_TYPE:
+        {
+            dae_polylist_type* poly = (dae_polylist_type*) prim;
+            if(poly->el_vcount != NULL && poly->el_p != NULL)
+            {
+                const unsigned* vc = poly->el_vcount->data.values;
+                size_t nvc = poly->el_vcount->data.size;
+                size_t avail = poly->el_p->data.size/tuplesize;
+                for(i = 0; i < nvc && vc[i] <= avail; ++i)
+                {
+                    numtris += (vc[i] >= 3) ? vc[i] - 2 : 0;
+                    avail -= vc[i];
+                }
+            }
+        }
+        break;
+    case dae_ID_TRIANGLES_TYPE:
+        {
+            dae_triangles_type* tri = (dae_triangles_type*) prim;
+            if(tri->el_p != NULL)
+            {
+                numtris = tri->el_p->data.size/tuplesize/3;
+            }
+        }
+        break;
+    case dae_ID_TRIFANS_TYPE:
+        {
+            dae_trifans_type* fan = (dae_trifans_type*) prim;
+            numtris = daeu_tri_count_p(
+                fan->el_p.values,
+                fan->el_p.size,
+                tuplesize);
+        }
+        break;
+    case dae_ID_TRISTRIPS_TYPE:
+        {
+            dae_tristrips_type* strip = (dae_tristrips_type*) prim;
+            numtris = daeu_tri_count_p(
+                strip->el_p.values,
+                strip->el_p.size,
+                tuplesize);
+        }
+        break;
+    default:
+        break;
+    }
+    return numtris;
+}
+
+//****************************************************************************
+static void daeu_tri_reserve(
+    daeu_tri_scratch* scratch,
+    size_t n)
+{
+    // scratch space is shared by all polygons of a primitive element
+    if(n > scratch->cap)
+    {
+        size_t cap = (n + 63) & ~63;
+        scratch->ring = (const unsigned**) realloc(
+            (void*) scratch->ring,
+            cap*sizeof(*scratch->ring));
+        scratch->xy = (float*) realloc(scratch->xy, cap*2*sizeof(float));
+        scratch->prev = (int*) realloc(scratch->prev, cap*sizeof(int));
+        scratch->next = (int*) realloc(scratch->next, cap*sizeof(int));
+        scratch->cap = cap;
+    }
+}
+
+//****************************************************************************
+static unsigned* daeu_tri_emit(
+    unsigned* out,
+    const unsigned* a,
+    const unsigned* b,
+    const unsigned* c,
+    unsigned tuplesize)
+{
+    memcpy(out, a, tuplesize*sizeof(*out));
+    out += tuplesize;
+    memcpy(out, b, tuplesize*sizeof(*out));
+    out += tuplesize;
+    memcpy(out, c, tuplesize*sizeof(*out));
+    out += tuplesize;
+    return out;
+}
+
+//****************************************************************************
+static unsigned* daeu_tri_fan(
+    unsigned* out,
+    const unsigned* p,
+    size_t nv,
+    unsigned tuplesize)
+{
+    size_t i;
+    for(i = 2; i < nv; ++i)
+    {
+        out = daeu_tri_emit(
+            out,
+            p,
+            p + (i-1)*tuplesize,
+            p + i*tuplesize,
+            tuplesize);
+    }
+    return out;
+}
+
+//****************************************************************************
+static void daeu_tri_get_position(
+    const daeu_mesh_binding* pos,
+    const unsigned* tuple,
+    float* xyz_out)
+{
+    size_t idx = tuple[pos->tupleoffset];
+    unsigned k;
+    xyz_out[0] = 0.0f; xyz_out[1] = 0.0f; xyz_out[2] = 0.0f;
+    if(idx < pos->count)
+    {
+        size_t base = pos->offset + idx*pos->stride;
+        for(k = 0; k < 3 && k < pos->numparams; ++k)
+        {
+            size_t i = base + pos->params[k];
+            xyz_out[k] = (i < pos->datalen) ? pos->data[i] : 0.0f;
+        }
+    }
+}
+
+//****************************************************************************
+static float daeu_tri_cross2(
+    const float* a,
+    const float* b,
+    const float* c)
+{
+    return (b[0]-a[0])*(c[1]-a[1]) - (b[1]-a[1])*(c[0]-a[0]);
+}
+
+//****************************************************************************
+static void daeu_tri_bridge(
+    daeu_tri_scratch* scratch,
+    size_t* n,
+    const unsigned* hole,
+    const float* holexy,
+    size_t nh,
+    unsigned tuplesize)
+{
+    // joins a hole to the ring by cutting from the rightmost hole vertex to
+    // a visible ring vertex, duplicating both ends of the cut
+    const float* m;
+    float ix = 0.0f;
+    size_t nr = *n;
+    size_t mi = 0;
+    size_t pi = 0;
+    size_t i;
+    int found = 0;
+    for(i = 1; i < nh; ++i)
+    {
+        if(holexy[i*2] > holexy[mi*2])
+        {
+            mi = i;
+        }
+    }
+    m = holexy + mi*2;
+    // cast a ray towards +x and find the nearest ring edge it hits
+    for(i = 0; i < nr; ++i)
+    {
+        const float* a = scratch->xy + i*2;
+        const float* b = scratch->xy + ((i+1)%nr)*2;
+        if((a[1] <= m[1] && b[1] >= m[1]) || (b[1] <= m[1] && a[1] >= m[1]))
+        {
+            float x;
+            if(a[1] == b[1])
+            {
+                x = (a[0] > b[0]) ? b[0] : a[0];
+            }
+            else
+            {
+                x = a[0] + (m[1]-a[1])*(b[0]-a[0])/(b[1]-a[1]);
+            }
+            if(x >= m[0] && (!found || x < ix))
+            {
+                ix = x;
+                pi = (a[0] > b[0]) ? i : (i+1)%nr;
+                found = 1;
+            }
+        }
+    }
+    if(found)
+    {
+        // a ring vertex inside the triangle formed by the hole vertex, the
+        // hit point and the candidate would block the cut, so prefer the
+        // one closest in angle to the ray
+        float tri[6];
+        float best = -1.0f;
+        size_t cand = pi;
+        tri[0] = m[0]; tri[1] = m[1];
+        tri[2] = ix; tri[3] = m[1];
+        tri[4] = scratch->xy[pi*2]; tri[5] = scratch->xy[pi*2+1];
+        for(i = 0; i < nr; ++i)
+        {
+            const float* v = scratch->xy + i*2;
+            float d0 = daeu_tri_cross2(tri + 0, tri + 2, v);
+            float d1 = daeu_tri_cross2(tri + 2, tri + 4, v);
+            float d2 = daeu_tri_cross2(tri + 4, tri + 0, v);
+            int neg = (d0 < 0.0f) || (d1 < 0.0f) || (d2 < 0.0f);
+            int pos = (d0 > 0.0f) || (d1 > 0.0f) || (d2 > 0.0f);
+            if(i != cand && !(neg && pos) && v[0] >= m[0])
+            {
+                float dx = v[0] - m[0];
+                float dy = v[1] - m[1];
+                float len = sqrtf(dx*dx + dy*dy);
+                float c = (len > 0.0f) ? dx/len : 1.0f;
+                if(c > best)
+                {
+                    best = c;
+                    pi = i;
+                }
+            }
+        }
+    }
+    else
+    {
+        // degenerate input, fall back to the nearest ring vertex
+        float best = -1.0f;
+        for(i = 0; i < nr; ++i)
+        {
+            float dx = scratch->xy[i*2] - m[0];
+            float dy = scratch->xy[i*2+1] - m[1];
+            if(best < 0.0f || dx*dx + dy*dy < best)
+            {
+                best = dx*dx + dy*dy;
+                pi = i;
+            }
+        }
+    }
+    // open a gap of nh+2 vertices after the ring vertex
+    memmove(
+        (void*) (scratch->ring + pi + nh + 3),
+        (void*) (scratch->ring + pi + 1),
+        (nr - pi - 1)*sizeof(*scratch->ring));
+    memmove(
+        scratch->xy + (pi + nh + 3)*2,
+        scratch->xy + (pi + 1)*2,
+        (nr - pi - 1)*2*sizeof(float));
+    for(i = 0; i <= nh; ++i)
+    {
+        size_t hi = (mi + i) % nh;
+        scratch->ring[pi + 1 + i] = hole + hi*tuplesize;
+        scratch->xy[(pi + 1 + i)*2 + 0] = holexy[hi*2 + 0];
+        scratch->xy[(pi + 1 + i)*2 + 1] = holexy[hi*2 + 1];
+    }
+    scratch->ring[pi + nh + 2] = scratch->ring[pi];
+    scratch->xy[(pi + nh + 2)*2 + 0] = scratch->xy[pi*2 + 0];
+    scratch->xy[(pi + nh + 2)*2 + 1] = scratch->xy[pi*2 + 1];
+    *n = nr + nh + 2;
+}
+
+//****************************************************************************
+static unsigned* daeu_tri_earclip(
+    unsigned* out,
+    daeu_tri_scratch* scratch,
+    size_t n,
+    unsigned tuplesize)
+{
+    // the ring is counter clockwise in the xy plane
+    const float* xy = scratch->xy;
+    int* prev = scratch->prev;
+    int* next = scratch->next;
+    size_t remaining = n;
+    size_t attempts = 0;
+    int i = 0;
+    size_t j;
+    for(j = 0; j < n; ++j)
+    {
+        prev[j] = (int) ((j + n - 1) % n);
+        next[j] = (int) ((j + 1) % n);
+    }
+    while(remaining > 3)
+    {
+        int ip = prev[i];
+        int in = next[i];
+        const float* a = xy + ip*2;
+        const float* b = xy + i*2;
+        const float* c = xy + in*2;
+        int isear = daeu_tri_cross2(a, b, c) > 0.0f;
+        if(isear)
+        {
+            // no other remaining vertex may lie within the ear
+            int k = next[in];
+            while(k != ip)
+            {
+                const float* v = xy + k*2;
+                int iscorner =
+                    (v[0]==a[0] && v[1]==a[1]) ||
+                    (v[0]==b[0] && v[1]==b[1]) ||
+                    (v[0]==c[0] && v[1]==c[1]);
+                if(!iscorner &&
+                   daeu_tri_cross2(a, b, v) >= 0.0f &&
+                   daeu_tri_cross2(b, c, v) >= 0.0f &&
+                   daeu_tri_cross2(c, a, v) >= 0.0f)
+                {
+                    isear = 0;
+                    break;
+                }
+                k = next[k];
+            }
+        }
+        if(isear || attempts > remaining)
+        {
+            // clip the ear, or force a clip if none can be found so that
+            // degenerate input still produces the expected triangle count
+            out = daeu_tri_emit(
+                out,
+                scratch->ring[ip],
+                scratch->ring[i],
+                scratch->ring[in],
+                tuplesize);
+            next[ip] = in;
+            prev[in] = ip;
+            --remaining;
+            attempts = 0;
+            i = ip;
+        }
+        else
+        {
+            ++attempts;
+            i = in;
+        }
+    }
+    out = daeu_tri_emit(
+        out,
+        scratch->ring[prev[i]],
+        scratch->ring[i],
+        scratch->ring[next[i]],
+        tuplesize);
+    return out;
+}
+
+//****************************************************************************
+static unsigned* daeu_tri_ph(
+    unsigned* out,
+    dae_polygons_type_ph* ph,
+    const daeu_mesh_binding* pos,
+    daeu_tri_scratch* scratch,
+    unsigned tuplesize)
+{
+    const unsigned* outer = ph->el_p->data.values;
+    size_t no = ph->el_p->data.size/tuplesize;
+    size_t total = no;
+    size_t n = no;
+    float normal[3] = { 0.0f, 0.0f, 0.0f };
+    float* holexy;
+    int* done;
+    int u = 0;
+    int v = 1;
+    size_t i;
+    size_t h;
+    if(pos == NULL)
+    {
+        // without positions the holes cannot be placed, fill the outline
+        return daeu_tri_fan(out, outer, no, tuplesize);
+    }
+    for(h = 0; h < ph->el_h.size; ++h)
+    {
+        size_t nh = ph->el_h.values[h]->data.size/tuplesize;
+        total += (nh >= 3) ? nh + 2 : 0;
+    }
+    // hole coordinates and flags are stored past the end of the ring
+    daeu_tri_reserve(scratch, total*2 + ph->el_h.size);
+    holexy = scratch->xy + total*2;
+    done = scratch->prev + total;
+    // project onto the plane most perpendicular to the newell normal
+    for(i = 0; i < no; ++i)
+    {
+        float a[3];
+        float b[3];
+        daeu_tri_get_position(pos, outer + i*tuplesize, a);
+        daeu_tri_get_position(pos, outer + ((i+1)%no)*tuplesize, b);
+        normal[0] += (a[1] - b[1])*(a[2] + b[2]);
+        normal[1] += (a[2] - b[2])*(a[0] + b[0]);
+        normal[2] += (a[0] - b[0])*(a[1] + b[1]);
+    }
+    if(fabsf(normal[0]) > fabsf(normal[1]) &&
+       fabsf(normal[0]) > fabsf(normal[2]))
+    {
+        u = 1; v = 2;
+        if(normal[0] < 0.0f) { u = 2; v = 1; }
+    }
+    else if(fabsf(normal[1]) > fabsf(normal[2]))
+    {
+        u = 2; v = 0;
+        if(normal[1] < 0.0f) { u = 0; v = 2; }
+    }
+    else if(normal[2] < 0.0f)
+    {
+        u = 1; v = 0;
+    }
+    for(i = 0; i < no; ++i)
+    {
+        float a[3];
+        daeu_tri_get_position(pos, outer + i*tuplesize, a);
+        scratch->ring[i] = outer + i*tuplesize;
+        scratch->xy[i*2 + 0] = a[u];
+        scratch->xy[i*2 + 1] = a[v];
+    }
+    for(h = 0; h < ph->el_h.size; ++h)
+    {
+        done[h] = 0;
+    }
+    while(1)
+    {
+        // bridge holes from right to left so earlier cuts stay visible
+        const unsigned* hole = NULL;
+        float bestx = 0.0f;
+        float area = 0.0f;
+        size_t best = 0;
+        size_t nh = 0;
+        for(h = 0; h < ph->el_h.size; ++h)
+        {
+            dae_list_of_uints_type* hl = ph->el_h.values[h];
+            size_t hn = hl->data.size/tuplesize;
+            if(!done[h] && hn >= 3)
+            {
+                for(i = 0; i < hn; ++i)
+                {
+                    float a[3];
+                    daeu_tri_get_position(pos, hl->data.values+i*tuplesize, a);
+                    if(hole == NULL || a[u] > bestx)
+                    {
+                        hole = hl->data.values;
+                        bestx = a[u];
+                        best = h;
+                        nh = hn;
+                    }
+                }
+            }
+        }
+        if(hole == NULL)
+        {
+            break;
+        }
+        done[best] = 1;
+        for(i = 0; i < nh; ++i)
+        {
+            float a[3];
+            daeu_tri_get_position(pos, hole + i*tuplesize, a);
+            holexy[i*2 + 0] = a[u];
+            holexy[i*2 + 1] = a[v];
+        }
+        for(i = 0; i < nh; ++i)
+        {
+            area += daeu_tri_cross2(holexy, holexy+i*2, holexy+((i+1)%nh)*2);
+        }
+        if(area > 0.0f)
+        {
+            // holes must wind opposite to the outline, so the bridge is
+            // built in reverse by mirroring the hole in place
+            for(i = 0; i < nh/2; ++i)
+            {
+                float t0 = holexy[i*2 + 0];
+                float t1 = holexy[i*2 + 1];
+                holexy[i*2 + 0] = holexy[(nh-1-i)*2 + 0];
+                holexy[i*2 + 1] = holexy[(nh-1-i)*2 + 1];
+                holexy[(nh-1-i)*2 + 0] = t0;
+                holexy[(nh-1-i)*2 + 1] = t1;
+            }
+            daeu_tri_bridge(scratch, &n, hole, holexy, nh, tuplesize);
+            // restore the tuple order of the mirrored hole
+            for(i = 0; i < n; ++i)
+            {
+                const unsigned* t = scratch->ring[i];
+                if(t >= hole && t < hole + nh*tuplesize)
+                {
+                    size_t k = (t - hole)/tuplesize;
+                    scratch->ring[i] = hole + (nh-1-k)*tuplesize;
+                }
+            }
+        }
+        else
+        {
+            daeu_tri_bridge(scratch, &n, hole, holexy, nh, tuplesize);
+        }
+    }
+    return daeu_tri_earclip(out, scratch, n, tuplesize);
+}
+
+//****************************************************************************
+int daeu_triangulate(
+    dae_mesh_type* mesh,
+    dae_obj_ptr prim,
+    daeu_tris* tris_out)
+{
+    dae_input_local_offset_type** inputs;
+    const char* material;
+    daeu_tri_scratch scratch;
+    daeu_mesh_binding posbinding;
+    const daeu_mesh_binding* pos = NULL;
+    dae_obj_typeid primtype = dae_get_typeid(prim);
+    size_t numinputs;
+    size_t numtris = 0;
+    unsigned tuplesize;
+    unsigned* out;
+    size_t i;
+    memset(tris_out, 0, sizeof(*tris_out));
+    memset(&scratch, 0, sizeof(scratch));
+    if(!daeu_prim_get_inputs(prim, &inputs, &numinputs, &material))
+    {
+        return -1;
+    }
+    tuplesize = daeu_mesh_calc_tuplesize(inputs, numinputs);
+    tris_out->tuplesize = tuplesize;
+    if(tuplesize == 0)
+    {
+        return 0;
+    }
+    // count first so the output is allocated exactly once
+    numtris = daeu_tri_count(prim, tuplesize);
+    if(primtype == dae_ID_POLYGONS_TYPE)
+    {
+        dae_polygons_type* poly = (dae_polygons_type*) prim;
+        daeu_mesh_attrib at;
+        at.semantic = "POSITION";
+        at.set = -1;
+        if(poly->el_ph.size > 0 &&
+           daeu_mesh_bind_input(mesh, inputs, numinputs, &at, &posbinding))
+        {
+            pos = &posbinding;
+        }
+    }
+    out = (unsigned*) malloc((numtris*3*tuplesize + 1)*sizeof(*out));
+    tris_out->indices = out;
+    switch(primtype)
+    {
+    case dae_ID_POLYGONS_TYPE:
+        {
+            dae_polygons_type* poly = (dae_polygons_type*) prim;
+            for(i = 0; i < poly->el_p.size; ++i)
+            {
+                dae_p_type* p = poly->el_p.values[i];
+                out = daeu_tri_fan(
+                    out,
+                    p->data.values,
+                    p->data.size/tuplesize,
+                    tuplesize);
+            }
+            for(i = 0; i < poly->el_ph.size; ++i)
+            {
+                dae_polygons_type_ph* ph = poly->el_ph.values[i];
+                if(daeu_tri_count_ph(ph, tuplesize) > 0)
+                {
+                    out = daeu_tri_ph(out, ph, pos, &scratch, tuplesize);
+                }
+            }
+        }
+        break;
+    case dae_ID_POLYLIST_TYPE:
+        if(numtris > 0)
+        {
+            dae_polylist_type* poly = (dae_polylist_type*) prim;
+            const unsigned* vc = poly->el_vcount->data.values;
+            const unsigned* p = poly->el_p->data.values;
+            size_t nvc = poly->el_vcount->data.size;
+            size_t avail = poly->el_p->data.size/tuplesize;
+            for(i = 0; i < nvc && vc[i] <= avail; ++i)
+            {
+                out = daeu_tri_fan(out, p, vc[i], tuplesize);
+                p += vc[i]*tuplesize;
+                avail -= vc[i];
+            }
+        }
+        break;
+    case dae_ID_TRIANGLES_TYPE:
+        if(numtris > 0)
+        {
+            dae_triangles_type* tri = (dae_triangles_type*) prim;
+            memcpy(
+                out,
+                tri->el_p->data.values,
+                numtris*3*tuplesize*sizeof(*out));
+            out += numtris*3*tuplesize;
+        }
+        break;
+    case dae_ID_TRIFANS_TYPE:
+        {
+            dae_trifans_type* fan = (dae_trifans_type*) prim;
+            for(i = 0; i < fan->el_p.size; ++i)
+            {
+                dae_p_type* p = fan->el_p.values[i];
+                out = daeu_tri_fan(
+                    out,
+                    p->data.values,
+                    p->data.size/tuplesize,
+                    tuplesize);
+            }
+        }
+        break;
+    case dae_ID_TRISTRIPS_TYPE:
+        {
+            dae_tristrips_type* strip = (dae_tristrips_type*) prim;
+            for(i = 0; i < strip->el_p.size; ++i)
+            {
+                dae_p_type* p = strip->el_p.values[i];
+                const unsigned* v = p->data.values;
+                size_t nv = p->data.size/tuplesize;
+                size_t j;
+                for(j = 2; j < nv; ++j)
+                {
+                    // every other triangle is flipped to preserve winding
+                    const unsigned* a = v + (j-2)*tuplesize;
+                    const unsigned* b = v + (j-1)*tuplesize;
+                    const unsigned* c = v + j*tuplesize;
+                    if(j & 1)
+                    {
+                        out = daeu_tri_emit(out, b, a, c, tuplesize);
+                    }
+                    else
+                    {
+                        out = daeu_tri_emit(out, a, b, c, tuplesize);
+                    }
+                }
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    tris_out->numtris = (out - tris_out->indices)/(3*tuplesize);
+    assert(tris_out->numtris <= numtris);
+    free((void*) scratch.ring);
+    free(scratch.xy);
+    free(scratch.prev);
+    free(scratch.next);
+    return 0;
+}
+
+//****************************************************************************
+void daeu_tris_destroy(
+    daeu_tris* tris)
+{
+    free(tris->indices);
+    memset(tris, 0, sizeof(*tris));
+}
+
+//****************************************************************************
+static unsigned daeu_mesh_hash(
+    const unsigned* key,
+    size_t keysize)
+{
+    unsigned h = 0x811c9dc5u;
+    size_t i;
+    for(i = 0; i < keysize; ++i)
+    {
+        h = (h ^ key[i]) * 0x01000193u;
+        h ^= h >> 15;
+    }
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+//****************************************************************************
+static void daeu_mesh_weld(
+    daeu_mesh* mesh,
+    const daeu_mesh_binding* bindings,
+    unsigned bindingset,
+    const unsigned* tuples,
+    size_t numcorners,
+    unsigned tuplesize,
+    unsigned* table,
+    size_t tablemask,
+    unsigned* keys)
+{
+    // tuples is a stream of numcorners index tuples, each tuplesize wide.
+    // the key for each corner is the binding set followed by the source
+    // index of each requested attribute
+    size_t numattribs = mesh->numattribs;
+    size_t keysize = numattribs + 1;
+    unsigned key[64];
+    size_t c;
+    for(c = 0; c < numcorners; ++c)
+    {
+        const unsigned* tuple = tuples + c*tuplesize;
+        unsigned vert;
+        size_t slot;
+        size_t a;
+        key[0] = bindingset;
+        for(a = 0; a < numattribs; ++a)
+        {
+            const daeu_mesh_binding* b = bindings + a;
+            key[a + 1] = (b->data != NULL) ? tuple[b->tupleoffset] : 0;
+        }
+        slot = daeu_mesh_hash(key, keysize) & tablemask;
+        while(1)
+        {
+            vert = table[slot];
+            if(vert == ~0u)
+            {
+                // new vertex, gather its attributes from the sources
+                float* v;
+                vert = (unsigned) mesh->numvertices;
+                table[slot] = vert;
+                memcpy(keys + vert*keysize, key, keysize*sizeof(*key));
+                v = mesh->vertices + vert*mesh->vertexsize;
+                for(a = 0; a < numattribs; ++a)
+                {
+                    const daeu_mesh_binding* b = bindings + a;
+                    const daeu_mesh_attrib* at = mesh->attribs + a;
+                    float* vat = v + at->offset;
+                    size_t idx = key[a + 1];
+                    unsigned k = 0;
+                    if(b->data != NULL && idx < b->count)
+                    {
+                        size_t base = b->offset + idx*b->stride;
+                        for(; k < at->size && k < b->numparams; ++k)
+                        {
+                            size_t pos = base + b->params[k];
+                            vat[k] = (pos < b->datalen) ? b->data[pos] : 0.0f;
+                        }
+                    }
+                    for(; k < at->size; ++k)
+                    {
+                        vat[k] = 0.0f;
+                    }
+                }
+                ++mesh->numvertices;
+                break;
+            }
+            if(!memcmp(keys + vert*keysize, key, keysize*sizeof(*key)))
+            {
+                break;
+            }
+            slot = (slot + 1) & tablemask;
+        }
+        mesh->indices[mesh->numindices] = vert;
+        ++mesh->numindices;
+    }
+}
+
+//****************************************************************************
+int daeu_mesh_compile(
+    dae_mesh_type* mesh,
+    const daeu_mesh_attrib* attribs,
+    size_t numattribs,
+    daeu_mesh* mesh_out)
+{
+    dae_obj_ptr* prims;
+    daeu_mesh_binding* bindings;
+    unsigned* bindingsets;
+    unsigned* tuplesizes;
+    unsigned* table;
+    unsigned* keys;
+    dae_obj_ptr el;
+    size_t numgroups = 0;
+    size_t numcorners = 0;
+    size_t tablesize;
+    size_t g;
+    size_t a;
+    int err = 0;
+
+    memset(mesh_out, 0, sizeof(*mesh_out));
+    if(numattribs + 1 > 64)
+    {
+        return -1;
+    }
+    // gather the polygonal primitive elements in document order
+    el = dae_get_first_element(mesh);
+    while(el != NULL)
+    {
+        dae_input_local_offset_type** inputs;
+        size_t numinputs;
+        const char* material;
+        numgroups += daeu_prim_get_inputs(el,&inputs,&numinputs,&material);
+        el = dae_get_next(el);
+    }
+    prims = (dae_obj_ptr*) malloc((numgroups + 1)*sizeof(*prims));
+    numgroups = 0;
+    el = dae_get_first_element(mesh);
+    while(el != NULL)
+    {
+        dae_input_local_offset_type** inputs;
+        size_t numinputs;
+        const char* material;
+        if(daeu_prim_get_inputs(el, &inputs, &numinputs, &material))
+        {
+            prims[numgroups] = el;
+            ++numgroups;
+        }
+        el = dae_get_next(el);
+    }
+    mesh_out->numattribs = numattribs;
+    mesh_out->numgroups = numgroups;
+    mesh_out->attribs = (daeu_mesh_attrib*) malloc(
+        (numattribs + 1)*sizeof(*mesh_out->attribs));
+    mesh_out->groups = (daeu_mesh_group*) malloc(
+        (numgroups + 1)*sizeof(*mesh_out->groups));
+    memcpy(mesh_out->attribs, attribs, numattribs*sizeof(*attribs));
+    bindings = (daeu_mesh_binding*) calloc(
+        numgroups*numattribs + 1, sizeof(*bindings));
+    bindingsets = (unsigned*) malloc((numgroups + 1)*sizeof(*bindingsets));
+    tuplesizes = (unsigned*) malloc((numgroups + 1)*sizeof(*tuplesizes));
+    // resolve the sources for each attribute of each primitive group
+    for(g = 0; g < numgroups; ++g)
+    {
+        dae_input_local_offset_type** inputs;
+        daeu_mesh_group* grp = mesh_out->groups + g;
+        daeu_mesh_binding* gb = bindings + g*numattribs;
+        size_t numinputs;
+        size_t i;
+        daeu_prim_get_inputs(prims[g], &inputs, &numinputs, &grp->material);
+        for(a = 0; a < numattribs; ++a)
+        {
+            daeu_mesh_bind_input(mesh, inputs, numinputs, attribs+a, gb+a);
+        }
+        // groups that bind identical sources may share vertices
+        bindingsets[g] = (unsigned) g;
+        for(i = 0; i < g; ++i)
+        {
+            const daeu_mesh_binding* ib = bindings + i*numattribs;
+            for(a = 0; a < numattribs; ++a)
+            {
+                if(ib[a].data != gb[a].data ||
+                   ib[a].offset != gb[a].offset ||
+                   ib[a].stride != gb[a].stride)
+                {
+                    break;
+                }
+            }
+            if(a == numattribs)
+            {
+                bindingsets[g] = bindingsets[i];
+                break;
+            }
+        }
+        tuplesizes[g] = daeu_mesh_calc_tuplesize(inputs, numinputs);
+        if(tuplesizes[g] > 0)
+        {
+            numcorners += daeu_tri_count(prims[g], tuplesizes[g])*3;
+        }
+    }
+    // attribute sizes are taken from the first group that binds them
+    for(a = 0; a < numattribs; ++a)
+    {
+        daeu_mesh_attrib* at = mesh_out->attribs + a;
+        at->offset = mesh_out->vertexsize;
+        at->size = 0;
+        for(g = 0; g < numgroups; ++g)
+        {
+            const daeu_mesh_binding* b = bindings + g*numattribs + a;
+            if(b->data != NULL)
+            {
+                at->size = b->numparams;
+                break;
+            }
+        }
+        mesh_out->vertexsize += at->size;
+    }
+    // allocate for the worst case where no vertices are welded
+    tablesize = 16;
+    while(tablesize < numcorners*2)
+    {
+        tablesize <<= 1;
+    }
+    table = (unsigned*) malloc(tablesize*sizeof(*table));
+    memset(table, 0xff, tablesize*sizeof(*table));
+    keys = (unsigned*) malloc((numcorners+1)*(numattribs+1)*sizeof(*keys));
+    mesh_out->vertices = (float*) malloc(
+        (numcorners*mesh_out->vertexsize + 1)*sizeof(*mesh_out->vertices));
+    mesh_out->indices = (unsigned*) malloc(
+        (numcorners + 1)*sizeof(*mesh_out->indices));
+    for(g = 0; g < numgroups; ++g)
+    {
+        daeu_mesh_group* grp = mesh_out->groups + g;
+        unsigned tuplesize = tuplesizes[g];
+        grp->firstindex = mesh_out->numindices;
+        if(tuplesize == 0)
+        {
+            // no inputs
+        }
+        else if(dae_get_typeid(prims[g]) == dae_ID_TRIANGLES_TYPE)
+        {
+            // triangle lists can be welded directly from the p element
+            dae_triangles_type* tri = (dae_triangles_type*) prims[g];
+            if(tri->el_p != NULL)
+            {
+                daeu_mesh_weld(
+                    mesh_out,
+                    bindings + g*numattribs,
+                    bindingsets[g],
+                    tri->el_p->data.values,
+                    (tri->el_p->data.size/tuplesize)/3*3,
+                    tuplesize,
+                    table,
+                    tablesize - 1,
+                    keys);
+            }
+        }
+        else
+        {
+            daeu_tris tris;
+            if(daeu_triangulate(mesh, prims[g], &tris) == 0)
+            {
+                daeu_mesh_weld(
+                    mesh_out,
+                    bindings + g*numattribs,
+                    bindingsets[g],
+                    tris.indices,
+                    tris.numtris*3,
+                    tuplesize,
+                    table,
+                    tablesize - 1,
+                    keys);
+                daeu_tris_destroy(&tris);
+            }
+        }
+        grp->numindices = mesh_out->numindices - grp->firstindex;
+    }
+    // keep the source indices of each vertex, without the binding set
+    mesh_out->sources = (unsigned*) malloc(
+        (mesh_out->numvertices*numattribs + 1)*sizeof(unsigned));
+    for(g = 0; g < mesh_out->numvertices; ++g)
+    {
+        memcpy(
+            mesh_out->sources + g*numattribs,
+            keys + g*(numattribs + 1) + 1,
+            numattribs*sizeof(unsigned));
+    }
+    free(keys);
+    free(table);
+    free(tuplesizes);
+    free(bindingsets);
+    free(bindings);
+    free(prims);
+    // release the unused portion of the worst case allocation
+    mesh_out->vertices = (float*) realloc(
+        mesh_out->vertices,
+        (mesh_out->numvertices*mesh_out->vertexsize + 1)*sizeof(float));
+    if(mesh_out->numindices == 0)
+    {
+        err = -1;
+    }
+    return err;
+}
+
+//****************************************************************************
+static void daeu_mesh_compile_task(
+    void* userdata,
+    size_t index,
+    int worker)
+{
+    daeu_mesh_batch* batch = (daeu_mesh_batch*) userdata;
+    daeu_geometry_mesh* gm = batch->meshes + index;
+    gm->err = daeu_mesh_compile(
+        gm->geometry->el_mesh,
+        batch->attribs,
+        batch->numattribs,
+        &gm->mesh);
+}
+
+//****************************************************************************
+static size_t daeu_mesh_estimate_cost(
+    dae_mesh_type* mesh)
+{
+    // the number of primitive indices approximates the compile time
+    size_t cost = 0;
+    dae_obj_ptr el = dae_get_first_element(mesh);
+    while(el != NULL)
+    {
+        dae_obj_ptr child = dae_get_first_element(el);
+        while(child != NULL)
+        {
+            dae_native_typeid type;
+            void* data;
+            size_t len;
+            if(!strcmp(dae_get_name(child), "p") &&
+               dae_get_data(child, &type, &data, &len) > 0)
+            {
+                cost += len;
+            }
+            child = dae_get_next(child);
+        }
+        el = dae_get_next(el);
+    }
+    return cost;
+}
+
+//****************************************************************************
+static int daeu_mesh_cmp_cost(
+    const void* a,
+    const void* b)
+{
+    const daeu_mesh_cost* ca = (const daeu_mesh_cost*) a;
+    const daeu_mesh_cost* cb = (const daeu_mesh_cost*) b;
+    if(ca->cost != cb->cost)
+    {
+        return (ca->cost > cb->cost) ? -1 : 1;
+    }
+    return (ca->index < cb->index) ? -1 : (ca->index > cb->index);
+}
+
+//****************************************************************************
+int daeu_mesh_compile_all(
+    dae_COLLADA* doc,
+    const daeu_mesh_attrib* attribs,
+    size_t numattribs,
+    int numthreads,
+    daeu_geometry_mesh** meshes_out,
+    size_t* nummeshes_out)
+{
+    daeu_mesh_batch batch;
+    daeu_mesh_cost* costs;
+    size_t* order;
+    size_t nummeshes = 0;
+    size_t i;
+    size_t j;
+    int err = 0;
+    for(i = 0; i < doc->el_library_geometries.size; ++i)
+    {
+        dae_library_geometries_type* lib;
+        lib = doc->el_library_geometries.values[i];
+        for(j = 0; j < lib->el_geometry.size; ++j)
+        {
+            nummeshes += (lib->el_geometry.values[j]->el_mesh != NULL);
+        }
+    }
+    batch.meshes = (daeu_geometry_mesh*) calloc(
+        nummeshes + 1,
+        sizeof(*batch.meshes));
+    batch.attribs = attribs;
+    batch.numattribs = numattribs;
+    costs = (daeu_mesh_cost*) malloc((nummeshes + 1)*sizeof(*costs));
+    order = (size_t*) malloc((nummeshes + 1)*sizeof(*order));
+    nummeshes = 0;
+    for(i = 0; i < doc->el_library_geometries.size; ++i)
+    {
+        dae_library_geometries_type* lib;
+        lib = doc->el_library_geometries.values[i];
+        for(j = 0; j < lib->el_geometry.size; ++j)
+        {
+            dae_geometry_type* geo = lib->el_geometry.values[j];
+            if(geo->el_mesh != NULL)
+            {
+                batch.meshes[nummeshes].geometry = geo;
+                costs[nummeshes].cost = daeu_mesh_estimate_cost(geo->el_mesh);
+                costs[nummeshes].index = nummeshes;
+                ++nummeshes;
+            }
+        }
+    }
+    // dispatch the largest meshes first so they do not end up in the tail
+    qsort(costs, nummeshes, sizeof(*costs), daeu_mesh_cmp_cost);
+    for(i = 0; i < nummeshes; ++i)
+    {
+        order[i] = costs[i].index;
+    }
+    if(nummeshes > 0)
+    {
+        daeu_pool_run(
+            nummeshes,
+            order,
+            daeu_pool_count_workers(nummeshes, numthreads),
+            daeu_mesh_compile_task,
+            &batch);
+    }
+    for(i = 0; i < nummeshes; ++i)
+    {
+        err = (batch.meshes[i].err != 0) ? -1 : err;
+    }
+    free(order);
+    free(costs);
+    *meshes_out = batch.meshes;
+    *nummeshes_out = nummeshes;
+    return err;
+}
+
+//****************************************************************************
+void daeu_mesh_destroy(
+    daeu_mesh* mesh)
+{
+    free(mesh->vertices);
+    free(mesh->indices);
+    free(mesh->attribs);
+    free(mesh->groups);
+    free(mesh->sources);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+//****************************************************************************
+void daeu_mesh_destroy_all(
+    daeu_geometry_mesh* meshes,
+    size_t nummeshes)
+{
+    size_t i;
+    for(i = 0; i < nummeshes; ++i)
+    {
+        daeu_mesh_destroy(&meshes[i].mesh);
+    }
+    free(meshes);
+}
+
+//****************************************************************************
+void daeu_rotate_to_matrix(
+    const dae_rotate_type* rotate,
+    float* mtx_out)
+{
+    const float* axis = rotate->data;
+    float rad = rotate->data[3] * (3.14159265f/180.0f);
+    float c = cosf(rad);
     float s = sinf(rad);
     mtx_out[ 0] = axis[0]*axis[0]*(1.0f-c) + c;
     mtx_out[ 1] = axis[0]*axis[1]*(1.0f-c) - axis[2]*s;
@@ -146,343 +2607,4888 @@ void daeu_rotate_to_matrix(
 }
 
 //****************************************************************************
-void daeu_scale_to_matrix(
-    const dae_scale_type* scale,
-    float* mtx_out)
+void daeu_scale_to_matrix(
+    const dae_scale_type* scale,
+    float* mtx_out)
+{
+    daeu_matrix_identity(mtx_out);
+    mtx_out[ 0] = scale->data[0];
+    mtx_out[ 5] = scale->data[1];
+    mtx_out[10] = scale->data[2];
+}
+
+//****************************************************************************
+void daeu_translate_to_matrix(
+    const dae_translate_type* translate,
+    float* mtx_out)
+{
+    daeu_matrix_identity(mtx_out);
+    mtx_out[ 3] = translate->data[0];
+    mtx_out[ 7] = translate->data[1];
+    mtx_out[11] = translate->data[2];
+}
+
+//****************************************************************************
+void daeu_calc_transform_matrix(
+    dae_obj_ptr obj,
+    float* mtx_out)
+{
+    float mtx[16];
+    dae_obj_ptr el;
+
+    daeu_matrix_identity(mtx_out);
+    el = dae_get_first_element(obj);
+    while(el != NULL)
+    {
+        // the multiply kernels allow the output to alias an operand, so
+        // each transform is accumulated in place
+        const float* mtxel = mtx;
+        dae_obj_typeid eltype = dae_get_typeid(el);
+        switch(eltype)
+        {
+        case dae_ID_LOOKAT_TYPE:
+            daeu_lookat_to_matrix((dae_lookat_type*) el, mtx);
+            break;
+        case dae_ID_MATRIX_TYPE:
+            mtxel = ((dae_matrix_type*) el)->data;
+            break;
+        case dae_ID_ROTATE_TYPE:
+            daeu_rotate_to_matrix((dae_rotate_type*) el, mtx);
+            break;
+        case dae_ID_SCALE_TYPE:
+            daeu_scale_to_matrix((dae_scale_type*) el, mtx);
+            break;
+        case dae_ID_SKEW_TYPE:
+            // TODO support SKEW
+            assert(0);
+            mtxel = NULL;
+            break;
+        case dae_ID_TRANSLATE_TYPE:
+            daeu_translate_to_matrix((dae_translate_type*) el, mtx);
+            break;
+        default:
+            mtxel = NULL;
+            break;
+        }
+        if(mtxel != NULL)
+        {
+            daeu_matrix_multiply(mtx_out, mtxel, mtx_out);
+        }
+        el = dae_get_next(el);
+    }
+}
+
+//****************************************************************************
+static void daeu_destroy_task(
+    void* userdata,
+    size_t index,
+    int worker)
+{
+    dae_obj_ptr* subtrees = (dae_obj_ptr*) userdata;
+    dae_destroy_subtree(subtrees[index]);
+}
+
+//****************************************************************************
+#ifdef _WIN32
+static DWORD WINAPI daeu_destroy_main(
+    LPVOID arg)
+#else
+static void* daeu_destroy_main(
+    void* arg)
+#endif
+{
+    daeu_destroy_job job = (daeu_destroy_job) arg;
+    daeu_destroy(job->doc, job->numthreads);
+    return 0;
+}
+
+//****************************************************************************
+void daeu_destroy(
+    dae_COLLADA* doc,
+    int numthreads)
+{
+    int numworkers = daeu_pool_count_workers((size_t) -1, numthreads);
+    // a few trees per worker lets stealing even out their sizes
+    size_t mintrees = numworkers*4;
+    size_t numsubtrees = 1;
+    if(numworkers > 1)
+    {
+        numsubtrees = dae_destroy_split(doc, mintrees, NULL);
+        numworkers = daeu_pool_count_workers(numsubtrees, numthreads);
+    }
+    if(numworkers > 1)
+    {
+        dae_obj_ptr* subtrees;
+        subtrees = (dae_obj_ptr*) malloc(numsubtrees*sizeof(*subtrees));
+        dae_destroy_split(doc, mintrees, subtrees);
+        daeu_pool_run(
+            numsubtrees,
+            NULL,
+            numworkers,
+            daeu_destroy_task,
+            subtrees);
+        free(subtrees);
+    }
+    else
+    {
+        dae_destroy(doc);
+    }
+}
+
+//****************************************************************************
+void daeu_destroy_async(
+    dae_COLLADA* doc,
+    int numthreads,
+    daeu_destroy_job* job_out)
+{
+    daeu_destroy_job job = (daeu_destroy_job) malloc(sizeof(*job));
+    job->doc = doc;
+    job->numthreads = numthreads;
+#ifdef _WIN32
+    job->thread = CreateThread(NULL, 0, daeu_destroy_main, job, 0, NULL);
+    job->started = (job->thread != NULL);
+#else
+    job->started = !pthread_create(&job->thread, NULL, daeu_destroy_main, job);
+#endif
+    if(!job->started)
+    {
+        // without a background thread, the teardown happens here
+        daeu_destroy(doc, numthreads);
+    }
+    *job_out = job;
+}
+
+//****************************************************************************
+void daeu_destroy_wait(
+    daeu_destroy_job job)
+{
+    if(job->started)
+    {
+#ifdef _WIN32
+        WaitForSingleObject(job->thread, INFINITE);
+        CloseHandle(job->thread);
+#else
+        pthread_join(job->thread, NULL);
+#endif
+    }
+    free(job);
+}
+
+//****************************************************************************
+dae_obj_ptr daeu_find_attrib(
+    dae_obj_ptr obj,
+    const char* name)
+{
+    dae_obj_ptr at = NULL;
+    dae_obj_ptr itr = dae_get_first_attrib(obj);
+    while(itr != NULL)
+    {
+        const char* itname = dae_get_name(itr);
+        if(!strcmp(itname, name))
+        {
+            at = itr;
+            break;
+        }
+        itr = dae_get_next(itr);
+    }
+    return at;
+}
+
+//****************************************************************************
+static dae_obj_ptr daeu_walk_next(
+    dae_obj_ptr root,
+    dae_obj_ptr itr)
+{
+    // preorder traversal of the elements below root
+    dae_obj_ptr next = dae_get_first_element(itr);
+    while(next == NULL && itr != root)
+    {
+        next = dae_get_next(itr);
+        if(next == NULL)
+        {
+            itr = dae_get_parent(itr);
+        }
+    }
+    return next;
+}
+
+//****************************************************************************
+static const char* daeu_get_string(
+    dae_obj_ptr obj,
+    const char* name)
+{
+    const char* result = NULL;
+    dae_obj_ptr at = daeu_find_attrib(obj, name);
+    if(at != NULL)
+    {
+        dae_native_typeid attype;
+        void* ataddr;
+        size_t atsize;
+        if(dae_get_data(at, &attype, &ataddr, &atsize) > 0)
+        {
+            if(attype == dae_NATIVE_STRING)
+            {
+                result = *((char**) ataddr);
+            }
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+static const char* daeu_get_id(
+    dae_obj_ptr obj)
+{
+    return daeu_get_string(obj, "id");
+}
+
+//****************************************************************************
+static size_t daeu_str_hash(
+    const char* s,
+    size_t len)
+{
+    // FNV-1a
+    unsigned h = 2166136261u;
+    size_t i;
+    for(i = 0; i < len; ++i)
+    {
+        h = (h ^ (unsigned char) s[i]) * 16777619u;
+    }
+    return h;
+}
+
+//****************************************************************************
+static dae_obj_ptr daeu_idmap_find_n(
+    const daeu_idmap* map,
+    const char* id,
+    size_t len)
+{
+    // the id does not need to be terminated
+    dae_obj_ptr result = NULL;
+    if(map->cap > 0)
+    {
+        size_t i = daeu_str_hash(id, len) & (map->cap - 1);
+        while(map->keys[i] != NULL)
+        {
+            if(!strncmp(map->keys[i], id, len) && map->keys[i][len] == '\0')
+            {
+                result = map->objs[i];
+                break;
+            }
+            i = (i + 1) & (map->cap - 1);
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+static dae_obj_ptr daeu_idmap_find(
+    const daeu_idmap* map,
+    const char* uri)
+{
+    // accepts either a bare id or a urifragment
+    dae_obj_ptr result = NULL;
+    if(uri != NULL)
+    {
+        if(*uri == '#')
+        {
+            ++uri;
+        }
+        result = daeu_idmap_find_n(map, uri, strlen(uri));
+    }
+    return result;
+}
+
+//****************************************************************************
+static void daeu_idmap_insert(
+    daeu_idmap* map,
+    const char* key,
+    dae_obj_ptr obj)
+{
+    size_t i;
+    if((map->size + 1)*2 > map->cap)
+    {
+        // rehash into a table twice the size, keeping the load under half
+        daeu_idmap old = *map;
+        map->cap = (old.cap > 0) ? old.cap*2 : 64;
+        map->keys = (const char**) calloc(map->cap, sizeof(*map->keys));
+        map->objs = (dae_obj_ptr*) malloc(map->cap * sizeof(*map->objs));
+        map->size = 0;
+        for(i = 0; i < old.cap; ++i)
+        {
+            if(old.keys[i] != NULL)
+            {
+                daeu_idmap_insert(map, old.keys[i], old.objs[i]);
+            }
+        }
+        free((void*) old.keys);
+        free(old.objs);
+    }
+    i = daeu_str_hash(key, strlen(key)) & (map->cap - 1);
+    while(map->keys[i] != NULL)
+    {
+        if(!strcmp(map->keys[i], key))
+        {
+            // ids should be unique, but the first in document order wins
+            return;
+        }
+        i = (i + 1) & (map->cap - 1);
+    }
+    map->keys[i] = key;
+    map->objs[i] = obj;
+    ++map->size;
+}
+
+//****************************************************************************
+static void daeu_idmap_create(
+    dae_obj_ptr root,
+    daeu_idmap* map_out)
+{
+    dae_obj_ptr itr = root;
+    memset(map_out, 0, sizeof(*map_out));
+    while(itr != NULL)
+    {
+        const char* id = daeu_get_id(itr);
+        if(id != NULL && *id != '\0')
+        {
+            daeu_idmap_insert(map_out, id, itr);
+        }
+        itr = daeu_walk_next(root, itr);
+    }
+}
+
+//****************************************************************************
+static void daeu_idmap_destroy(
+    daeu_idmap* map)
+{
+    free((void*) map->keys);
+    free(map->objs);
+}
+
+//****************************************************************************
+static char* daeu_merge_keep(
+    daeu_merge_state* merge,
+    size_t len)
+{
+    char* str = (char*) malloc(len + 1);
+    if(merge->numnames == merge->capnames)
+    {
+        merge->capnames = (merge->capnames > 0) ? merge->capnames*2 : 32;
+        merge->names = (char**) realloc(
+            merge->names,
+            merge->capnames * sizeof(*merge->names));
+    }
+    merge->names[merge->numnames++] = str;
+    return str;
+}
+
+//****************************************************************************
+static void daeu_merge_append(
+    daeu_merge_state* merge,
+    const char* str,
+    size_t len)
+{
+    if(merge->textlen + len + 1 > merge->textcap)
+    {
+        merge->textcap = (merge->textlen + len + 1)*2;
+        merge->text = (char*) realloc(merge->text, merge->textcap);
+    }
+    memcpy(merge->text + merge->textlen, str, len);
+    merge->textlen += len;
+    merge->text[merge->textlen] = '\0';
+}
+
+//****************************************************************************
+static void daeu_merge_rename(
+    daeu_merge_state* merge,
+    daeu_idmap* dstids,
+    const daeu_idmap* srcids,
+    dae_obj_ptr obj,
+    const char* id)
+{
+    size_t len = strlen(id);
+    char* oldid = daeu_merge_keep(merge, len);
+    char* newid = daeu_merge_keep(merge, len + 16);
+    unsigned n = 0;
+    memcpy(oldid, id, len + 1);
+    do
+    {
+        // the new id must be free in both documents
+        sprintf(newid, "%s_%u", id, ++n);
+    }
+    while(daeu_idmap_find(dstids, newid) != NULL ||
+        daeu_idmap_find(srcids, newid) != NULL);
+    daeu_idmap_insert(dstids, newid, obj);
+    daeu_idmap_insert(&merge->renames, oldid, obj);
+}
+
+//****************************************************************************
+static void daeu_merge_retarget(
+    daeu_merge_state* merge,
+    dae_obj_ptr obj)
+{
+    dae_native_typeid type;
+    void* data;
+    size_t len;
+    int kind = 0;
+    switch(dae_get_typeid(obj))
+    {
+    case dae_ID_ANYURI:
+    case dae_ID_URIFRAGMENT_TYPE:
+        // only fragments refer to the same document
+        kind = '#';
+        break;
+    case dae_ID_IDREF_ARRAY_TYPE:
+        kind = ' ';
+        break;
+    case dae_ID_SIDREF_TYPE:
+    case dae_ID_SIDREF_ARRAY_TYPE:
+        // the first segment of a sid path is an id
+        kind = '/';
+        break;
+    default:
+        break;
+    }
+    if(kind != 0 &&
+        dae_get_data(obj, &type, &data, &len) > 0 &&
+        type == dae_NATIVE_STRING)
+    {
+        char** words = (char**) data;
+        int changed = 0;
+        size_t i;
+        merge->textlen = 0;
+        for(i = 0; i < len; ++i)
+        {
+            const char* word = (words[i] != NULL) ? words[i] : "";
+            const char* id = word;
+            size_t idlen = 0;
+            dae_obj_ptr target = NULL;
+            switch(kind)
+            {
+            case '#':
+                if(*word == '#')
+                {
+                    ++id;
+                    idlen = strlen(id);
+                }
+                break;
+            case '/':
+                idlen = strcspn(word, "/.(");
+                break;
+            default:
+                idlen = strlen(word);
+                break;
+            }
+            if(idlen > 0)
+            {
+                target = daeu_idmap_find_n(&merge->renames, id, idlen);
+            }
+            if(i > 0)
+            {
+                daeu_merge_append(merge, " ", 1);
+            }
+            if(target != NULL)
+            {
+                const char* newid = daeu_get_id(target);
+                daeu_merge_append(merge, word, id - word);
+                daeu_merge_append(merge, newid, strlen(newid));
+                daeu_merge_append(merge, id + idlen, strlen(id + idlen));
+                changed = 1;
+            }
+            else
+            {
+                daeu_merge_append(merge, word, strlen(word));
+            }
+        }
+        if(changed)
+        {
+            dae_set_string(obj, merge->text);
+        }
+    }
+}
+
+//****************************************************************************
+static void daeu_merge_library(
+    dae_COLLADA* dst,
+    dae_obj_ptr lib)
+{
+    const char* name = dae_get_name(lib);
+    dae_obj_ptr dstlib = dae_get_first_element(dst);
+    dae_obj_ptr itr;
+    size_t numelems = 0;
+    while(dstlib != NULL && strcmp(dae_get_name(dstlib), name))
+    {
+        dstlib = dae_get_next(dstlib);
+    }
+    if(dstlib == NULL)
+    {
+        dstlib = dae_add_element(dst, name);
+    }
+    itr = dae_get_first_element(lib);
+    while(itr != NULL)
+    {
+        ++numelems;
+        itr = dae_get_next(itr);
+    }
+    // elements that stay behind are put back at the end, so the loop stops
+    // after the elements that were there to begin with
+    itr = dae_get_first_element(lib);
+    while(numelems-- > 0)
+    {
+        dae_obj_ptr next = dae_get_next(itr);
+        // the destination library keeps its own asset
+        if(strcmp(dae_get_name(itr), "asset") != 0)
+        {
+            dae_detach(itr);
+            if(dae_attach(dstlib, itr) != 0)
+            {
+                // documents with different hooks cannot share objects
+                dae_obj_ptr copy = dae_clone(itr, dae_get_allocator(dst));
+                if(copy != NULL && dae_attach(dstlib, copy) == 0)
+                {
+                    dae_destroy_subtree(itr);
+                }
+                else
+                {
+                    if(copy != NULL)
+                    {
+                        dae_destroy_subtree(copy);
+                    }
+                    dae_attach(lib, itr);
+                }
+            }
+        }
+        itr = next;
+    }
+}
+
+//****************************************************************************
+size_t daeu_merge(
+    dae_COLLADA* dst,
+    dae_COLLADA* src)
+{
+    daeu_merge_state merge;
+    daeu_idmap dstids;
+    daeu_idmap srcids;
+    dae_obj_ptr itr;
+    size_t numrenamed;
+    size_t i;
+    memset(&merge, 0, sizeof(merge));
+    daeu_idmap_create(dst, &dstids);
+    daeu_idmap_create(src, &srcids);
+    // pick the new ids while the keys of srcids are still valid
+    itr = src;
+    while(itr != NULL)
+    {
+        const char* id = daeu_get_id(itr);
+        if(id != NULL &&
+            daeu_idmap_find(&dstids, id) != NULL &&
+            daeu_idmap_find(&merge.renames, id) == NULL)
+        {
+            daeu_merge_rename(&merge, &dstids, &srcids, itr, id);
+        }
+        itr = daeu_walk_next(src, itr);
+    }
+    daeu_idmap_destroy(&srcids);
+    numrenamed = merge.numnames/2;
+    for(i = 0; i < numrenamed; ++i)
+    {
+        const char* oldid = merge.names[i*2 + 0];
+        dae_obj_ptr obj = daeu_idmap_find(&merge.renames, oldid);
+        dae_set_string(daeu_find_attrib(obj, "id"), merge.names[i*2 + 1]);
+    }
+    if(numrenamed > 0)
+    {
+        // a single pass over every value that can hold a reference
+        itr = src;
+        while(itr != NULL)
+        {
+            dae_obj_ptr at = dae_get_first_attrib(itr);
+            daeu_merge_retarget(&merge, itr);
+            while(at != NULL)
+            {
+                daeu_merge_retarget(&merge, at);
+                at = dae_get_next(at);
+            }
+            itr = daeu_walk_next(src, itr);
+        }
+    }
+    itr = dae_get_first_element(src);
+    while(itr != NULL)
+    {
+        dae_obj_ptr next = dae_get_next(itr);
+        if(!strncmp(dae_get_name(itr), "library_", 8))
+        {
+            daeu_merge_library(dst, itr);
+        }
+        itr = next;
+    }
+    for(i = 0; i < merge.numnames; ++i)
+    {
+        free(merge.names[i]);
+    }
+    free(merge.names);
+    free(merge.text);
+    daeu_idmap_destroy(&merge.renames);
+    daeu_idmap_destroy(&dstids);
+    return numrenamed;
+}
+
+//****************************************************************************
+static void daeu_hash_lanes_scalar(
+    const unsigned char* data,
+    size_t numstripes,
+    unsigned* lanes)
+{
+    size_t i;
+    int j;
+    for(i = 0; i < numstripes; ++i)
+    {
+        unsigned k[16];
+        memcpy(k, data + i*64, sizeof(k));
+        for(j = 0; j < 16; ++j)
+        {
+            unsigned v = lanes[j] + k[j]*2246822519u;
+            lanes[j] = ((v << 13) | (v >> 19))*2654435761u;
+        }
+    }
+}
+
+#ifdef daeu_AVX
+//****************************************************************************
+static daeu_AVX_FN void daeu_hash_lanes_avx(
+    const unsigned char* data,
+    size_t numstripes,
+    unsigned* lanes)
+{
+    // the same sixteen lanes as the scalar loop, in four registers so the
+    // latency of the multiplies overlaps. AVX implies the 32 bit multiply
+    // of SSE4.1
+    const __m128i p1 = _mm_set1_epi32((int) 2654435761u);
+    const __m128i p2 = _mm_set1_epi32((int) 2246822519u);
+    __m128i v[4];
+    size_t i;
+    int j;
+    for(j = 0; j < 4; ++j)
+    {
+        v[j] = _mm_loadu_si128((const __m128i*) (lanes + j*4));
+    }
+    for(i = 0; i < numstripes; ++i)
+    {
+        for(j = 0; j < 4; ++j)
+        {
+            const __m128i* src = (const __m128i*) (data + i*64 + j*16);
+            __m128i k = _mm_loadu_si128(src);
+            __m128i t = _mm_add_epi32(v[j], _mm_mullo_epi32(k, p2));
+            t = _mm_or_si128(_mm_slli_epi32(t, 13), _mm_srli_epi32(t, 19));
+            v[j] = _mm_mullo_epi32(t, p1);
+        }
+    }
+    for(j = 0; j < 4; ++j)
+    {
+        _mm_storeu_si128((__m128i*) (lanes + j*4), v[j]);
+    }
+}
+#endif
+
+//****************************************************************************
+static unsigned daeu_hash_block(
+    const void* data,
+    size_t size,
+    int avx)
+{
+    // after xxHash32, widened to sixteen independent lanes over 64 byte
+    // stripes for the bulk of the block, so it runs at memory speed. the
+    // result depends on the byte order and is only meant for use in process
+    const unsigned char* p = (const unsigned char*) data;
+    size_t numstripes = size/64;
+    size_t i = numstripes*64;
+    unsigned h = 374761393u;
+    int j;
+    if(numstripes > 0)
+    {
+        unsigned v[16];
+        for(j = 0; j < 16; ++j)
+        {
+            v[j] = 2654435761u*(unsigned) (j + 1);
+        }
+#ifdef daeu_AVX
+        if(avx)
+        {
+            daeu_hash_lanes_avx(p, numstripes, v);
+        }
+        else
+#endif
+        {
+            daeu_hash_lanes_scalar(p, numstripes, v);
+        }
+        for(j = 0; j < 16; ++j)
+        {
+            h = (h ^ v[j])*2246822519u;
+            h = (h << 13) | (h >> 19);
+        }
+    }
+    h += (unsigned) size;
+    for(; i + 4 <= size; i += 4)
+    {
+        unsigned k;
+        memcpy(&k, p + i, sizeof(k));
+        h += k*3266489917u;
+        h = ((h << 17) | (h >> 15))*668265263u;
+    }
+    for(; i < size; ++i)
+    {
+        h += p[i]*374761393u;
+        h = ((h << 11) | (h >> 21))*2654435761u;
+    }
+    h ^= h >> 15;
+    h *= 2246822519u;
+    h ^= h >> 13;
+    h *= 3266489917u;
+    h ^= h >> 16;
+    return h;
+}
+
+//****************************************************************************
+static size_t daeu_native_size(
+    dae_native_typeid type)
+{
+    size_t size = 0;
+    switch(type)
+    {
+    case dae_NATIVE_HEX8:
+    case dae_NATIVE_INT8:
+    case dae_NATIVE_UINT8:
+        size = 1;
+        break;
+    case dae_NATIVE_INT16:
+        size = 2;
+        break;
+    case dae_NATIVE_BOOL32:
+    case dae_NATIVE_FLOAT:
+    case dae_NATIVE_INT32:
+    case dae_NATIVE_UINT32:
+        size = 4;
+        break;
+    case dae_NATIVE_STRING:
+        size = sizeof(char*);
+        break;
+    }
+    return size;
+}
+
+//****************************************************************************
+static void daeu_dedup_get_ids(
+    dae_obj_ptr root,
+    daeu_dedup_ids* ids_out)
+{
+    dae_obj_ptr itr = root;
+    memset(ids_out, 0, sizeof(*ids_out));
+    while(itr != NULL)
+    {
+        const char* id = daeu_get_id(itr);
+        if(id != NULL)
+        {
+            if(ids_out->size == ids_out->cap)
+            {
+                ids_out->cap = (ids_out->cap > 0) ? ids_out->cap*2 : 8;
+                ids_out->ids = (const char**) realloc(
+                    (void*) ids_out->ids,
+                    ids_out->cap * sizeof(*ids_out->ids));
+                ids_out->objs = (dae_obj_ptr*) realloc(
+                    ids_out->objs,
+                    ids_out->cap * sizeof(*ids_out->objs));
+            }
+            ids_out->ids[ids_out->size] = id;
+            ids_out->objs[ids_out->size] = itr;
+            ++ids_out->size;
+        }
+        itr = daeu_walk_next(root, itr);
+    }
+}
+
+//****************************************************************************
+static long daeu_dedup_find_local(
+    const daeu_dedup_ids* ids,
+    const char* uri)
+{
+    // fragments that point inside the subtree compare by position, so two
+    // copies that differ only in their ids are equal
+    long result = -1;
+    if(uri != NULL && *uri == '#')
+    {
+        size_t i;
+        for(i = 0; i < ids->size; ++i)
+        {
+            if(!strcmp(ids->ids[i], uri + 1))
+            {
+                result = (long) i;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+static int daeu_dedup_skip_value(
+    dae_obj_ptr root,
+    dae_obj_ptr obj)
+{
+    // ids are always unique and the name of the subtree is only a label
+    return dae_get_typeid(obj) == dae_ID_ID ||
+        (dae_get_parent(obj) == root && !strcmp(dae_get_name(obj), "name"));
+}
+
+//****************************************************************************
+static unsigned daeu_dedup_hash_obj(
+    dae_obj_ptr root,
+    const daeu_dedup_ids* ids,
+    dae_obj_ptr obj,
+    int avx)
+{
+    const char* name = dae_get_name(obj);
+    unsigned h = (unsigned) daeu_str_hash(name, strlen(name));
+    dae_native_typeid type;
+    void* data;
+    size_t len;
+    if(!daeu_dedup_skip_value(root, obj) &&
+        dae_get_data(obj, &type, &data, &len) > 0)
+    {
+        if(type == dae_NATIVE_STRING)
+        {
+            char** words = (char**) data;
+            size_t i;
+            for(i = 0; i < len; ++i)
+            {
+                long local = daeu_dedup_find_local(ids, words[i]);
+                unsigned wh = 0;
+                if(local >= 0)
+                {
+                    wh = (unsigned) local;
+                }
+                else if(words[i] != NULL)
+                {
+                    wh = (unsigned) daeu_str_hash(words[i], strlen(words[i]));
+                }
+                h = (h ^ wh)*16777619u;
+            }
+        }
+        else
+        {
+            size_t size = len*daeu_native_size(type);
+            h = (h ^ daeu_hash_block(data, size, avx))*16777619u;
+        }
+    }
+    return h;
+}
+
+//****************************************************************************
+static int daeu_dedup_equal_obj(
+    dae_obj_ptr roota,
+    const daeu_dedup_ids* idsa,
+    dae_obj_ptr a,
+    const daeu_dedup_ids* idsb,
+    dae_obj_ptr b)
+{
+    int equal = 0;
+    if(dae_get_typeid(a) == dae_get_typeid(b) &&
+        !strcmp(dae_get_name(a), dae_get_name(b)))
+    {
+        equal = 1;
+        if(!daeu_dedup_skip_value(roota, a))
+        {
+            dae_native_typeid typea;
+            dae_native_typeid typeb;
+            void* dataa;
+            void* datab;
+            size_t lena = 0;
+            size_t lenb = 0;
+            dae_get_data(a, &typea, &dataa, &lena);
+            dae_get_data(b, &typeb, &datab, &lenb);
+            equal = (lena == lenb);
+            if(equal && lena > 0 && typea == dae_NATIVE_STRING)
+            {
+                char** wordsa = (char**) dataa;
+                char** wordsb = (char**) datab;
+                size_t i;
+                for(i = 0; i < lena && equal; ++i)
+                {
+                    long locala = daeu_dedup_find_local(idsa, wordsa[i]);
+                    long localb = daeu_dedup_find_local(idsb, wordsb[i]);
+                    if(locala >= 0 || localb >= 0)
+                    {
+                        equal = (locala == localb);
+                    }
+                    else if(wordsa[i] != NULL && wordsb[i] != NULL)
+                    {
+                        equal = !strcmp(wordsa[i], wordsb[i]);
+                    }
+                    else
+                    {
+                        equal = (wordsa[i] == wordsb[i]);
+                    }
+                }
+            }
+            else if(equal && lena > 0)
+            {
+                equal = !memcmp(dataa, datab, lena*daeu_native_size(typea));
+            }
+        }
+    }
+    return equal;
+}
+
+//****************************************************************************
+static void daeu_dedup_free_ids(
+    daeu_dedup_ids* ids)
+{
+    free((void*) ids->ids);
+    free(ids->objs);
+}
+
+//****************************************************************************
+static int daeu_dedup_equal(
+    dae_obj_ptr a,
+    const daeu_dedup_ids* idsa,
+    dae_obj_ptr b,
+    const daeu_dedup_ids* idsb)
+{
+    dae_obj_ptr ela = a;
+    dae_obj_ptr elb = b;
+    int equal = (idsa->size == idsb->size);
+    while(equal && ela != NULL && elb != NULL)
+    {
+        dae_obj_ptr ata = dae_get_first_attrib(ela);
+        dae_obj_ptr atb = dae_get_first_attrib(elb);
+        equal = daeu_dedup_equal_obj(a, idsa, ela, idsb, elb);
+        while(equal && ata != NULL && atb != NULL)
+        {
+            equal = daeu_dedup_equal_obj(a, idsa, ata, idsb, atb);
+            ata = dae_get_next(ata);
+            atb = dae_get_next(atb);
+        }
+        equal = equal && ata == NULL && atb == NULL;
+        ela = daeu_walk_next(a, ela);
+        elb = daeu_walk_next(b, elb);
+    }
+    return equal && ela == NULL && elb == NULL;
+}
+
+//****************************************************************************
+static void daeu_dedup_hash_task(
+    void* userdata,
+    size_t index,
+    int worker)
+{
+    daeu_dedup_batch* batch = (daeu_dedup_batch*) userdata;
+    daeu_dedup_item* item = batch->items + index;
+    daeu_dedup_ids ids;
+    dae_obj_ptr itr = item->obj;
+    unsigned h = 2166136261u;
+    daeu_dedup_get_ids(item->obj, &ids);
+    while(itr != NULL)
+    {
+        dae_obj_ptr at = dae_get_first_attrib(itr);
+        h = (h ^ daeu_dedup_hash_obj(item->obj, &ids, itr, batch->avx)) *
+            16777619u;
+        while(at != NULL)
+        {
+            h = (h ^ daeu_dedup_hash_obj(item->obj, &ids, at, batch->avx)) *
+                16777619u;
+            at = dae_get_next(at);
+        }
+        itr = daeu_walk_next(item->obj, itr);
+    }
+    item->hash = h;
+    daeu_dedup_free_ids(&ids);
+}
+
+//****************************************************************************
+static int daeu_dedup_cmp_item(
+    const void* a,
+    const void* b)
+{
+    // groups candidates by hash and parent, in document order within each
+    const daeu_dedup_item* ia = (const daeu_dedup_item*) a;
+    const daeu_dedup_item* ib = (const daeu_dedup_item*) b;
+    if(ia->hash != ib->hash)
+    {
+        return (ia->hash < ib->hash) ? -1 : 1;
+    }
+    if(ia->parent != ib->parent)
+    {
+        return ((size_t) ia->parent < (size_t) ib->parent) ? -1 : 1;
+    }
+    return (ia->order < ib->order) ? -1 : (ia->order > ib->order);
+}
+
+//****************************************************************************
+static size_t daeu_dedup_type(
+    dae_COLLADA* doc,
+    dae_obj_typeid type,
+    int sameparent,
+    int numthreads)
+{
+    daeu_dedup_batch batch;
+    daeu_dedup_item* items = NULL;
+    size_t numitems = 0;
+    size_t capitems = 0;
+    size_t numremoved = 0;
+    dae_obj_ptr itr = doc;
+    size_t i;
+    while(itr != NULL)
+    {
+        // only elements with an id can be referenced, and so retargeted
+        if(dae_get_typeid(itr) == type && daeu_get_id(itr) != NULL)
+        {
+            daeu_dedup_item* item;
+            if(numitems == capitems)
+            {
+                capitems = (capitems > 0) ? capitems*2 : 64;
+                items = (daeu_dedup_item*) realloc(
+                    items,
+                    capitems * sizeof(*items));
+            }
+            item = items + numitems;
+            memset(item, 0, sizeof(*item));
+            item->obj = itr;
+            item->parent = sameparent ? dae_get_parent(itr) : NULL;
+            item->order = numitems;
+            ++numitems;
+        }
+        itr = daeu_walk_next(doc, itr);
+    }
+    if(numitems > 1)
+    {
+        daeu_merge_state merge;
+        batch.items = items;
+#ifdef daeu_AVX
+        batch.avx = daeu_matrix_has_avx();
+#else
+        batch.avx = 0;
+#endif
+        // hashing reads the payloads, which dominates on large documents
+        daeu_pool_run(
+            numitems,
+            NULL,
+            daeu_pool_count_workers(numitems, numthreads),
+            daeu_dedup_hash_task,
+            &batch);
+        qsort(items, numitems, sizeof(*items), daeu_dedup_cmp_item);
+        memset(&merge, 0, sizeof(merge));
+        for(i = 0; i < numitems; ++i)
+        {
+            daeu_dedup_item* keep = items + i;
+            daeu_dedup_ids keepids;
+            size_t j;
+            if(keep->keep != NULL ||
+                i + 1 == numitems || keep[1].hash != keep->hash)
+            {
+                continue;
+            }
+            daeu_dedup_get_ids(keep->obj, &keepids);
+            // hashes can collide, so each match is confirmed in full
+            for(j = i + 1; j < numitems; ++j)
+            {
+                daeu_dedup_item* dup = items + j;
+                daeu_dedup_ids dupids;
+                if(dup->hash != keep->hash || dup->parent != keep->parent)
+                {
+                    break;
+                }
+                if(dup->keep != NULL)
+                {
+                    continue;
+                }
+                daeu_dedup_get_ids(dup->obj, &dupids);
+                if(daeu_dedup_equal(keep->obj, &keepids, dup->obj, &dupids))
+                {
+                    // the ids below a copy map to the same positions
+                    size_t k;
+                    for(k = 0; k < dupids.size; ++k)
+                    {
+                        daeu_idmap_insert(
+                            &merge.renames,
+                            dupids.ids[k],
+                            keepids.objs[k]);
+                    }
+                    dup->keep = keep->obj;
+                    ++numremoved;
+                }
+                daeu_dedup_free_ids(&dupids);
+            }
+            daeu_dedup_free_ids(&keepids);
+        }
+        if(numremoved > 0)
+        {
+            itr = doc;
+            while(itr != NULL)
+            {
+                dae_obj_ptr at = dae_get_first_attrib(itr);
+                daeu_merge_retarget(&merge, itr);
+                while(at != NULL)
+                {
+                    daeu_merge_retarget(&merge, at);
+                    at = dae_get_next(at);
+                }
+                itr = daeu_walk_next(doc, itr);
+            }
+            for(i = 0; i < numitems; ++i)
+            {
+                if(items[i].keep != NULL)
+                {
+                    dae_remove(items[i].obj);
+                }
+            }
+        }
+        free(merge.text);
+        daeu_idmap_destroy(&merge.renames);
+    }
+    free(items);
+    return numremoved;
+}
+
+//****************************************************************************
+size_t daeu_dedup(
+    dae_COLLADA* doc,
+    int numthreads)
+{
+    size_t numremoved;
+    // sources first, so that copies of a geometry also match once their
+    // own duplicate sources are gone
+    numremoved = daeu_dedup_type(doc, dae_ID_SOURCE_TYPE, 1, numthreads);
+    numremoved += daeu_dedup_type(doc, dae_ID_GEOMETRY_TYPE, 0, numthreads);
+    return numremoved;
+}
+
+//****************************************************************************
+static int daeu_bind_source(
+    dae_source_type* src,
+    daeu_source_binding* src_out)
+{
+    // binds a float, Name or IDREF array through its accessor
+    int result = 0;
+    memset(src_out, 0, sizeof(*src_out));
+    if(src != NULL && dae_get_typeid(src) == dae_ID_SOURCE_TYPE)
+    {
+        dae_accessor_type* acc = NULL;
+        size_t datalen = 0;
+        size_t offset = 0;
+        src_out->source = src;
+        if(src->el_float_array != NULL)
+        {
+            src_out->data = src->el_float_array->data.values;
+            datalen = src->el_float_array->data.size;
+        }
+        else if(src->el_Name_array != NULL)
+        {
+            src_out->names = src->el_Name_array->data.values;
+            datalen = src->el_Name_array->data.size;
+        }
+        else if(src->el_IDREF_array != NULL)
+        {
+            src_out->names = src->el_IDREF_array->data.values;
+            datalen = src->el_IDREF_array->data.size;
+        }
+        if(src->el_technique_common != NULL)
+        {
+            acc = src->el_technique_common->el_accessor;
+        }
+        src_out->stride = 1;
+        if(acc != NULL)
+        {
+            if(acc->at_stride != NULL && *acc->at_stride > 0)
+            {
+                src_out->stride = *acc->at_stride;
+            }
+            if(acc->at_offset != NULL)
+            {
+                offset = *acc->at_offset;
+            }
+        }
+        if(src_out->data != NULL)
+        {
+            src_out->data += (offset < datalen) ? offset : datalen;
+        }
+        else if(src_out->names != NULL)
+        {
+            src_out->names += (offset < datalen) ? offset : datalen;
+        }
+        src_out->count = (datalen > offset)
+            ? (datalen - offset) / src_out->stride
+            : 0;
+        if(acc != NULL && acc->at_count != NULL &&
+            *acc->at_count < src_out->count)
+        {
+            src_out->count = *acc->at_count;
+        }
+        result = src_out->data != NULL || src_out->names != NULL;
+    }
+    return result;
+}
+
+//****************************************************************************
+static daeu_anim_interp daeu_anim_get_interp(
+    const char* name)
+{
+    // BSPLINE is evaluated as LINEAR
+    daeu_anim_interp result = daeu_ANIM_LINEAR;
+    if(name != NULL)
+    {
+        if(!strcmp(name, "STEP"))
+        {
+            result = daeu_ANIM_STEP;
+        }
+        else if(!strcmp(name, "BEZIER") ||
+            !strcmp(name, "HERMITE") ||
+            !strcmp(name, "CARDINAL"))
+        {
+            result = daeu_ANIM_BEZIER;
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+static int daeu_anim_bind_channel(
+    const daeu_idmap* ids,
+    dae_channel_type* channel,
+    daeu_anim_binding* binding_out)
+{
+    int result = 0;
+    daeu_anim_binding* b = binding_out;
+    dae_sampler_type* sampler = NULL;
+    memset(b, 0, sizeof(*b));
+    b->channel = channel;
+    if(channel->at_source != NULL)
+    {
+        sampler = (dae_sampler_type*) daeu_idmap_find(
+            ids,
+            *channel->at_source);
+    }
+    if(sampler != NULL && dae_get_typeid(sampler) == dae_ID_SAMPLER_TYPE)
+    {
+        size_t i;
+        b->sampler = sampler;
+        for(i = 0; i < sampler->el_input.size; ++i)
+        {
+            dae_input_local_type* input = sampler->el_input.values[i];
+            const char* semantic;
+            const char* uri;
+            daeu_source_binding* src = NULL;
+            if(input->at_semantic == NULL || input->at_source == NULL)
+            {
+                continue;
+            }
+            semantic = *input->at_semantic;
+            uri = *input->at_source;
+            if(semantic == NULL)
+            {
+                continue;
+            }
+            if(!strcmp(semantic, "INPUT"))
+            {
+                src = &b->input;
+            }
+            else if(!strcmp(semantic, "OUTPUT"))
+            {
+                src = &b->output;
+            }
+            else if(!strcmp(semantic, "INTERPOLATION"))
+            {
+                src = &b->interp;
+            }
+            else if(!strcmp(semantic, "IN_TANGENT"))
+            {
+                src = &b->intangent;
+            }
+            else if(!strcmp(semantic, "OUT_TANGENT"))
+            {
+                src = &b->outtangent;
+            }
+            if(src != NULL)
+            {
+                daeu_bind_source(
+                    (dae_source_type*) daeu_idmap_find(ids, uri),
+                    src);
+            }
+        }
+        if(b->input.data != NULL && b->output.data != NULL)
+        {
+            b->numkeys = b->input.count;
+            if(b->output.count < b->numkeys)
+            {
+                b->numkeys = b->output.count;
+            }
+            result = b->numkeys > 0;
+        }
+        if(b->interp.names != NULL)
+        {
+            for(i = 0; i < b->numkeys && i < b->interp.count; ++i)
+            {
+                const char* name = b->interp.names[i*b->interp.stride];
+                if(daeu_anim_get_interp(name) == daeu_ANIM_BEZIER)
+                {
+                    b->iscurved = 1;
+                    break;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+static int daeu_anim_resolve_target(
+    const daeu_idmap* ids,
+    const char* target,
+    unsigned stride,
+    dae_obj_ptr* obj_out,
+    float** data_out)
+{
+    // the first segment of a target is an id, the remainder a sid path
+    // resolved below the element with that id
+    int result = 0;
+    const char* end = strpbrk(target, "/.(");
+    *obj_out = NULL;
+    *data_out = NULL;
+    if(end != NULL && end != target)
+    {
+        char id[256];
+        size_t len = (size_t) (end - target);
+        dae_obj_ptr root;
+        if(len >= sizeof(id))
+        {
+            return 0;
+        }
+        memcpy(id, target, len);
+        id[len] = '\0';
+        root = daeu_idmap_find(ids, id);
+        if(root != NULL)
+        {
+            dae_obj_ptr obj = NULL;
+            int index;
+            if(daeu_search_sid(root, target, &obj, &index) > 0)
+            {
+                dae_native_typeid datatype;
+                float* data;
+                size_t datalen;
+                // the clip writes through this pointer, so a data vector
+                // shared with a clone must be copied first
+                if(dae_get_mutable_data(
+                    obj,
+                    &datatype,
+                    (void**) &data,
+                    &datalen) > 0)
+                {
+                    if(datatype == dae_NATIVE_FLOAT)
+                    {
+                        if(index >= 0)
+                        {
+                            data += index;
+                            datalen = 1;
+                        }
+                        // every key must fit within the target
+                        if(stride <= datalen)
+                        {
+                            *obj_out = obj;
+                            *data_out = data;
+                            result = 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+static daeu_anim_behavior daeu_anim_get_behavior(
+    const dae_sampler_behavior_enum* behavior)
+{
+    // GRADIENT and CYCLE_RELATIVE are approximated by CONSTANT and CYCLE
+    daeu_anim_behavior result = daeu_ANIM_CONSTANT;
+    if(behavior != NULL && *behavior != NULL)
+    {
+        if(!strncmp(*behavior, "CYCLE", 5))
+        {
+            result = daeu_ANIM_CYCLE;
+        }
+        else if(!strcmp(*behavior, "OSCILLATE"))
+        {
+            result = daeu_ANIM_OSCILLATE;
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+static void daeu_anim_get_tangent(
+    const daeu_source_binding* src,
+    size_t key,
+    size_t component,
+    size_t stride,
+    float* t_out,
+    float* v_out)
+{
+    // tangents are either (time, value) pairs per component, or values only
+    if(src->data != NULL && key < src->count)
+    {
+        const float* tan = src->data + key*src->stride;
+        if(src->stride >= stride*2)
+        {
+            *t_out = tan[component*2 + 0];
+            *v_out = tan[component*2 + 1];
+        }
+        else if(component < src->stride)
+        {
+            *v_out = tan[component];
+        }
+    }
+}
+
+//****************************************************************************
+static void daeu_anim_compile_tangents(
+    const daeu_anim_binding* b,
+    const float* times,
+    const unsigned char* interps,
+    const float* values,
+    unsigned stride,
+    float* tangents)
+{
+    size_t n = b->numkeys;
+    size_t k;
+    unsigned c;
+    for(k = 0; k + 1 < n; ++k)
+    {
+        float t0 = times[k];
+        float t1 = times[k + 1];
+        float dt = t1 - t0;
+        const char* name = NULL;
+        if(b->interp.names != NULL && k < b->interp.count)
+        {
+            name = b->interp.names[k*b->interp.stride];
+        }
+        for(c = 0; c < stride; ++c)
+        {
+            float p0 = values[k*stride + c];
+            float p1 = values[(k + 1)*stride + c];
+            float* cp = tangents + (k*stride + c)*4;
+            // default to the control points of a straight line
+            cp[0] = 1.0f/3.0f;
+            cp[1] = p0 + (p1 - p0)*(1.0f/3.0f);
+            cp[2] = 2.0f/3.0f;
+            cp[3] = p0 + (p1 - p0)*(2.0f/3.0f);
+            if(interps[k] != daeu_ANIM_BEZIER || name == NULL)
+            {
+                continue;
+            }
+            if(!strcmp(name, "BEZIER"))
+            {
+                // control points are absolute (time, value) pairs
+                float x1 = t0 + dt*cp[0];
+                float x2 = t0 + dt*cp[2];
+                daeu_anim_get_tangent(&b->outtangent,k,c,stride,&x1,&cp[1]);
+                daeu_anim_get_tangent(&b->intangent,k+1,c,stride,&x2,&cp[3]);
+                if(dt > 0.0f)
+                {
+                    cp[0] = (x1 - t0)/dt;
+                    cp[2] = (x2 - t0)/dt;
+                }
+            }
+            else
+            {
+                // hermite tangents are slopes over the segment, which map to
+                // bezier control points a third of the way along it
+                float x = 0.0f;
+                float m0 = p1 - p0;
+                float m1 = p1 - p0;
+                if(!strcmp(name, "HERMITE"))
+                {
+                    daeu_anim_get_tangent(&b->outtangent,k,c,stride,&x,&m0);
+                    daeu_anim_get_tangent(&b->intangent,k+1,c,stride,&x,&m1);
+                }
+                else
+                {
+                    // CARDINAL, with zero tension
+                    float pp = (k > 0) ? values[(k - 1)*stride + c] : p0;
+                    float pn = (k + 2 < n) ? values[(k + 2)*stride + c] : p1;
+                    m0 = (p1 - pp)*0.5f;
+                    m1 = (pn - p0)*0.5f;
+                }
+                cp[1] = p0 + m0*(1.0f/3.0f);
+                cp[3] = p1 - m1*(1.0f/3.0f);
+            }
+            // keep the time curve monotonic
+            cp[0] = (cp[0] < 0.0f) ? 0.0f : ((cp[0] > 1.0f) ? 1.0f : cp[0]);
+            cp[2] = (cp[2] < 0.0f) ? 0.0f : ((cp[2] > 1.0f) ? 1.0f : cp[2]);
+        }
+    }
+}
+
+//****************************************************************************
+static size_t daeu_anim_find_key(
+    const float* times,
+    size_t numkeys,
+    size_t cursor,
+    float t)
+{
+    // returns the key beginning the segment that contains t. The cached
+    // cursor and its neighbours are checked before falling back to a binary
+    // search of the remaining keys
+    size_t last = numkeys - 2;
+    size_t lo;
+    size_t hi;
+    int i;
+    cursor = (cursor < last) ? cursor : last;
+    if(t >= times[cursor])
+    {
+        for(i = 0; i < 4; ++i)
+        {
+            if(cursor == last || t < times[cursor + 1])
+            {
+                return cursor;
+            }
+            ++cursor;
+        }
+        lo = cursor;
+        hi = numkeys - 1;
+    }
+    else
+    {
+        for(i = 0; i < 4 && cursor > 0; ++i)
+        {
+            --cursor;
+            if(t >= times[cursor])
+            {
+                return cursor;
+            }
+        }
+        lo = 0;
+        hi = cursor;
+    }
+    while(hi - lo > 1)
+    {
+        size_t mid = lo + (hi - lo)/2;
+        if(times[mid] <= t)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+//****************************************************************************
+static float daeu_anim_bezier(
+    const float* cp,
+    float p0,
+    float p1,
+    float u)
+{
+    // cp holds the normalized times and values of the two control points.
+    // The curve parameter for u is found by newton iterations, which are
+    // skipped when the control times make the time curve linear
+    float s = u;
+    float is;
+    if(fabsf(cp[0] - 1.0f/3.0f) > 1e-5f || fabsf(cp[2] - 2.0f/3.0f) > 1e-5f)
+    {
+        float lo = 0.0f;
+        float hi = 1.0f;
+        int i;
+        for(i = 0; i < 16; ++i)
+        {
+            float is2;
+            float x;
+            float dx;
+            is = 1.0f - s;
+            is2 = is*is;
+            x = 3.0f*is2*s*cp[0] + 3.0f*is*s*s*cp[2] + s*s*s;
+            if(fabsf(x - u) < 1e-6f)
+            {
+                break;
+            }
+            if(x < u)
+            {
+                lo = s;
+            }
+            else
+            {
+                hi = s;
+            }
+            dx = 3.0f*is2*cp[0] + 6.0f*is*s*(cp[2] - cp[0]) +
+                3.0f*s*s*(1.0f - cp[2]);
+            s = (dx > 1e-6f) ? s - (x - u)/dx : -1.0f;
+            if(s <= lo || s >= hi)
+            {
+                // bisect when newton leaves the bracket
+                s = (lo + hi)*0.5f;
+            }
+        }
+    }
+    is = 1.0f - s;
+    return is*is*is*p0 + 3.0f*is*is*s*cp[1] + 3.0f*is*s*s*cp[3] + s*s*s*p1;
+}
+
+//****************************************************************************
+static void daeu_anim_sample(
+    const daeu_anim* anim,
+    const daeu_anim_track* track,
+    size_t* cursor,
+    float t,
+    float* out)
+{
+    const float* times = anim->times + track->firstkey;
+    const float* values = anim->values + track->firstvalue;
+    size_t n = track->numkeys;
+    unsigned stride = track->stride;
+    float start = times[0];
+    float end = times[n - 1];
+    float len = end - start;
+    const float* v0;
+    const float* v1;
+    float u;
+    size_t k;
+    unsigned c;
+    if(n == 1 || len <= 0.0f)
+    {
+        memcpy(out, values, stride*sizeof(float));
+        return;
+    }
+    if(t < start || t > end)
+    {
+        daeu_anim_behavior behavior;
+        behavior = (t < start) ? track->prebehavior : track->postbehavior;
+        if(behavior == daeu_ANIM_CONSTANT)
+        {
+            t = (t < start) ? start : end;
+        }
+        else
+        {
+            float cycles = floorf((t - start)/len);
+            float f = (t - start) - cycles*len;
+            if(behavior == daeu_ANIM_OSCILLATE && fmodf(cycles, 2.0f) != 0.0f)
+            {
+                f = len - f;
+            }
+            t = start + f;
+        }
+    }
+    k = daeu_anim_find_key(times, n, *cursor, t);
+    *cursor = k;
+    if(times[k + 1] > times[k])
+    {
+        u = (t - times[k])/(times[k + 1] - times[k]);
+        u = (u < 0.0f) ? 0.0f : ((u > 1.0f) ? 1.0f : u);
+    }
+    else
+    {
+        // two keys at the same time are a jump, already taken at that time
+        u = 1.0f;
+    }
+    v0 = values + k*stride;
+    v1 = v0 + stride;
+    switch(anim->interps[track->firstkey + k])
+    {
+    case daeu_ANIM_STEP:
+        memcpy(out, (u < 1.0f) ? v0 : v1, stride*sizeof(float));
+        break;
+    case daeu_ANIM_BEZIER:
+        {
+            const float* cp = anim->tangents + track->firsttangent;
+            cp += k*stride*4;
+            for(c = 0; c < stride; ++c)
+            {
+                out[c] = daeu_anim_bezier(cp + c*4, v0[c], v1[c], u);
+            }
+        }
+        break;
+    default:
+        for(c = 0; c < stride; ++c)
+        {
+            out[c] = v0[c] + (v1[c] - v0[c])*u;
+        }
+        break;
+    }
+}
+
+//****************************************************************************
+void daeu_anim_apply(
+    daeu_anim* anim,
+    float t)
+{
+    size_t i;
+    for(i = 0; i < anim->numtracks; ++i)
+    {
+        daeu_anim_track* track = anim->tracks + i;
+        dae_native_typeid datatype;
+        float* data;
+        size_t datalen;
+        // the target is looked up again, because it may have been cloned
+        // since it was compiled, and a shared vector must be copied before
+        // it is written
+        if(track->targetobj != NULL && dae_get_mutable_data(
+            track->targetobj,
+            &datatype,
+            (void**) &data,
+            &datalen) > 0)
+        {
+            if(datatype == dae_NATIVE_FLOAT &&
+                track->targetoffset + track->stride <= datalen)
+            {
+                track->target = data + track->targetoffset;
+                daeu_anim_sample(
+                    anim,
+                    track,
+                    anim->cursors + i,
+                    t,
+                    track->target);
+            }
+        }
+    }
+}
+
+//****************************************************************************
+static void daeu_anim_bake_task(
+    void* userdata,
+    size_t index,
+    int worker)
+{
+    daeu_anim_batch* batch = (daeu_anim_batch*) userdata;
+    const daeu_anim* anim = batch->anim;
+    daeu_anim_clip* clip = batch->clip;
+    const daeu_anim_track* track = anim->tracks + index;
+    size_t stride = track->stride;
+    size_t framesize = clip->framesize;
+    size_t numframes = clip->numframes;
+    size_t cursor = 0;
+    float* samples;
+    size_t f;
+    if(clip->samples != NULL)
+    {
+        // write straight into the frames
+        samples = clip->samples + track->output;
+    }
+    else
+    {
+        // sample into scratch space to find the range before quantizing
+        samples = (float*) malloc(numframes*stride*sizeof(float));
+        framesize = stride;
+    }
+    for(f = 0; f < numframes; ++f)
+    {
+        float t = clip->start + ((float) f)/clip->rate;
+        t = (f == numframes - 1 && t > anim->end) ? anim->end : t;
+        daeu_anim_sample(anim, track, &cursor, t, samples + f*framesize);
+    }
+    if(clip->quantized != NULL)
+    {
+        unsigned short* q = clip->quantized + track->output;
+        size_t n = numframes*stride;
+        float lo = samples[0];
+        float hi = samples[0];
+        float scale;
+        size_t i;
+        for(i = 1; i < n; ++i)
+        {
+            lo = (samples[i] < lo) ? samples[i] : lo;
+            hi = (samples[i] > hi) ? samples[i] : hi;
+        }
+        scale = (hi > lo) ? 65535.0f/(hi - lo) : 0.0f;
+        for(f = 0; f < numframes; ++f)
+        {
+            for(i = 0; i < stride; ++i)
+            {
+                float v = (samples[f*stride + i] - lo)*scale + 0.5f;
+                q[f*clip->framesize + i] = (unsigned short) v;
+            }
+        }
+        clip->ranges[index*2 + 0] = lo;
+        clip->ranges[index*2 + 1] = (hi > lo) ? (hi - lo)/65535.0f : 0.0f;
+        free(samples);
+    }
+}
+
+//****************************************************************************
+int daeu_anim_bake(
+    const daeu_anim* anim,
+    float rate,
+    int quantize,
+    int numthreads,
+    daeu_anim_clip* clip_out)
+{
+    daeu_anim_batch batch;
+    memset(clip_out, 0, sizeof(*clip_out));
+    if(!(rate > 0.0f))
+    {
+        return -1;
+    }
+    clip_out->start = anim->start;
+    clip_out->rate = rate;
+    clip_out->framesize = anim->numoutputs;
+    // enough frames to reach the end, the last one is clamped to it
+    clip_out->numframes = (size_t) ceilf((anim->end - anim->start)*rate) + 1;
+    if(quantize)
+    {
+        clip_out->quantized = (unsigned short*) malloc(
+            clip_out->numframes*clip_out->framesize*sizeof(unsigned short)
+            + 1);
+        clip_out->ranges = (float*) malloc(
+            anim->numtracks*2*sizeof(float) + 1);
+    }
+    else
+    {
+        clip_out->samples = (float*) malloc(
+            clip_out->numframes*clip_out->framesize*sizeof(float) + 1);
+    }
+    batch.anim = anim;
+    batch.clip = clip_out;
+    if(anim->numtracks > 0)
+    {
+        daeu_pool_run(
+            anim->numtracks,
+            NULL,
+            daeu_pool_count_workers(anim->numtracks, numthreads),
+            daeu_anim_bake_task,
+            &batch);
+    }
+    return 0;
+}
+
+//****************************************************************************
+void daeu_anim_clip_destroy(
+    daeu_anim_clip* clip)
+{
+    free(clip->samples);
+    free(clip->quantized);
+    free(clip->ranges);
+    memset(clip, 0, sizeof(*clip));
+}
+
+//****************************************************************************
+int daeu_anim_compile(
+    dae_COLLADA* doc,
+    daeu_anim* anim_out)
+{
+    int result = 0;
+    daeu_idmap ids;
+    daeu_anim_binding* bindings = NULL;
+    size_t numbindings = 0;
+    size_t capbindings = 0;
+    size_t numkeys = 0;
+    size_t numvalues = 0;
+    size_t numtangents = 0;
+    size_t key = 0;
+    size_t value = 0;
+    size_t tangent = 0;
+    size_t output = 0;
+    dae_obj_ptr itr;
+    size_t i;
+
+    memset(anim_out, 0, sizeof(*anim_out));
+    daeu_idmap_create(doc, &ids);
+    // bind every channel to its sampler and sources, sizing the key arrays
+    for(itr = doc; itr != NULL; itr = daeu_walk_next(doc, itr))
+    {
+        daeu_anim_binding* b;
+        if(dae_get_typeid(itr) != dae_ID_CHANNEL_TYPE)
+        {
+            continue;
+        }
+        if(numbindings == capbindings)
+        {
+            capbindings = (capbindings > 0) ? capbindings*2 : 64;
+            bindings = (daeu_anim_binding*) realloc(
+                bindings,
+                capbindings*sizeof(*bindings));
+        }
+        b = bindings + numbindings;
+        if(!daeu_anim_bind_channel(&ids, (dae_channel_type*) itr, b))
+        {
+            // invalid sampler, the channel is skipped
+            result = -1;
+            continue;
+        }
+        numkeys += b->numkeys;
+        numvalues += b->numkeys * b->output.stride;
+        if(b->iscurved)
+        {
+            numtangents += b->numkeys * b->output.stride * 4;
+        }
+        ++numbindings;
+    }
+
+    anim_out->times = (float*) malloc(numkeys*sizeof(float) + 1);
+    anim_out->interps = (unsigned char*) malloc(numkeys + 1);
+    anim_out->values = (float*) malloc(numvalues*sizeof(float) + 1);
+    anim_out->tangents = (float*) malloc(numtangents*sizeof(float) + 1);
+    anim_out->tracks = (daeu_anim_track*) malloc(
+        numbindings*sizeof(daeu_anim_track) + 1);
+    anim_out->cursors = (size_t*) calloc(numbindings + 1, sizeof(size_t));
+    anim_out->numtracks = numbindings;
+    anim_out->numkeys = numkeys;
+    anim_out->numvalues = numvalues;
+    anim_out->numtangents = numtangents;
+
+    for(i = 0; i < numbindings; ++i)
+    {
+        const daeu_anim_binding* b = bindings + i;
+        daeu_anim_track* track = anim_out->tracks + i;
+        float* times = anim_out->times + key;
+        unsigned char* interps = anim_out->interps + key;
+        float* values = anim_out->values + value;
+        unsigned stride = (unsigned) b->output.stride;
+        const char* target = NULL;
+        size_t k;
+
+        track->channel = b->channel;
+        track->targetoffset = 0;
+        track->firstkey = key;
+        track->numkeys = b->numkeys;
+        track->firstvalue = value;
+        track->firsttangent = b->iscurved ? tangent : (size_t) -1;
+        track->output = output;
+        track->stride = stride;
+        track->prebehavior = daeu_anim_get_behavior(
+            b->sampler->at_pre_behavior);
+        track->postbehavior = daeu_anim_get_behavior(
+            b->sampler->at_post_behavior);
+        // gather the keys
+        for(k = 0; k < b->numkeys; ++k)
+        {
+            const char* name = NULL;
+            times[k] = b->input.data[k*b->input.stride];
+            memcpy(
+                values + k*stride,
+                b->output.data + k*stride,
+                stride*sizeof(float));
+            if(b->interp.names != NULL && k < b->interp.count)
+            {
+                name = b->interp.names[k*b->interp.stride];
+            }
+            interps[k] = (unsigned char) daeu_anim_get_interp(name);
+        }
+        if(b->iscurved)
+        {
+            daeu_anim_compile_tangents(
+                b,
+                times,
+                interps,
+                values,
+                stride,
+                anim_out->tangents + tangent);
+            tangent += b->numkeys * stride * 4;
+        }
+        if(key == 0 || times[0] < anim_out->start)
+        {
+            anim_out->start = times[0];
+        }
+        if(key == 0 || times[b->numkeys - 1] > anim_out->end)
+        {
+            anim_out->end = times[b->numkeys - 1];
+        }
+        // resolve the target
+        if(b->channel->at_target != NULL)
+        {
+            target = *b->channel->at_target;
+        }
+        if(target == NULL || !daeu_anim_resolve_target(
+            &ids,
+            target,
+            stride,
+            &track->targetobj,
+            &track->target))
+        {
+            result = -1;
+        }
+        else
+        {
+            dae_native_typeid datatype;
+            float* base;
+            size_t datalen;
+            dae_get_data(
+                track->targetobj,
+                &datatype,
+                (void**) &base,
+                &datalen);
+            track->targetoffset = (size_t) (track->target - base);
+        }
+        key += b->numkeys;
+        value += b->numkeys * stride;
+        output += stride;
+    }
+    anim_out->numoutputs = output;
+
+    free(bindings);
+    daeu_idmap_destroy(&ids);
+    return result;
+}
+
+//****************************************************************************
+void daeu_anim_destroy(
+    daeu_anim* anim)
+{
+    free(anim->times);
+    free(anim->interps);
+    free(anim->values);
+    free(anim->tangents);
+    free(anim->tracks);
+    free(anim->cursors);
+    memset(anim, 0, sizeof(*anim));
+}
+
+//****************************************************************************
+void daeu_anim_evaluate(
+    daeu_anim* anim,
+    float t,
+    float* values_out)
+{
+    size_t i;
+    for(i = 0; i < anim->numtracks; ++i)
+    {
+        const daeu_anim_track* track = anim->tracks + i;
+        daeu_anim_sample(
+            anim,
+            track,
+            anim->cursors + i,
+            t,
+            values_out + track->output);
+    }
+}
+
+//****************************************************************************
+#ifdef daeu_AVX
+static daeu_AVX_FN void daeu_morph_blend_avx(
+    float* dst,
+    const float* src,
+    float w,
+    size_t n,
+    int accumulate)
+{
+    __m256 w8 = _mm256_set1_ps(w);
+    size_t i = 0;
+    if(accumulate)
+    {
+        for(; i + 8 <= n; i += 8)
+        {
+            __m256 d = _mm256_loadu_ps(dst + i);
+            d = _mm256_add_ps(d, _mm256_mul_ps(w8, _mm256_loadu_ps(src + i)));
+            _mm256_storeu_ps(dst + i, d);
+        }
+        for(; i < n; ++i)
+        {
+            dst[i] += src[i]*w;
+        }
+    }
+    else
+    {
+        for(; i + 8 <= n; i += 8)
+        {
+            _mm256_storeu_ps(
+                dst + i,
+                _mm256_mul_ps(w8, _mm256_loadu_ps(src + i)));
+        }
+        for(; i < n; ++i)
+        {
+            dst[i] = src[i]*w;
+        }
+    }
+}
+#endif
+
+//****************************************************************************
+static void daeu_morph_blend_range(
+    float* dst,
+    const float* src,
+    float w,
+    size_t n,
+    int accumulate)
+{
+    // dst = w*src, or dst += w*src when accumulating
+    size_t i = 0;
+#ifdef daeu_SSE
+    __m128 w4 = _mm_set1_ps(w);
+    if(accumulate)
+    {
+        for(; i + 4 <= n; i += 4)
+        {
+            __m128 d = _mm_loadu_ps(dst + i);
+            d = _mm_add_ps(d, _mm_mul_ps(w4, _mm_loadu_ps(src + i)));
+            _mm_storeu_ps(dst + i, d);
+        }
+    }
+    else
+    {
+        for(; i + 4 <= n; i += 4)
+        {
+            _mm_storeu_ps(dst + i, _mm_mul_ps(w4, _mm_loadu_ps(src + i)));
+        }
+    }
+#endif
+    if(accumulate)
+    {
+        for(; i < n; ++i)
+        {
+            dst[i] += src[i]*w;
+        }
+    }
+    else
+    {
+        for(; i < n; ++i)
+        {
+            dst[i] = src[i]*w;
+        }
+    }
+}
+
+//****************************************************************************
+static void daeu_morph_blend_task(
+    void* userdata,
+    size_t index,
+    int worker)
+{
+    // each chunk is small enough to stay in cache while every target is
+    // accumulated into it
+    const daeu_morph_batch* b = (const daeu_morph_batch*) userdata;
+    size_t begin = index*b->chunk;
+    size_t n = b->chunk;
+    size_t i;
+    n = (begin + n < b->count) ? n : b->count - begin;
+#ifdef daeu_AVX
+    if(b->avx)
+    {
+        daeu_morph_blend_avx(
+            b->vertices + begin,
+            b->base->vertices + begin,
+            b->baseweight,
+            n,
+            0);
+        for(i = 0; i < b->numtargets; ++i)
+        {
+            daeu_morph_blend_avx(
+                b->vertices + begin,
+                b->targets[i].vertices + begin,
+                b->weights[i],
+                n,
+                1);
+        }
+        return;
+    }
+#endif
+    daeu_morph_blend_range(
+        b->vertices + begin,
+        b->base->vertices + begin,
+        b->baseweight,
+        n,
+        0);
+    for(i = 0; i < b->numtargets; ++i)
+    {
+        daeu_morph_blend_range(
+            b->vertices + begin,
+            b->targets[i].vertices + begin,
+            b->weights[i],
+            n,
+            1);
+    }
+}
+
+//****************************************************************************
+int daeu_morph_blend(
+    const daeu_mesh* base,
+    const daeu_mesh* targets,
+    const float* weights,
+    size_t numtargets,
+    daeu_morph_method method,
+    int numthreads,
+    float* vertices_out)
+{
+    daeu_morph_batch batch;
+    size_t numchunks;
+    size_t i;
+    memset(&batch, 0, sizeof(batch));
+    batch.count = base->numvertices*base->vertexsize;
+    batch.baseweight = 1.0f;
+    for(i = 0; i < numtargets; ++i)
+    {
+        // targets are blended float by float, so their layouts must match
+        if(targets[i].numvertices != base->numvertices ||
+           targets[i].vertexsize != base->vertexsize)
+        {
+            return -1;
+        }
+        if(method == daeu_MORPH_NORMALIZED)
+        {
+            batch.baseweight -= weights[i];
+        }
+    }
+    batch.base = base;
+    batch.targets = targets;
+    batch.weights = weights;
+    batch.numtargets = numtargets;
+    batch.vertices = vertices_out;
+    batch.chunk = 16384;
+#ifdef daeu_AVX
+    batch.avx = daeu_matrix_has_avx();
+#endif
+    numchunks = (batch.count + batch.chunk - 1)/batch.chunk;
+    if(numchunks > 0)
+    {
+        daeu_pool_run(
+            numchunks,
+            NULL,
+            daeu_pool_count_workers(numchunks, numthreads),
+            daeu_morph_blend_task,
+            &batch);
+    }
+    return 0;
+}
+
+//****************************************************************************
+int daeu_morph_compile(
+    dae_COLLADA* doc,
+    dae_morph_type* morph,
+    daeu_morph* morph_out)
+{
+    int result = 0;
+    daeu_idmap ids;
+    daeu_source_binding targetsrc;
+    daeu_source_binding weightsrc;
+    size_t i;
+    memset(morph_out, 0, sizeof(*morph_out));
+    memset(&targetsrc, 0, sizeof(targetsrc));
+    memset(&weightsrc, 0, sizeof(weightsrc));
+    if(morph->at_method != NULL && *morph->at_method != NULL)
+    {
+        if(!strcmp(*morph->at_method, "RELATIVE"))
+        {
+            morph_out->method = daeu_MORPH_RELATIVE;
+        }
+    }
+    if(morph->el_targets != NULL)
+    {
+        for(i = 0; i < morph->el_targets->el_input.size; ++i)
+        {
+            dae_input_local_type* input;
+            dae_source_type* src;
+            input = morph->el_targets->el_input.values[i];
+            if(input->at_semantic == NULL || input->at_source == NULL)
+            {
+                continue;
+            }
+            src = daeu_find_source(
+                morph->el_source.values,
+                morph->el_source.size,
+                *input->at_source);
+            if(!strcmp(*input->at_semantic, "MORPH_TARGET"))
+            {
+                daeu_bind_source(src, &targetsrc);
+            }
+            else if(!strcmp(*input->at_semantic, "MORPH_WEIGHT"))
+            {
+                daeu_bind_source(src, &weightsrc);
+            }
+        }
+    }
+    if(targetsrc.names == NULL)
+    {
+        return -1;
+    }
+    daeu_idmap_create(doc, &ids);
+    if(morph->at_source != NULL)
+    {
+        morph_out->base = (dae_geometry_type*) daeu_idmap_find(
+            &ids,
+            *morph->at_source);
+    }
+    morph_out->numtargets = targetsrc.count;
+    morph_out->targets = (dae_geometry_type**) malloc(
+        (targetsrc.count + 1)*sizeof(*morph_out->targets));
+    morph_out->weights = (float*) malloc(
+        (targetsrc.count + 1)*sizeof(*morph_out->weights));
+    for(i = 0; i < targetsrc.count; ++i)
+    {
+        dae_geometry_type* geo = (dae_geometry_type*) daeu_idmap_find(
+            &ids,
+            targetsrc.names[i*targetsrc.stride]);
+        if(geo != NULL && dae_get_typeid(geo) != dae_ID_GEOMETRY_TYPE)
+        {
+            geo = NULL;
+        }
+        morph_out->targets[i] = geo;
+        morph_out->weights[i] = 0.0f;
+        if(weightsrc.data != NULL && i < weightsrc.count)
+        {
+            morph_out->weights[i] = weightsrc.data[i*weightsrc.stride];
+        }
+        result = (geo == NULL) ? -1 : result;
+    }
+    if(morph_out->base == NULL ||
+       dae_get_typeid(morph_out->base) != dae_ID_GEOMETRY_TYPE)
+    {
+        morph_out->base = NULL;
+        result = -1;
+    }
+    daeu_idmap_destroy(&ids);
+    return result;
+}
+
+//****************************************************************************
+void daeu_morph_destroy(
+    daeu_morph* morph)
+{
+    free(morph->targets);
+    free(morph->weights);
+    memset(morph, 0, sizeof(*morph));
+}
+
+//****************************************************************************
+static daeu_up_axis daeu_units_get_axis(
+    const char* name)
+{
+    daeu_up_axis result = daeu_Y_UP;
+    if(name != NULL)
+    {
+        if(!strcmp(name, "X_UP"))
+        {
+            result = daeu_X_UP;
+        }
+        else if(!strcmp(name, "Z_UP"))
+        {
+            result = daeu_Z_UP;
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+static void daeu_units_get_scope(
+    dae_obj_ptr obj,
+    float* meter_out,
+    daeu_up_axis* upaxis_out)
+{
+    // the unit and up axis of an element come from the nearest asset in its
+    // ancestry that defines each of them. assets are the first child of the
+    // element that owns them, except at the root where one may be appended
+    int hasmeter = 0;
+    int hasaxis = 0;
+    *meter_out = 1.0f;
+    *upaxis_out = daeu_Y_UP;
+    while(obj != NULL && !(hasmeter && hasaxis))
+    {
+        dae_obj_ptr parent = dae_get_parent(obj);
+        dae_asset_type* asset = (dae_asset_type*) dae_get_first_element(obj);
+        if(parent == NULL && dae_get_typeid(obj) == dae_ID_COLLADA)
+        {
+            asset = ((dae_COLLADA*) obj)->el_asset;
+        }
+        if(asset != NULL && dae_get_typeid(asset) == dae_ID_ASSET_TYPE)
+        {
+            dae_asset_type_unit* unit = asset->el_unit;
+            if(!hasmeter && unit != NULL && unit->at_meter != NULL)
+            {
+                if(*unit->at_meter > 0.0f)
+                {
+                    *meter_out = *unit->at_meter;
+                }
+                hasmeter = 1;
+            }
+            if(!hasaxis && asset->el_up_axis != NULL)
+            {
+                *upaxis_out = daeu_units_get_axis(*asset->el_up_axis);
+                hasaxis = 1;
+            }
+        }
+        obj = parent;
+    }
+}
+
+//****************************************************************************
+static int daeu_units_create(
+    dae_obj_ptr obj,
+    float meter,
+    daeu_up_axis upaxis,
+    daeu_units* units_out)
+{
+    // builds the conversion for the data of an element, returning 0 if the
+    // element is already in the requested unit and up axis. the columns of
+    // each basis are the right, up and in vectors of that up axis
+    static const float s_basis[3][9] =
+    {
+        // X_UP: right is -Y, up is X, in is Z
+        {  0.0f, 1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+        // Y_UP
+        {  1.0f, 0.0f, 0.0f,  0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+        // Z_UP: right is X, up is Z, in is -Y
+        {  1.0f, 0.0f, 0.0f,  0.0f, 0.0f,-1.0f, 0.0f, 1.0f, 0.0f }
+    };
+    const float* b0;
+    const float* b1;
+    float srcmeter;
+    daeu_up_axis srcaxis;
+    int isidentity;
+    unsigned i;
+    unsigned k;
+    daeu_units_get_scope(obj, &srcmeter, &srcaxis);
+    b0 = s_basis[srcaxis];
+    b1 = s_basis[upaxis];
+    units_out->scale = srcmeter/meter;
+    isidentity = units_out->scale == 1.0f;
+    for(i = 0; i < 3; ++i)
+    {
+        // the conversion is the product of the target basis and the
+        // transpose of the source basis, a signed permutation
+        for(k = 0; k < 3; ++k)
+        {
+            float p =
+                b1[i*3 + 0]*b0[k*3 + 0] +
+                b1[i*3 + 1]*b0[k*3 + 1] +
+                b1[i*3 + 2]*b0[k*3 + 2];
+            if(p != 0.0f)
+            {
+                units_out->perm[i] = k;
+                units_out->sign[i] = p;
+            }
+        }
+        if(units_out->perm[i] != i || units_out->sign[i] < 0.0f)
+        {
+            isidentity = 0;
+        }
+    }
+    return !isidentity;
+}
+
+//****************************************************************************
+static int daeu_units_get_kind(
+    dae_obj_ptr obj,
+    unsigned* size_out)
+{
+    // returns the conversion for the values of a transform element, or -1
+    int kind = -1;
+    unsigned size = 0;
+    switch(dae_get_typeid(obj))
+    {
+    case dae_ID_LOOKAT_TYPE:
+        kind = daeu_UNITS_LOOKAT;
+        size = 9;
+        break;
+    case dae_ID_MATRIX_TYPE:
+        kind = daeu_UNITS_MATRIX;
+        size = 16;
+        break;
+    case dae_ID_ROTATE_TYPE:
+        kind = daeu_UNITS_ROTATE;
+        size = 4;
+        break;
+    case dae_ID_SCALE_TYPE:
+        kind = daeu_UNITS_SCALE;
+        size = 3;
+        break;
+    case dae_ID_SKEW_TYPE:
+        kind = daeu_UNITS_SKEW;
+        size = 7;
+        break;
+    case dae_ID_TRANSLATE_TYPE:
+        kind = daeu_UNITS_POINT;
+        size = 3;
+        break;
+    case dae_ID_FLOAT4X4_TYPE:
+        if(!strcmp(dae_get_name(obj), "bind_shape_matrix"))
+        {
+            kind = daeu_UNITS_MATRIX;
+            size = 16;
+        }
+        break;
+    default:
+        break;
+    }
+    if(kind >= 0)
+    {
+        dae_native_typeid datatype;
+        void* data;
+        size_t datalen;
+        if(dae_get_data(obj, &datatype, &data, &datalen) == 0 ||
+            datatype != dae_NATIVE_FLOAT ||
+            datalen < size)
+        {
+            kind = -1;
+        }
+    }
+    *size_out = size;
+    return kind;
+}
+
+//****************************************************************************
+static int daeu_units_remap(
+    const daeu_units* u,
+    int kind,
+    int index,
+    int* index_out,
+    float* factor_out)
+{
+    // maps a single animated value of a transform element to its index and
+    // multiplier after conversion. returns 0 if neither changes
+    unsigned inv[3];
+    unsigned i;
+    int g;
+    int c;
+    for(i = 0; i < 3; ++i)
+    {
+        inv[u->perm[i]] = i;
+    }
+    *index_out = index;
+    *factor_out = 1.0f;
+    switch(kind)
+    {
+    case daeu_UNITS_POINT:
+    case daeu_UNITS_ROTATE:
+    case daeu_UNITS_SCALE:
+        if(index < 3)
+        {
+            i = inv[index];
+            *index_out = (int) i;
+            if(kind == daeu_UNITS_POINT)
+            {
+                *factor_out = u->sign[i]*u->scale;
+            }
+            else if(kind == daeu_UNITS_ROTATE)
+            {
+                *factor_out = u->sign[i];
+            }
+        }
+        break;
+    case daeu_UNITS_LOOKAT:
+        // eye and interest positions, then the up direction
+        g = index/3;
+        i = inv[index%3];
+        *index_out = g*3 + (int) i;
+        *factor_out = u->sign[i]*((g < 2) ? u->scale : 1.0f);
+        break;
+    case daeu_UNITS_SKEW:
+        // the angle, then the rotation and translation axes
+        if(index > 0)
+        {
+            g = (index - 1)/3;
+            i = inv[(index - 1)%3];
+            *index_out = 1 + g*3 + (int) i;
+            *factor_out = u->sign[i];
+        }
+        break;
+    case daeu_UNITS_MATRIX:
+        {
+            int r = index/4;
+            unsigned j;
+            c = index%4;
+            i = (r < 3) ? inv[r] : 3;
+            j = (c < 3) ? inv[c] : 3;
+            *index_out = (int) (i*4 + j);
+            *factor_out =
+                ((r < 3) ? u->sign[i] : 1.0f) *
+                ((c < 3) ? u->sign[j] : 1.0f) *
+                ((r < 3 && c == 3) ? u->scale : 1.0f);
+        }
+        break;
+    default:
+        break;
+    }
+    return *index_out != index || *factor_out != 1.0f;
+}
+
+//****************************************************************************
+static void daeu_units_vec3(
+    const daeu_units* u,
+    float scale,
+    float* v)
+{
+    float t[3];
+    t[0] = v[0];
+    t[1] = v[1];
+    t[2] = v[2];
+    v[0] = t[u->perm[0]]*u->sign[0]*scale;
+    v[1] = t[u->perm[1]]*u->sign[1]*scale;
+    v[2] = t[u->perm[2]]*u->sign[2]*scale;
+}
+
+//****************************************************************************
+static void daeu_units_convert(
+    const daeu_units_task* task,
+    float* v)
+{
+    const daeu_units* u = &task->units;
+    switch(task->kind)
+    {
+    case daeu_UNITS_POINT:
+        daeu_units_vec3(u, u->scale, v);
+        break;
+    case daeu_UNITS_DIRECTION:
+        daeu_units_vec3(u, 1.0f, v);
+        break;
+    case daeu_UNITS_LOOKAT:
+        daeu_units_vec3(u, u->scale, v + 0);
+        daeu_units_vec3(u, u->scale, v + 3);
+        daeu_units_vec3(u, 1.0f, v + 6);
+        break;
+    case daeu_UNITS_MATRIX:
+        {
+            // conjugate by the axis conversion, then scale the translation
+            float t[16];
+            unsigned i;
+            unsigned j;
+            memcpy(t, v, sizeof(t));
+            for(i = 0; i < 4; ++i)
+            {
+                unsigned r = (i < 3) ? u->perm[i] : 3;
+                float sr = (i < 3) ? u->sign[i] : 1.0f;
+                for(j = 0; j < 4; ++j)
+                {
+                    unsigned c = (j < 3) ? u->perm[j] : 3;
+                    float sc = (j < 3) ? u->sign[j] : 1.0f;
+                    v[i*4 + j] = t[r*4 + c]*sr*sc;
+                }
+                if(i < 3)
+                {
+                    v[i*4 + 3] *= u->scale;
+                }
+            }
+        }
+        break;
+    case daeu_UNITS_ROTATE:
+        // the conversion is a rotation, so the angle is unchanged
+        daeu_units_vec3(u, 1.0f, v);
+        break;
+    case daeu_UNITS_SCALE:
+        {
+            float t[3];
+            t[0] = v[0];
+            t[1] = v[1];
+            t[2] = v[2];
+            v[0] = t[u->perm[0]];
+            v[1] = t[u->perm[1]];
+            v[2] = t[u->perm[2]];
+        }
+        break;
+    case daeu_UNITS_SKEW:
+        daeu_units_vec3(u, 1.0f, v + 1);
+        daeu_units_vec3(u, 1.0f, v + 4);
+        break;
+    case daeu_UNITS_FACTOR:
+        v[0] *= task->factor;
+        break;
+    default:
+        break;
+    }
+}
+
+//****************************************************************************
+static void daeu_units_points(
+    const daeu_units* u,
+    float scale,
+    float* v,
+    size_t count)
+{
+    // converts densely packed xyz tuples
+    float m[3];
+    size_t i = 0;
+    m[0] = u->sign[0]*scale;
+    m[1] = u->sign[1]*scale;
+    m[2] = u->sign[2]*scale;
+#ifdef daeu_SSE
+#define daeu_SHUF(x_, y_, z_, w_) ((x_) | ((y_)<<2) | ((z_)<<4) | ((w_)<<6))
+    {
+        __m128 m0 = _mm_set1_ps(m[0]);
+        __m128 m1 = _mm_set1_ps(m[1]);
+        __m128 m2 = _mm_set1_ps(m[2]);
+        for(; i + 4 <= count; i += 4)
+        {
+            // four tuples are transposed to x, y and z vectors, swizzled
+            // and scaled, then transposed back
+            float* p = v + i*3;
+            __m128 a = _mm_loadu_ps(p + 0);
+            __m128 b = _mm_loadu_ps(p + 4);
+            __m128 c = _mm_loadu_ps(p + 8);
+            __m128 t0 = _mm_shuffle_ps(b, c, daeu_SHUF(2,3,1,2));
+            __m128 t1 = _mm_shuffle_ps(a, b, daeu_SHUF(1,2,0,1));
+            __m128 xyz[3];
+            __m128 x;
+            __m128 y;
+            __m128 z;
+            xyz[0] = _mm_shuffle_ps(a, t0, daeu_SHUF(0,3,0,2));
+            xyz[1] = _mm_shuffle_ps(t1, t0, daeu_SHUF(0,2,1,3));
+            xyz[2] = _mm_shuffle_ps(t1, c, daeu_SHUF(1,3,0,3));
+            x = _mm_mul_ps(xyz[u->perm[0]], m0);
+            y = _mm_mul_ps(xyz[u->perm[1]], m1);
+            z = _mm_mul_ps(xyz[u->perm[2]], m2);
+            t0 = _mm_shuffle_ps(x, y, daeu_SHUF(0,0,0,0));
+            t1 = _mm_shuffle_ps(z, x, daeu_SHUF(0,0,1,1));
+            _mm_storeu_ps(p + 0, _mm_shuffle_ps(t0, t1, daeu_SHUF(0,2,0,2)));
+            t0 = _mm_shuffle_ps(y, z, daeu_SHUF(1,1,1,1));
+            t1 = _mm_shuffle_ps(x, y, daeu_SHUF(2,2,2,2));
+            _mm_storeu_ps(p + 4, _mm_shuffle_ps(t0, t1, daeu_SHUF(0,2,0,2)));
+            t0 = _mm_shuffle_ps(z, x, daeu_SHUF(2,2,3,3));
+            t1 = _mm_shuffle_ps(y, z, daeu_SHUF(3,3,3,3));
+            _mm_storeu_ps(p + 8, _mm_shuffle_ps(t0, t1, daeu_SHUF(0,2,0,2)));
+        }
+    }
+#undef daeu_SHUF
+#endif
+    for(; i < count; ++i)
+    {
+        float* p = v + i*3;
+        float t[3];
+        t[0] = p[0];
+        t[1] = p[1];
+        t[2] = p[2];
+        p[0] = t[u->perm[0]]*m[0];
+        p[1] = t[u->perm[1]]*m[1];
+        p[2] = t[u->perm[2]]*m[2];
+    }
+}
+
+//****************************************************************************
+static void daeu_units_task_run(
+    void* userdata,
+    size_t index,
+    int worker)
+{
+    const daeu_units_batch* batch = (const daeu_units_batch*) userdata;
+    const daeu_units_task* t = batch->tasks + index;
+    const unsigned* off = t->offsets;
+    size_t i;
+    unsigned c;
+    if((t->kind == daeu_UNITS_POINT || t->kind == daeu_UNITS_DIRECTION) &&
+        t->stride == 3 && off[0] == 0 && off[1] == 1 && off[2] == 2)
+    {
+        float scale = (t->kind == daeu_UNITS_POINT) ? t->units.scale : 1.0f;
+        daeu_units_points(&t->units, scale, t->data, t->count);
+    }
+    else if(t->kind == daeu_UNITS_FACTOR && t->stride == 1)
+    {
+        float* v = t->data + off[0];
+        for(i = 0; i < t->count; ++i)
+        {
+            v[i] *= t->factor;
+        }
+    }
+    else
+    {
+        float v[16];
+        for(i = 0; i < t->count; ++i)
+        {
+            float* tuple = t->data + i*t->stride;
+            for(c = 0; c < t->numoffsets; ++c)
+            {
+                v[c] = tuple[off[c]];
+            }
+            daeu_units_convert(t, v);
+            for(c = 0; c < t->numoffsets; ++c)
+            {
+                tuple[off[c]] = v[c];
+            }
+        }
+    }
+}
+
+//****************************************************************************
+static int daeu_units_cmp_task(
+    const void* a,
+    const void* b)
+{
+    const daeu_units_task* ta = (const daeu_units_task*) a;
+    const daeu_units_task* tb = (const daeu_units_task*) b;
+    if(ta->data != tb->data)
+    {
+        return (ta->data < tb->data) ? -1 : 1;
+    }
+    return (ta->seq < tb->seq) ? -1 : (ta->seq > tb->seq);
+}
+
+//****************************************************************************
+static void daeu_units_unshare(
+    dae_source_type* src)
+{
+    if(src != NULL && src->el_float_array != NULL)
+    {
+        dae_native_typeid datatype;
+        void* data;
+        size_t datalen;
+        dae_get_mutable_data(src->el_float_array, &datatype, &data, &datalen);
+    }
+}
+
+//****************************************************************************
+static daeu_units_task* daeu_units_add(
+    daeu_units_batch* batch,
+    const daeu_units* units,
+    int kind,
+    float* data,
+    size_t count,
+    size_t stride)
+{
+    // the caller fills in the offsets of the values within each tuple
+    daeu_units_task* t;
+    if(batch->size == batch->cap)
+    {
+        batch->cap = (batch->cap > 0) ? batch->cap*2 : 64;
+        batch->tasks = (daeu_units_task*) realloc(
+            batch->tasks,
+            batch->cap*sizeof(*batch->tasks));
+    }
+    t = batch->tasks + batch->size;
+    memset(t, 0, sizeof(*t));
+    t->data = data;
+    t->count = count;
+    t->stride = stride;
+    t->kind = kind;
+    t->factor = 1.0f;
+    t->units = *units;
+    t->seq = batch->size;
+    ++batch->size;
+    return t;
+}
+
+//****************************************************************************
+static void daeu_units_add_tuples(
+    daeu_units_batch* batch,
+    const daeu_units* units,
+    int kind,
+    unsigned size,
+    const daeu_source_binding* src,
+    int istangent)
+{
+    // tangents hold a (time, value) pair per value, or only the values
+    daeu_units_task* t;
+    unsigned step = 1;
+    unsigned first = 0;
+    unsigned c;
+    if(src->data == NULL || src->count == 0)
+    {
+        return;
+    }
+    if(istangent && src->stride >= size*2)
+    {
+        step = 2;
+        first = 1;
+    }
+    else if(src->stride < size)
+    {
+        return;
+    }
+    t = daeu_units_add(
+        batch,
+        units,
+        kind,
+        (float*) src->data,
+        src->count,
+        src->stride);
+    t->numoffsets = (kind == daeu_UNITS_FACTOR) ? 1 : size;
+    for(c = 0; c < t->numoffsets; ++c)
+    {
+        t->offsets[c] = first + c*step;
+    }
+}
+
+//****************************************************************************
+static void daeu_units_retarget(
+    dae_channel_type* channel,
+    int index)
+{
+    // rewrites the member selection at the end of a channel target
+    dae_obj_ptr at = daeu_find_attrib(channel, "target");
+    const char* target = *channel->at_target;
+    const char* sel = strrchr(target, '/');
+    sel = strpbrk((sel != NULL) ? sel : target, ".(");
+    if(at != NULL && sel != NULL)
+    {
+        size_t len = (size_t) (sel - target);
+        char* buf = (char*) malloc(len + 32);
+        memcpy(buf, target, len);
+        if(*sel == '.' && index < 3)
+        {
+            sprintf(buf + len, ".%c", "XYZ"[index]);
+        }
+        else if(*sel == '(' && strchr(sel + 1, '(') != NULL)
+        {
+            sprintf(buf + len, "(%d)(%d)", index%4, index/4);
+        }
+        else
+        {
+            sprintf(buf + len, "(%d)", index);
+        }
+        dae_set_string(at, buf);
+        free(buf);
+    }
+}
+
+//****************************************************************************
+static void daeu_units_add_channel(
+    daeu_units_batch* batch,
+    const daeu_idmap* ids,
+    dae_channel_type* channel,
+    float meter,
+    daeu_up_axis upaxis)
+{
+    // animation outputs are converted with the scope of their target
+    daeu_anim_binding b;
+    daeu_units u;
+    dae_obj_ptr obj;
+    dae_native_typeid datatype;
+    float* target;
+    float* base = NULL;
+    size_t datalen;
+    unsigned size;
+    int kind;
+    if(channel->at_target == NULL || *channel->at_target == NULL)
+    {
+        return;
+    }
+    if(!daeu_anim_bind_channel(ids, channel, &b))
+    {
+        return;
+    }
+    if(!daeu_anim_resolve_target(ids, *channel->at_target, 1, &obj, &target))
+    {
+        return;
+    }
+    kind = daeu_units_get_kind(obj, &size);
+    if(kind < 0 || !daeu_units_create(obj, meter, upaxis, &u))
+    {
+        return;
+    }
+    // outputs and tangents are converted in place, so they may not be shared
+    // with a clone
+    daeu_units_unshare(b.output.source);
+    daeu_units_unshare(b.intangent.source);
+    daeu_units_unshare(b.outtangent.source);
+    daeu_anim_bind_channel(ids, channel, &b);
+    dae_get_mutable_data(obj, &datatype, (void**) &base, &datalen);
+    if(target == base && b.output.stride >= size)
+    {
+        // the whole element is animated
+        daeu_units_add_tuples(batch, &u, kind, size, &b.output, 0);
+        daeu_units_add_tuples(batch, &u, kind, size, &b.intangent, 1);
+        daeu_units_add_tuples(batch, &u, kind, size, &b.outtangent, 1);
+    }
+    else if(b.output.stride == 1)
+    {
+        // a single value, which may move to another index and change sign
+        int index;
+        float factor;
+        if(daeu_units_remap(&u, kind, (int) (target - base), &index, &factor))
+        {
+            daeu_units_task* t = NULL;
+            if(index != (int) (target - base))
+            {
+                daeu_units_retarget(channel, index);
+            }
+            if(factor != 1.0f)
+            {
+                size_t n = batch->size;
+                daeu_units_add_tuples(batch, &u, kind, 1, &b.output, 0);
+                daeu_units_add_tuples(batch, &u, kind, 1, &b.intangent, 1);
+                daeu_units_add_tuples(batch, &u, kind, 1, &b.outtangent, 1);
+                for(; n < batch->size; ++n)
+                {
+                    t = batch->tasks + n;
+                    t->kind = daeu_UNITS_FACTOR;
+                    t->factor = factor;
+                }
+            }
+        }
+    }
+}
+
+//****************************************************************************
+static void daeu_units_add_input(
+    daeu_units_batch* batch,
+    const daeu_idmap* ids,
+    dae_obj_ptr input,
+    float meter,
+    daeu_up_axis upaxis)
+{
+    // sources are converted by the semantic of the inputs that use them
+    const char* semantic = daeu_get_string(input, "semantic");
+    dae_source_type* src;
+    daeu_mesh_binding mb;
+    daeu_units u;
+    daeu_units_task* t;
+    unsigned c;
+    int kind = -1;
+    if(semantic == NULL)
+    {
+        return;
+    }
+    if(!strcmp(semantic, "POSITION"))
+    {
+        kind = daeu_UNITS_POINT;
+    }
+    else if(!strcmp(semantic, "NORMAL") ||
+        !strcmp(semantic, "TANGENT") ||
+        !strcmp(semantic, "BINORMAL") ||
+        !strcmp(semantic, "TEXTANGENT") ||
+        !strcmp(semantic, "TEXBINORMAL"))
+    {
+        kind = daeu_UNITS_DIRECTION;
+    }
+    else if(!strcmp(semantic, "INV_BIND_MATRIX"))
+    {
+        kind = daeu_UNITS_MATRIX;
+    }
+    if(kind < 0)
+    {
+        return;
+    }
+    src = (dae_source_type*) daeu_idmap_find(
+        ids,
+        daeu_get_string(input, "source"));
+    if(src == NULL || dae_get_typeid(src) != dae_ID_SOURCE_TYPE)
+    {
+        return;
+    }
+    if(!daeu_mesh_bind_source(src, 0, &mb) || mb.count == 0)
+    {
+        return;
+    }
+    if(!daeu_units_create(src, meter, upaxis, &u))
+    {
+        return;
+    }
+    // the array is converted in place, so it may not be shared with a clone
+    daeu_units_unshare(src);
+    daeu_mesh_bind_source(src, 0, &mb);
+    if(kind == daeu_UNITS_MATRIX)
+    {
+        // a single float4x4 param
+        if(mb.stride >= 16)
+        {
+            t = daeu_units_add(
+                batch,
+                &u,
+                kind,
+                (float*) mb.data + mb.offset,
+                mb.count,
+                mb.stride);
+            for(c = 0; c < 16; ++c)
+            {
+                t->offsets[c] = c;
+            }
+            t->numoffsets = 16;
+        }
+    }
+    else if(mb.numparams >= 3 && mb.params[2] < mb.stride)
+    {
+        t = daeu_units_add(
+            batch,
+            &u,
+            kind,
+            (float*) mb.data + mb.offset,
+            mb.count,
+            mb.stride);
+        for(c = 0; c < 3; ++c)
+        {
+            t->offsets[c] = mb.params[c];
+        }
+        t->numoffsets = 3;
+    }
+}
+
+//****************************************************************************
+static const char* daeu_units_get_name(
+    float meter)
+{
+    static const struct { float meter; const char* name; } s_names[] =
+    {
+        { 1.0f, "meter" },
+        { 0.01f, "centimeter" },
+        { 0.001f, "millimeter" },
+        { 1000.0f, "kilometer" },
+        { 0.0254f, "inch" },
+        { 0.3048f, "foot" }
+    };
+    size_t i;
+    for(i = 0; i < sizeof(s_names)/sizeof(*s_names); ++i)
+    {
+        if(s_names[i].meter == meter)
+        {
+            return s_names[i].name;
+        }
+    }
+    return "custom";
+}
+
+//****************************************************************************
+static void daeu_units_set_asset(
+    dae_asset_type* asset,
+    float meter,
+    daeu_up_axis upaxis,
+    int isroot)
+{
+    // nested assets are only updated where they override the unit or axis
+    static const char* s_axes[] = { "X_UP", "Y_UP", "Z_UP" };
+    if(asset->el_unit == NULL && isroot)
+    {
+        dae_add_element(asset, "unit");
+    }
+    if(asset->el_unit != NULL)
+    {
+        dae_asset_type_unit* unit = asset->el_unit;
+        const char* name = daeu_units_get_name(meter);
+        dae_obj_ptr at = daeu_find_attrib(unit, "name");
+        if(unit->at_meter != NULL)
+        {
+            *unit->at_meter = meter;
+        }
+        else
+        {
+            char buf[32];
+            sprintf(buf, "%.9g", meter);
+            dae_add_attrib(unit, "meter", buf);
+        }
+        if(at != NULL)
+        {
+            dae_set_string(at, name);
+        }
+        else
+        {
+            dae_add_attrib(unit, "name", name);
+        }
+    }
+    if(asset->el_up_axis == NULL && isroot)
+    {
+        dae_add_element(asset, "up_axis");
+    }
+    if(asset->el_up_axis != NULL)
+    {
+        dae_set_string(asset->el_up_axis, s_axes[upaxis]);
+    }
+}
+
+//****************************************************************************
+int daeu_normalize_units(
+    dae_COLLADA* doc,
+    float meter,
+    daeu_up_axis upaxis,
+    int numthreads)
+{
+    const size_t chunk = 16384;
+    daeu_units_batch batch;
+    daeu_units_task* tasks;
+    daeu_idmap ids;
+    dae_obj_ptr itr;
+    size_t numtasks;
+    size_t i;
+    size_t j;
+    if(!(meter > 0.0f) || upaxis < daeu_X_UP || upaxis > daeu_Z_UP)
+    {
+        return -1;
+    }
+    memset(&batch, 0, sizeof(batch));
+    daeu_idmap_create(doc, &ids);
+    // gather every array to convert, with the scope of its element, before
+    // anything is modified
+    itr = doc;
+    while(itr != NULL)
+    {
+        dae_obj_typeid type = dae_get_typeid(itr);
+        unsigned size;
+        int kind;
+        daeu_units u;
+        if(type == dae_ID_INPUT_LOCAL_TYPE ||
+            type == dae_ID_INPUT_LOCAL_OFFSET_TYPE)
+        {
+            daeu_units_add_input(&batch, &ids, itr, meter, upaxis);
+        }
+        else if(type == dae_ID_CHANNEL_TYPE)
+        {
+            daeu_units_add_channel(
+                &batch,
+                &ids,
+                (dae_channel_type*) itr,
+                meter,
+                upaxis);
+        }
+        else if((kind = daeu_units_get_kind(itr, &size)) >= 0)
+        {
+            if(daeu_units_create(itr, meter, upaxis, &u))
+            {
+                dae_native_typeid datatype;
+                void* data = NULL;
+                size_t datalen;
+                daeu_units_task* t;
+                unsigned c;
+                dae_get_mutable_data(itr, &datatype, &data, &datalen);
+                t = daeu_units_add(&batch, &u, kind, (float*) data, 1, size);
+                for(c = 0; c < size; ++c)
+                {
+                    t->offsets[c] = c;
+                }
+                t->numoffsets = size;
+            }
+        }
+        itr = daeu_walk_next(doc, itr);
+    }
+    daeu_idmap_destroy(&ids);
+    // sources shared by several inputs or channels are converted once, and
+    // large arrays are split so they are spread across the workers
+    if(batch.size > 0)
+    {
+        qsort(
+            batch.tasks,
+            batch.size,
+            sizeof(*batch.tasks),
+            daeu_units_cmp_task);
+    }
+    numtasks = 0;
+    for(i = 0; i < batch.size; ++i)
+    {
+        if(i == 0 || batch.tasks[i].data != batch.tasks[i - 1].data)
+        {
+            numtasks += (batch.tasks[i].count + chunk - 1)/chunk;
+        }
+    }
+    tasks = (daeu_units_task*) malloc((numtasks + 1)*sizeof(*tasks));
+    numtasks = 0;
+    for(i = 0; i < batch.size; ++i)
+    {
+        const daeu_units_task* t = batch.tasks + i;
+        if(i > 0 && t->data == batch.tasks[i - 1].data)
+        {
+            continue;
+        }
+        for(j = 0; j < t->count; j += chunk)
+        {
+            daeu_units_task* part = tasks + numtasks;
+            *part = *t;
+            part->data += j*t->stride;
+            part->count = (t->count - j < chunk) ? t->count - j : chunk;
+            ++numtasks;
+        }
+    }
+    free(batch.tasks);
+    batch.tasks = tasks;
+    batch.size = numtasks;
+    if(numtasks > 0)
+    {
+        daeu_pool_run(
+            numtasks,
+            NULL,
+            daeu_pool_count_workers(numtasks, numthreads),
+            daeu_units_task_run,
+            &batch);
+    }
+    free(batch.tasks);
+    // the document now uses the new unit and axis throughout
+    if(doc->el_asset == NULL)
+    {
+        dae_add_element(doc, "asset");
+    }
+    itr = doc;
+    while(itr != NULL)
+    {
+        if(dae_get_typeid(itr) == dae_ID_ASSET_TYPE)
+        {
+            daeu_units_set_asset(
+                (dae_asset_type*) itr,
+                meter,
+                upaxis,
+                itr == doc->el_asset);
+        }
+        itr = daeu_walk_next(doc, itr);
+    }
+    return 0;
+}
+
+//****************************************************************************
+void daeu_scene_destroy(
+    daeu_scene* scene)
+{
+    free(scene->nodes);
+    free(scene->parents);
+    daeu_aligned_free(scene->local);
+    daeu_aligned_free(scene->world);
+    memset(scene, 0, sizeof(*scene));
+}
+
+//****************************************************************************
+void daeu_scene_flatten(
+    dae_visual_scene_type* scene,
+    daeu_scene* scene_out)
+{
+    dae_node_type** nodes;
+    int* parents;
+    size_t cap = scene->el_node.size + 64;
+    size_t n = scene->el_node.size;
+    size_t i;
+    nodes = (dae_node_type**) malloc(cap*sizeof(*nodes));
+    parents = (int*) malloc(cap*sizeof(*parents));
+    memcpy(nodes, scene->el_node.values, n*sizeof(*nodes));
+    for(i = 0; i < n; ++i)
+    {
+        parents[i] = -1;
+    }
+    // the output array doubles as the queue of the breadth first walk
+    for(i = 0; i < n; ++i)
+    {
+        dae_node_type* node = nodes[i];
+        size_t numchildren = node->el_node.size;
+        size_t j;
+        if(n + numchildren > cap)
+        {
+            while(n + numchildren > cap)
+            {
+                cap *= 2;
+            }
+            nodes = (dae_node_type**) realloc(nodes, cap*sizeof(*nodes));
+            parents = (int*) realloc(parents, cap*sizeof(*parents));
+        }
+        for(j = 0; j < numchildren; ++j)
+        {
+            nodes[n] = node->el_node.values[j];
+            parents[n] = (int) i;
+            ++n;
+        }
+    }
+    scene_out->nodes = nodes;
+    scene_out->parents = parents;
+    scene_out->numnodes = n;
+    scene_out->local = (float*) daeu_aligned_alloc((n+1)*16*sizeof(float));
+    scene_out->world = (float*) daeu_aligned_alloc((n+1)*16*sizeof(float));
+    daeu_scene_update(scene_out);
+}
+
+//****************************************************************************
+void daeu_scene_update(
+    daeu_scene* scene)
+{
+    const int* parents = scene->parents;
+    float* local = scene->local;
+    float* world = scene->world;
+    size_t n = scene->numnodes;
+    size_t i;
+    for(i = 0; i < n; ++i)
+    {
+        daeu_calc_transform_matrix(scene->nodes[i], local + i*16);
+    }
+    // parents always precede their children, so a single forward pass
+    // resolves the whole hierarchy
+    daeu_matrix_compose_batch(parents, local, world, n);
+}
+
+//****************************************************************************
+int daeu_search_sid(
+    dae_obj_ptr searchroot,
+    const char* ref,
+    dae_obj_ptr* obj_out,
+    int* dataindex_out)
+{
+    const char* sep = "/.(";
+    size_t result = 0;
+    int isrootless = 0;
+    int ismatch = 0;
+    if(dataindex_out != NULL)
+    {
+        *dataindex_out = -1;
+    }
+    if(*ref == '.')
+    {
+        // relative to the current element
+        ismatch = 1;
+        ++ref;
+    }
+    else if(*ref == '/')
+    {
+        // a child element
+        ++ref;
+    }
+    else
+    {
+        // the root of the path has not been found yet
+        assert(strpbrk(ref, sep) != ref);
+        isrootless = 1;
+    }
+    if(!ismatch)
+    {
+        // check to see if this is the current item in the path
+        const char* atnames[] = { "sid", "id" };
+        size_t i;
+        for(i = 0; i < sizeof(atnames)/sizeof(*atnames); ++i)
+        {
+            dae_obj_ptr at = daeu_find_attrib(searchroot, atnames[i]);
+            if(at != NULL)
+            {
+                dae_native_typeid attype;
+                void* ataddr;
+                size_t atsize;
+                if(dae_get_data(at, &attype, &ataddr, &atsize) > 0)
+                {
+                    // compare the attribute value against the search key
+                    const char* atval = *((char**) ataddr);
+                    if(attype == dae_NATIVE_STRING && atval != NULL)
+                    {
+                        const char* end = strpbrk(ref, sep);
+                        size_t len;
+                        len = (end!=NULL) ? (size_t)(end-ref) : strlen(ref);
+                        ismatch = !strncmp(atval,ref,len) && atval[len]=='\0';
+                        if(ismatch)
+                        {
+                            *obj_out = searchroot;
+                            isrootless = 0;
+                            ref += len;
+                            ++result;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    if(ismatch || isrootless)
+    {
+        // if this item was in the path, or the path root has not been found
+        if(*ref == '.')
+        {
+            // referencing a component of the current element
+            dae_native_typeid datatype;
+            float* data;
+            size_t datalen;
+            ++ref;
+            if(dae_get_data(searchroot,&datatype,(void**)&data,&datalen) != 0)
+            {
+                if(datatype == dae_NATIVE_FLOAT && dataindex_out != NULL)
+                {
+                    int i = -1;
+                    switch(*ref)
+                    {
+                    case 'A':
+                        // ANGLE or A (ALPHA)
+                        if(!strcmp(ref, "ANGLE") || ref[1] == '\0'){ i = 3; }
+                        break;
+                    case 'B':
+                        // B (BLUE)
+                        if(ref[1] == '\0') { i = 2; }
+                        break;
+                    case 'G':
+                        // G (GREEN)
+                        if(ref[1] == '\0') { i = 1; }
+                        break;
+                    case 'P':
+                        if(ref[1] == '\0') { i = 2; }
+                        break;
+                    case 'Q':
+                        if(ref[1] == '\0') { i = 3; }
+                        break;
+                    case 'R':
+                        if(ref[1] == '\0') { i = 0; }
+                        break;
+                    case 'S':
+                        if(ref[1] == '\0') { i = 0; }
+                        break;
+                    case 'T':
+                        // NOTE: not handling 'TIME'
+                        if(ref[1] == '\0') { i = 1; }
+                        break;
+                    case 'U':
+                        if(ref[1] == '\0') { i = 0; }
+                        break;
+                    case 'V':
+                        if(ref[1] == '\0') { i = 1; }
+                        break;
+                    case 'W':
+                        if(ref[1] == '\0') { i = 3; }
+                        break;
+                    case 'X':
+                        if(ref[1] == '\0') { i = 0; }
+                        break;
+                    case 'Y':
+                        if(ref[1] == '\0') { i = 1; }
+                        break;
+                    case 'Z':
+                        if(ref[1] == '\0') { i = 2; }
+                        break;
+                    }
+                    if(i >= 0)
+                    {
+                        if(i < (int) datalen)
+                        {
+                            *dataindex_out = i;
+                            ++result;
+                        }
+                    }
+                }
+            }
+        }
+        else if(*ref == '(')
+        {
+            // referencing a component of the current element by index
+            dae_native_typeid datatype;
+            float* data;
+            size_t datalen;
+            ++ref;
+            if(dae_get_data(searchroot,&datatype,(void**)&data,&datalen) != 0)
+            {
+                if(datatype == dae_NATIVE_FLOAT && dataindex_out != NULL)
+                {
+                    int i = 0;
+                    int j = 0;
+                    const char* next = strchr(ref, ')');
+                    if(sscanf(ref,"%d",&i) == 1)
+                    {
+                        if(next != NULL && next[1] == '(')
+                        {
+                            // (column)(row), only used to address the
+                            // elements of 4x4 matrices
+                            if(sscanf(next + 2, "%d", &j) == 1 && i < 4)
+                            {
+                                i = j*4 + i;
+                            }
+                            else
+                            {
+                                i = -1;
+                            }
+                        }
+                        if(i >= 0)
+                        {
+                            if(i < (int) datalen)
+                            {
+                                *dataindex_out = i;
+                                ++result;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        else if(*ref == '/' || isrootless)
+        {
+            // traverse children
+            dae_obj_ptr elem = dae_get_first_element(searchroot);
+            while(elem != NULL)
+            {
+                result = daeu_search_sid(elem, ref, obj_out, dataindex_out);
+                if(result != 0)
+                {
+                    break;
+                }
+                elem = dae_get_next(elem);
+            }
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+dae_obj_ptr daeu_search_uri(
+    dae_obj_ptr searchroot,
+    const char* uri)
+{
+    const char* key = uri + 1;
+    dae_obj_ptr result = NULL;
+    dae_obj_ptr itr = searchroot;
+    assert(*uri == '#');
+    do
+    {
+        dae_obj_ptr at;
+        dae_obj_ptr next;
+        // attempt to find the id attribute for this object
+        at = daeu_find_attrib(itr, "id");
+        if(at != NULL)
+        {
+            // attempt the get the attribute value
+            dae_native_typeid attype;
+            void* ataddr;
+            size_t atsize;
+            if(dae_get_data(at, &attype, &ataddr, &atsize))
+            {
+                const char* atval = *((char**) ataddr);
+                if(attype == dae_NATIVE_STRING && atval != NULL)
+                {
+                    // compare the attribute value against the search key
+                    if(!strcmp(atval, key))
+                    {
+                        // found match
+                        result = itr;
+                        break;
+                    }
+                }
+            }
+        }
+        // attempt to traverse children
+        next = dae_get_first_element(itr);
+        while(next == NULL)
+        {
+            // if no children exist, attempt to move to next sibling
+            next = dae_get_next(itr);
+            if(next == NULL)
+            {
+                // if a sibling did not exist, attempt to move up to the
+                // parent's sibling.
+                next = dae_get_parent(itr);
+                if(next != searchroot)
+                {
+                    // only move to the parent's sibling if not at the root
+                    itr = next;
+                    next = dae_get_next(next);
+                }
+            }
+        }
+        itr = next;
+    }
+    while(itr != searchroot);
+    return result;
+}
+
+//****************************************************************************
+static int daeu_skin_find_node(
+    const daeu_scene* scene,
+    const char* name)
+{
+    // Name_array joints hold sids, but many exporters write ids instead
+    size_t i;
+    for(i = 0; i < scene->numnodes; ++i)
+    {
+        dae_node_type* node = scene->nodes[i];
+        if(node->at_sid != NULL && *node->at_sid != NULL)
+        {
+            if(!strcmp(*node->at_sid, name))
+            {
+                return (int) i;
+            }
+        }
+    }
+    for(i = 0; i < scene->numnodes; ++i)
+    {
+        dae_node_type* node = scene->nodes[i];
+        if(node->at_id != NULL && *node->at_id != NULL)
+        {
+            if(!strcmp(*node->at_id, name))
+            {
+                return (int) i;
+            }
+        }
+    }
+    return -1;
+}
+
+//****************************************************************************
+int daeu_skin_compile(
+    dae_skin_type* skin,
+    const daeu_scene* scene,
+    unsigned influences,
+    float minweight,
+    daeu_skin* skin_out)
+{
+    dae_skin_type_joints* joints = skin->el_joints;
+    dae_skin_type_vertex_weights* vw = skin->el_vertex_weights;
+    daeu_source_binding jointsrc;
+    daeu_source_binding invbindsrc;
+    daeu_source_binding weightsrc;
+    const unsigned* vcount;
+    const int* v;
+    size_t vsize;
+    size_t numjoints;
+    size_t numvertices;
+    size_t pos = 0;
+    int jointoffset = -1;
+    int weightoffset = -1;
+    size_t tuplesize = 0;
+    size_t i;
+    size_t j;
+
+    memset(skin_out, 0, sizeof(*skin_out));
+    daeu_matrix_identity(skin_out->bindshape);
+    if(skin->el_bind_shape_matrix != NULL)
+    {
+        memcpy(
+            skin_out->bindshape,
+            *skin->el_bind_shape_matrix,
+            sizeof(skin_out->bindshape));
+    }
+    if(joints == NULL || vw == NULL || influences < 1 || influences > 8)
+    {
+        return -1;
+    }
+    if(vw->el_vcount == NULL || vw->el_v == NULL)
+    {
+        return -1;
+    }
+    // bind the joint names and inverse bind matrices
+    memset(&jointsrc, 0, sizeof(jointsrc));
+    memset(&invbindsrc, 0, sizeof(invbindsrc));
+    memset(&weightsrc, 0, sizeof(weightsrc));
+    for(i = 0; i < joints->el_input.size; ++i)
+    {
+        dae_input_local_type* input = joints->el_input.values[i];
+        dae_source_type* src;
+        if(input->at_semantic == NULL || input->at_source == NULL)
+        {
+            continue;
+        }
+        src = daeu_find_source(
+            skin->el_source.values,
+            skin->el_source.size,
+            *input->at_source);
+        if(!strcmp(*input->at_semantic, "JOINT"))
+        {
+            daeu_bind_source(src, &jointsrc);
+        }
+        else if(!strcmp(*input->at_semantic, "INV_BIND_MATRIX"))
+        {
+            daeu_bind_source(src, &invbindsrc);
+        }
+    }
+    // the vertex weights reference joints by index and weights by source
+    for(i = 0; i < vw->el_input.size; ++i)
+    {
+        dae_input_local_offset_type* input = vw->el_input.values[i];
+        int offset;
+        if(input->at_semantic == NULL || input->at_offset == NULL)
+        {
+            continue;
+        }
+        offset = (int) *input->at_offset;
+        if((size_t) offset >= tuplesize)
+        {
+            tuplesize = (size_t) offset + 1;
+        }
+        if(!strcmp(*input->at_semantic, "JOINT"))
+        {
+            jointoffset = offset;
+        }
+        else if(!strcmp(*input->at_semantic, "WEIGHT"))
+        {
+            dae_source_type* src = NULL;
+            if(input->at_source != NULL)
+            {
+                src = daeu_find_source(
+                    skin->el_source.values,
+                    skin->el_source.size,
+                    *input->at_source);
+            }
+            weightoffset = offset;
+            daeu_bind_source(src, &weightsrc);
+        }
+    }
+    numjoints = jointsrc.count;
+    if(jointsrc.names == NULL || numjoints > 65536)
+    {
+        return -1;
+    }
+    if(jointoffset < 0 || weightoffset < 0 || weightsrc.data == NULL)
+    {
+        return -1;
+    }
+    vcount = vw->el_vcount->data.values;
+    numvertices = vw->el_vcount->data.size;
+    if(vw->at_count != NULL && *vw->at_count < numvertices)
+    {
+        numvertices = *vw->at_count;
+    }
+    v = vw->el_v->data.values;
+    vsize = vw->el_v->data.size;
+
+    skin_out->jointnames = (const char**) malloc(
+        (numjoints + 1)*sizeof(*skin_out->jointnames));
+    skin_out->jointnodes = (int*) malloc(
+        (numjoints + 1)*sizeof(*skin_out->jointnodes));
+    skin_out->invbind = (float*) daeu_aligned_alloc(
+        (numjoints + 1)*16*sizeof(float));
+    skin_out->indices = (unsigned short*) daeu_aligned_alloc(
+        (numvertices*influences + 1)*sizeof(unsigned short));
+    skin_out->weights = (float*) daeu_aligned_alloc(
+        (numvertices*influences + 1)*sizeof(float));
+    skin_out->numjoints = numjoints;
+    skin_out->numvertices = numvertices;
+    skin_out->influences = influences;
+    for(j = 0; j < numjoints; ++j)
+    {
+        float* invbind = skin_out->invbind + j*16;
+        skin_out->jointnames[j] = jointsrc.names[j*jointsrc.stride];
+        skin_out->jointnodes[j] = -1;
+        if(scene != NULL && skin_out->jointnames[j] != NULL)
+        {
+            skin_out->jointnodes[j] = daeu_skin_find_node(
+                scene,
+                skin_out->jointnames[j]);
+        }
+        if(invbindsrc.data != NULL &&
+            j < invbindsrc.count &&
+            invbindsrc.stride >= 16)
+        {
+            memcpy(
+                invbind,
+                invbindsrc.data + j*invbindsrc.stride,
+                16*sizeof(float));
+        }
+        else
+        {
+            daeu_matrix_identity(invbind);
+        }
+    }
+    for(i = 0; i < numvertices; ++i)
+    {
+        unsigned short* indices = skin_out->indices + i*influences;
+        float* weights = skin_out->weights + i*influences;
+        unsigned n = 0;
+        unsigned k;
+        float sum = 0.0f;
+        // keep the largest influences, sorted by descending weight
+        for(j = 0; j < vcount[i] && pos + tuplesize <= vsize; ++j)
+        {
+            int joint = v[pos + jointoffset];
+            int windex = v[pos + weightoffset];
+            float w;
+            pos += tuplesize;
+            if(joint < 0 || (size_t) joint >= numjoints)
+            {
+                continue;
+            }
+            if(windex < 0 || (size_t) windex >= weightsrc.count)
+            {
+                continue;
+            }
+            w = weightsrc.data[windex*weightsrc.stride];
+            if(!(w > 0.0f) || w < minweight)
+            {
+                continue;
+            }
+            if(n == influences && w <= weights[n - 1])
+            {
+                continue;
+            }
+            k = (n < influences) ? n++ : n - 1;
+            while(k > 0 && weights[k - 1] < w)
+            {
+                weights[k] = weights[k - 1];
+                indices[k] = indices[k - 1];
+                --k;
+            }
+            weights[k] = w;
+            indices[k] = (unsigned short) joint;
+        }
+        for(k = 0; k < n; ++k)
+        {
+            sum += weights[k];
+        }
+        if(sum > 0.0f)
+        {
+            sum = 1.0f/sum;
+            for(k = 0; k < n; ++k)
+            {
+                weights[k] *= sum;
+            }
+        }
+        for(k = n; k < influences; ++k)
+        {
+            weights[k] = 0.0f;
+            indices[k] = 0;
+        }
+    }
+    return 0;
+}
+
+//****************************************************************************
+void daeu_skin_destroy(
+    daeu_skin* skin)
+{
+    free((void*) skin->jointnames);
+    free(skin->jointnodes);
+    daeu_aligned_free(skin->invbind);
+    daeu_aligned_free(skin->indices);
+    daeu_aligned_free(skin->weights);
+    memset(skin, 0, sizeof(*skin));
+}
+
+//****************************************************************************
+#ifndef daeu_SSE
+static void daeu_skin_deform_scalar(
+    const daeu_skin_batch* b,
+    size_t begin,
+    size_t end)
+{
+    const daeu_skin* skin = b->skin;
+    const daeu_mesh* mesh = b->mesh;
+    size_t vertexsize = mesh->vertexsize;
+    size_t numattribs = mesh->numattribs;
+    unsigned influences = skin->influences;
+    unsigned posoffset = mesh->attribs[b->position].offset;
+    size_t v;
+    for(v = begin; v < end; ++v)
+    {
+        const float* src = mesh->vertices + v*vertexsize;
+        float* dst = b->vertices + v*vertexsize;
+        size_t sv = mesh->sources[v*numattribs + b->position];
+        const unsigned short* indices;
+        const float* weights;
+        float m[16];
+        float out[3];
+        unsigned i;
+        unsigned k;
+        if(dst != src)
+        {
+            memcpy(dst, src, vertexsize*sizeof(float));
+        }
+        if(sv >= skin->numvertices || !(skin->weights[sv*influences] > 0.0f))
+        {
+            continue;
+        }
+        indices = skin->indices + sv*influences;
+        weights = skin->weights + sv*influences;
+        memset(m, 0, sizeof(m));
+        for(k = 0; k < influences && weights[k] > 0.0f; ++k)
+        {
+            const float* col = b->cols + indices[k]*16;
+            for(i = 0; i < 16; ++i)
+            {
+                m[i] += col[i]*weights[k];
+            }
+        }
+        // src and dst may be the same vertex, so read before writing
+        for(i = 0; i < 3; ++i)
+        {
+            const float* p = src + posoffset;
+            out[i] = m[i]*p[0] + m[4+i]*p[1] + m[8+i]*p[2] + m[12+i];
+        }
+        memcpy(dst + posoffset, out, 3*sizeof(float));
+        if(b->normal >= 0)
+        {
+            const float* n = src + b->normal;
+            float len;
+            for(i = 0; i < 3; ++i)
+            {
+                out[i] = m[i]*n[0] + m[4+i]*n[1] + m[8+i]*n[2];
+            }
+            len = sqrtf(out[0]*out[0] + out[1]*out[1] + out[2]*out[2]);
+            if(len > 0.0f)
+            {
+                out[0] /= len; out[1] /= len; out[2] /= len;
+            }
+            memcpy(dst + b->normal, out, 3*sizeof(float));
+        }
+    }
+}
+#endif
+
+//****************************************************************************
+#ifdef daeu_SSE
+static void daeu_skin_store_sse(
+    const float* src,
+    float* dst,
+    int normal,
+    __m128 c0,
+    __m128 c1,
+    __m128 c2,
+    __m128 c3)
 {
-    daeu_matrix_identity(mtx_out);
-    mtx_out[ 0] = scale->data[0];
-    mtx_out[ 5] = scale->data[1];
-    mtx_out[10] = scale->data[2];
+    // applies a blended matrix, held as its first three rows transposed
+    // into columns, to a position and optionally a normal
+    __m128 p = _mm_add_ps(
+        _mm_add_ps(
+            _mm_mul_ps(c0, _mm_set1_ps(src[0])),
+            _mm_mul_ps(c1, _mm_set1_ps(src[1]))),
+        _mm_add_ps(
+            _mm_mul_ps(c2, _mm_set1_ps(src[2])),
+            c3));
+    _mm_storel_pi((__m64*) dst, p);
+    _mm_store_ss(dst + 2, _mm_movehl_ps(p, p));
+    if(normal >= 0)
+    {
+        const float* n = src + normal;
+        __m128 d;
+        p = _mm_add_ps(
+            _mm_add_ps(
+                _mm_mul_ps(c0, _mm_set1_ps(n[0])),
+                _mm_mul_ps(c1, _mm_set1_ps(n[1]))),
+            _mm_mul_ps(c2, _mm_set1_ps(n[2])));
+        // the fourth lane of every column is zero, so it adds nothing
+        d = _mm_mul_ps(p, p);
+        d = _mm_add_ps(d, _mm_shuffle_ps(d, d, 0x4E));
+        d = _mm_add_ps(d, _mm_shuffle_ps(d, d, 0xB1));
+        if(_mm_cvtss_f32(d) > 0.0f)
+        {
+            p = _mm_div_ps(p, _mm_sqrt_ps(d));
+        }
+        dst += normal;
+        _mm_storel_pi((__m64*) dst, p);
+        _mm_store_ss(dst + 2, _mm_movehl_ps(p, p));
+    }
 }
+#endif
 
 //****************************************************************************
-void daeu_translate_to_matrix(
-    const dae_translate_type* translate,
-    float* mtx_out)
+#ifdef daeu_SSE
+static void daeu_skin_deform_sse(
+    const daeu_skin_batch* b,
+    size_t begin,
+    size_t end)
 {
-    daeu_matrix_identity(mtx_out);
-    mtx_out[ 3] = translate->data[0];
-    mtx_out[ 7] = translate->data[1];
-    mtx_out[11] = translate->data[2];
+    const daeu_skin* skin = b->skin;
+    const daeu_mesh* mesh = b->mesh;
+    size_t vertexsize = mesh->vertexsize;
+    size_t numattribs = mesh->numattribs;
+    unsigned influences = skin->influences;
+    unsigned posoffset = mesh->attribs[b->position].offset;
+    size_t v;
+    for(v = begin; v < end; ++v)
+    {
+        const float* src = mesh->vertices + v*vertexsize;
+        float* dst = b->vertices + v*vertexsize;
+        size_t sv = mesh->sources[v*numattribs + b->position];
+        const unsigned short* indices;
+        const float* weights;
+        __m128 c0, c1, c2, c3;
+        unsigned k;
+        if(dst != src)
+        {
+            memcpy(dst, src, vertexsize*sizeof(float));
+        }
+        if(sv >= skin->numvertices || !(skin->weights[sv*influences] > 0.0f))
+        {
+            continue;
+        }
+        indices = skin->indices + sv*influences;
+        weights = skin->weights + sv*influences;
+        c0 = c1 = c2 = c3 = _mm_setzero_ps();
+        for(k = 0; k < influences && weights[k] > 0.0f; ++k)
+        {
+            const float* col = b->cols + indices[k]*16;
+            __m128 w = _mm_set1_ps(weights[k]);
+            c0 = _mm_add_ps(c0, _mm_mul_ps(w, _mm_load_ps(col + 0)));
+            c1 = _mm_add_ps(c1, _mm_mul_ps(w, _mm_load_ps(col + 4)));
+            c2 = _mm_add_ps(c2, _mm_mul_ps(w, _mm_load_ps(col + 8)));
+            c3 = _mm_add_ps(c3, _mm_mul_ps(w, _mm_load_ps(col + 12)));
+        }
+        daeu_skin_store_sse(
+            src + posoffset,
+            dst + posoffset,
+            (b->normal >= 0) ? b->normal - (int) posoffset : -1,
+            c0,
+            c1,
+            c2,
+            c3);
+    }
 }
+#endif
 
 //****************************************************************************
-void daeu_calc_transform_matrix(
-    dae_obj_ptr obj,
-    float* mtx_out)
+#ifdef daeu_AVX
+static daeu_AVX_FN void daeu_skin_deform_avx(
+    const daeu_skin_batch* b,
+    size_t begin,
+    size_t end)
 {
-    float mtxa[16];
-    float mtxb[16];
-    dae_obj_ptr el;
-
-    daeu_matrix_identity(mtx_out);
-    el = dae_get_first_element(obj);
-    while(el != NULL)
+    // as the SSE kernel, but each influence is accumulated with two 256 bit
+    // operations that each cover two columns
+    const daeu_skin* skin = b->skin;
+    const daeu_mesh* mesh = b->mesh;
+    size_t vertexsize = mesh->vertexsize;
+    size_t numattribs = mesh->numattribs;
+    unsigned influences = skin->influences;
+    unsigned posoffset = mesh->attribs[b->position].offset;
+    size_t v;
+    for(v = begin; v < end; ++v)
     {
-        int istransform = 1;
-        dae_obj_typeid eltype = dae_get_typeid(el);
-        memcpy(mtxa, mtx_out, sizeof(mtxa));
-        daeu_matrix_identity(mtxb);
-        switch(eltype)
+        const float* src = mesh->vertices + v*vertexsize;
+        float* dst = b->vertices + v*vertexsize;
+        size_t sv = mesh->sources[v*numattribs + b->position];
+        const unsigned short* indices;
+        const float* weights;
+        __m256 c01, c23;
+        __m128 c0, c1, c2, c3;
+        unsigned k;
+        if(dst != src)
         {
-        case dae_ID_LOOKAT_TYPE:
-            daeu_lookat_to_matrix((dae_lookat_type*) el, mtxb);
-            break;
-        case dae_ID_MATRIX_TYPE:
-            memcpy(mtxb, ((dae_matrix_type*) el)->data, sizeof(mtxb));
-            break;
-        case dae_ID_ROTATE_TYPE:
-            daeu_rotate_to_matrix((dae_rotate_type*) el, mtxb);
-            break;
-        case dae_ID_SCALE_TYPE:
-            daeu_scale_to_matrix((dae_scale_type*) el, mtxb);
-            break;
-        case dae_ID_SKEW_TYPE:
-            // TODO support SKEW
-            assert(0);
-            break;
-        case dae_ID_TRANSLATE_TYPE:
-            daeu_translate_to_matrix((dae_translate_type*) el, mtxb);
-            break;
-        default:
-            istransform = 0;
-            break;
+            memcpy(dst, src, vertexsize*sizeof(float));
         }
-        if(istransform)
+        if(sv >= skin->numvertices || !(skin->weights[sv*influences] > 0.0f))
         {
-            daeu_matrix_multiply(mtxa, mtxb, mtx_out);
+            continue;
         }
-        el = dae_get_next(el);
+        indices = skin->indices + sv*influences;
+        weights = skin->weights + sv*influences;
+        c01 = c23 = _mm256_setzero_ps();
+        for(k = 0; k < influences && weights[k] > 0.0f; ++k)
+        {
+            const float* col = b->cols + indices[k]*16;
+            __m256 w = _mm256_broadcast_ss(weights + k);
+            c01 = _mm256_add_ps(c01, _mm256_mul_ps(w, _mm256_load_ps(col)));
+            c23 = _mm256_add_ps(c23, _mm256_mul_ps(w, _mm256_load_ps(col+8)));
+        }
+        c0 = _mm256_castps256_ps128(c01);
+        c1 = _mm256_extractf128_ps(c01, 1);
+        c2 = _mm256_castps256_ps128(c23);
+        c3 = _mm256_extractf128_ps(c23, 1);
+        // avoid the penalty of mixing 256 bit and legacy SSE instructions
+        _mm256_zeroupper();
+        daeu_skin_store_sse(
+            src + posoffset,
+            dst + posoffset,
+            (b->normal >= 0) ? b->normal - (int) posoffset : -1,
+            c0,
+            c1,
+            c2,
+            c3);
     }
 }
+#endif
 
 //****************************************************************************
-dae_obj_ptr daeu_find_attrib(
-    dae_obj_ptr obj,
-    const char* name)
+static void daeu_skin_deform_task(
+    void* userdata,
+    size_t index,
+    int worker)
 {
-    dae_obj_ptr at = NULL;
-    dae_obj_ptr itr = dae_get_first_attrib(obj);
-    while(itr != NULL)
+    const daeu_skin_batch* b = (const daeu_skin_batch*) userdata;
+    size_t begin = index*b->chunk;
+    size_t end = begin + b->chunk;
+    end = (end < b->mesh->numvertices) ? end : b->mesh->numvertices;
+#ifdef daeu_AVX
+    if(b->avx)
     {
-        const char* itname = dae_get_name(itr);
-        if(!strcmp(itname, name))
-        {
-            at = itr;
-            break;
-        }
-        itr = dae_get_next(itr);
+        daeu_skin_deform_avx(b, begin, end);
+        return;
     }
-    return at;
+#endif
+#ifdef daeu_SSE
+    daeu_skin_deform_sse(b, begin, end);
+#else
+    daeu_skin_deform_scalar(b, begin, end);
+#endif
 }
 
 //****************************************************************************
-int daeu_search_sid(
-    dae_obj_ptr searchroot,
-    const char* ref,
-    dae_obj_ptr* obj_out,
-    int* dataindex_out)
+int daeu_skin_deform(
+    const daeu_skin* skin,
+    const float* palette,
+    const daeu_mesh* mesh,
+    int numthreads,
+    float* vertices_out)
 {
-    const char* sep = "/.(";
-    size_t result = 0;
-    int isrootless = 0;
-    int ismatch = 0;
-    if(dataindex_out != NULL)
+    daeu_skin_batch batch;
+    size_t numchunks;
+    size_t i;
+    int j;
+    memset(&batch, 0, sizeof(batch));
+    batch.position = ~0u;
+    batch.normal = -1;
+    for(i = 0; i < mesh->numattribs; ++i)
     {
-        *dataindex_out = -1;
+        const daeu_mesh_attrib* at = mesh->attribs + i;
+        if(at->size >= 3 && !strcmp(at->semantic, "POSITION"))
+        {
+            batch.position = (unsigned) i;
+        }
+        else if(at->size >= 3 && !strcmp(at->semantic, "NORMAL"))
+        {
+            batch.normal = (int) at->offset;
+        }
     }
-    if(*ref == '.')
+    if(batch.position == ~0u || mesh->sources == NULL)
     {
-        // relative to the current element
-        ismatch = 1;
-        ++ref;
+        return -1;
     }
-    else if(*ref == '/')
+    // transpose the first three rows of each matrix into four columns
+    batch.cols = (float*) daeu_aligned_alloc(
+        (skin->numjoints + 1)*16*sizeof(float));
+    for(i = 0; i < skin->numjoints; ++i)
     {
-        // a child element
-        ++ref;
+        const float* m = palette + i*16;
+        float* col = batch.cols + i*16;
+        for(j = 0; j < 4; ++j)
+        {
+            col[j*4 + 0] = m[0*4 + j];
+            col[j*4 + 1] = m[1*4 + j];
+            col[j*4 + 2] = m[2*4 + j];
+            col[j*4 + 3] = 0.0f;
+        }
     }
-    else
+    batch.skin = skin;
+    batch.mesh = mesh;
+    batch.vertices = vertices_out;
+    batch.chunk = 4096;
+#ifdef daeu_AVX
+    batch.avx = daeu_matrix_has_avx();
+#endif
+    numchunks = (mesh->numvertices + batch.chunk - 1)/batch.chunk;
+    if(numchunks > 0)
     {
-        // the root of the path has not been found yet
-        assert(strpbrk(ref, sep) != ref);
-        isrootless = 1;
+        daeu_pool_run(
+            numchunks,
+            NULL,
+            daeu_pool_count_workers(numchunks, numthreads),
+            daeu_skin_deform_task,
+            &batch);
     }
-    if(!ismatch)
+    daeu_aligned_free(batch.cols);
+    return 0;
+}
+
+//****************************************************************************
+void daeu_skin_palette(
+    const daeu_skin* skin,
+    const daeu_scene* scene,
+    float* palette_out)
+{
+    // world * inverse bind * bind shape, or only the bind shape for joints
+    // that were not resolved to a node
+    size_t i;
+    for(i = 0; i < skin->numjoints; ++i)
     {
-        // check to see if this is the current item in the path
-        const char* atnames[] = { "sid", "id" };
-        size_t i;
-        for(i = 0; i < sizeof(atnames)/sizeof(*atnames); ++i)
+        float* m = palette_out + i*16;
+        int node = skin->jointnodes[i];
+        if(scene != NULL && node >= 0 && (size_t) node < scene->numnodes)
         {
-            dae_obj_ptr at = daeu_find_attrib(searchroot, atnames[i]);
-            if(at != NULL)
+            daeu_matrix_multiply(
+                scene->world + node*16,
+                skin->invbind + i*16,
+                m);
+            daeu_matrix_multiply(m, skin->bindshape, m);
+        }
+        else
+        {
+            memcpy(m, skin->bindshape, sizeof(skin->bindshape));
+        }
+    }
+}
+
+//****************************************************************************
+static double daeu_get_time()
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return ((double) now.QuadPart) / ((double) freq.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double) now.tv_sec) + ((double) now.tv_nsec)*1e-9;
+#endif
+}
+
+//****************************************************************************
+static size_t daeu_file_size(
+    const char* path)
+{
+    // returns zero if the file does not exist
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attribs;
+    if(GetFileAttributesExA(path, GetFileExInfoStandard, &attribs))
+    {
+        unsigned long long size = attribs.nFileSizeHigh;
+        return (size_t) ((size << 32) | attribs.nFileSizeLow);
+    }
+#else
+    struct stat st;
+    if(stat(path, &st) == 0)
+    {
+        return (size_t) st.st_size;
+    }
+#endif
+    return 0;
+}
+
+//****************************************************************************
+static int daeu_file_map(
+    const char* path,
+    const char** data_out,
+    size_t* size_out)
+{
+    // maps a whole file read only. the view remains valid after the handles
+    // are closed, and an empty file yields an empty string
+    int err = -1;
+#ifdef _WIN32
+    HANDLE file;
+    LARGE_INTEGER size;
+    file = CreateFileA(
+        path,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN,
+        NULL);
+    if(file != INVALID_HANDLE_VALUE)
+    {
+        if(!GetFileSizeEx(file, &size))
+        {
+            size.QuadPart = -1;
+        }
+        if(size.QuadPart == 0)
+        {
+            *data_out = "";
+            *size_out = 0;
+            err = 0;
+        }
+        else if(size.QuadPart > 0)
+        {
+            HANDLE mapping = CreateFileMappingA(
+                file,
+                NULL,
+                PAGE_READONLY,
+                0,
+                0,
+                NULL);
+            if(mapping != NULL)
             {
-                dae_native_typeid attype;
-                void* ataddr;
-                size_t atsize;
-                if(dae_get_data(at, &attype, &ataddr, &atsize) > 0)
+                void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                if(view != NULL)
                 {
-                    // compare the attribute value against the search key
-                    const char* atval = *((char**) ataddr);
-                    if(attype == dae_NATIVE_STRING && atval != NULL)
-                    {
-                        const char* end = strpbrk(ref, sep);
-                        size_t len;
-                        len = (end!=NULL) ? (size_t)(end-ref) : strlen(ref);
-                        ismatch = !memcmp(atval,ref,len) && atval[len]=='\0';
-                        if(ismatch)
-                        {
-                            *obj_out = searchroot;
-                            isrootless = 0;
-                            ref += len;
-                            ++result;
-                            break;
-                        }
-                    }
+                    *data_out = (const char*) view;
+                    *size_out = (size_t) size.QuadPart;
+                    err = 0;
                 }
+                CloseHandle(mapping);
             }
         }
+        CloseHandle(file);
     }
-    if(ismatch || isrootless)
+#else
+    int fd = open(path, O_RDONLY);
+    if(fd >= 0)
     {
-        // if this item was in the path, or the path root has not been found
-        if(*ref == '.')
+        struct stat st;
+        if(fstat(fd, &st) != 0)
         {
-            // referencing a component of the current element
-            dae_native_typeid datatype;
-            float* data;
-            size_t datalen;
-            ++ref;
-            if(dae_get_data(searchroot,&datatype,(void**)&data,&datalen) != 0)
+            st.st_size = -1;
+        }
+        if(st.st_size == 0)
+        {
+            *data_out = "";
+            *size_out = 0;
+            err = 0;
+        }
+        else if(st.st_size > 0)
+        {
+            size_t size = (size_t) st.st_size;
+            void* view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(view != MAP_FAILED)
             {
-                if(datatype == dae_NATIVE_FLOAT && dataindex_out != NULL)
-                {
-                    int i = -1;
-                    switch(*ref)
-                    {
-                    case 'A':
-                        // ANGLE or A (ALPHA)
-                        if(!strcmp(ref, "ANGLE") || ref[1] == '\0'){ i = 3; }
-                        break;
-                    case 'B':
-                        // B (BLUE)
-                        if(ref[1] == '\0') { i = 2; }
-                        break;
-                    case 'G':
-                        // G (GREEN)
-                        if(ref[1] == '\0') { i = 1; }
-                        break;
-                    case 'P':
-                        if(ref[1] == '\0') { i = 2; }
-                        break;
-                    case 'Q':
-                        if(ref[1] == '\0') { i = 3; }
-                        break;
-                    case 'R':
-                        if(ref[1] == '\0') { i = 0; }
-                        break;
-                    case 'S':
-                        if(ref[1] == '\0') { i = 0; }
-                        break;
-                    case 'T':
-                        // NOTE: not handling 'TIME'
-                        if(ref[1] == '\0') { i = 1; }
-                        break;
-                    case 'U':
-                        if(ref[1] == '\0') { i = 0; }
-                        break;
-                    case 'V':
-                        if(ref[1] == '\0') { i = 1; }
-                        break;
-                    case 'W':
-                        if(ref[1] == '\0') { i = 3; }
-                        break;
-                    case 'X':
-                        if(ref[1] == '\0') { i = 0; }
-                        break;
-                    case 'Y':
-                        if(ref[1] == '\0') { i = 1; }
-                        break;
-                    case 'Z':
-                        if(ref[1] == '\0') { i = 2; }
-                        break;
-                    }
-                    if(i >= 0)
-                    {
-                        if(i < (int) datalen)
-                        {
-                            *dataindex_out = i;
-                            ++result;
-                        }
-                    }
-                }
+                *data_out = (const char*) view;
+                *size_out = size;
+                err = 0;
+            }
+        }
+        close(fd);
+    }
+#endif
+    return err;
+}
+
+//****************************************************************************
+static void daeu_file_unmap(
+    const char* data,
+    size_t size)
+{
+    if(size > 0)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+#else
+        munmap((void*) data, size);
+#endif
+    }
+}
+
+//****************************************************************************
+static int daeu_is_big_endian()
+{
+    const unsigned one = 1;
+    return *((const unsigned char*) &one) == 0;
+}
+
+//****************************************************************************
+static void daeu_binary_swap(
+    void* data,
+    size_t count,
+    size_t typesize)
+{
+    // sidecar files are little endian
+    unsigned char* p = (unsigned char*) data;
+    size_t i;
+    for(i = 0; i < count; ++i)
+    {
+        size_t j;
+        for(j = 0; j < typesize/2; ++j)
+        {
+            unsigned char b = p[j];
+            p[j] = p[typesize - 1 - j];
+            p[typesize - 1 - j] = b;
+        }
+        p += typesize;
+    }
+}
+
+//****************************************************************************
+static size_t daeu_binary_get_size(
+    dae_obj_ptr obj,
+    const char* name,
+    int* err)
+{
+    // sizes may exceed the range of an unsigned long on some targets
+    const char* str = daeu_get_string(obj, name);
+    size_t size = 0;
+    if(str == NULL || !isdigit((unsigned char) *str))
+    {
+        *err = -1;
+        return 0;
+    }
+    while(isdigit((unsigned char) *str))
+    {
+        size = size*10 + (size_t) (*str - '0');
+        ++str;
+    }
+    return size;
+}
+
+//****************************************************************************
+static void daeu_binary_set_size(
+    dae_obj_ptr obj,
+    const char* name,
+    size_t size)
+{
+    char buf[32];
+    char* str = buf + sizeof(buf) - 1;
+    *str = '\0';
+    do
+    {
+        *--str = (char) ('0' + size%10);
+        size /= 10;
+    }
+    while(size > 0);
+    dae_add_attrib(obj, name, str);
+}
+
+//****************************************************************************
+static char* daeu_binary_get_path(
+    const char* docpath,
+    const char* file)
+{
+    // relative names are resolved against the directory of the document
+    size_t dirlen = 0;
+    size_t filelen = strlen(file);
+    char* path;
+    size_t i;
+    if(file[0] != '/' && file[0] != '\\' && file[0] != '\0' &&
+        file[1] != ':')
+    {
+        for(i = 0; docpath[i] != '\0'; ++i)
+        {
+            if(docpath[i] == '/' || docpath[i] == '\\')
+            {
+                dirlen = i + 1;
             }
         }
-        else if(*ref == '(')
+    }
+    path = (char*) malloc(dirlen + filelen + 1);
+    memcpy(path, docpath, dirlen);
+    memcpy(path + dirlen, file, filelen + 1);
+    return path;
+}
+
+//****************************************************************************
+static dae_obj_ptr daeu_binary_get_technique(
+    dae_obj_ptr source)
+{
+    dae_obj_ptr itr = dae_get_first_element(source);
+    while(itr != NULL)
+    {
+        if(!strcmp(dae_get_name(itr), "technique"))
         {
-            // referencing a component of the current element by index
-            dae_native_typeid datatype;
-            float* data;
-            size_t datalen;
-            ++ref;
-            if(dae_get_data(searchroot,&datatype,(void**)&data,&datalen) != 0)
+            const char* profile = daeu_get_string(itr, "profile");
+            if(profile != NULL && !strcmp(profile, "libdae"))
             {
-                if(datatype == dae_NATIVE_FLOAT && dataindex_out != NULL)
+                break;
+            }
+        }
+        itr = dae_get_next(itr);
+    }
+    return itr;
+}
+
+//****************************************************************************
+int daeu_binary_load(
+    dae_COLLADA* doc,
+    const char* path)
+{
+    daeu_idmap ids;
+    char* mappedpath = NULL;
+    const char* mapped = NULL;
+    size_t mappedsize = 0;
+    dae_obj_ptr itr = doc;
+    int err = 0;
+    memset(&ids, 0, sizeof(ids));
+    while(itr != NULL)
+    {
+        dae_obj_ptr parent = dae_get_parent(itr);
+        dae_obj_ptr source = (parent != NULL) ? dae_get_parent(parent) : NULL;
+        if(source != NULL &&
+            !strcmp(dae_get_name(itr), "binary_array") &&
+            daeu_binary_get_technique(source) == parent)
+        {
+            const char* file = daeu_get_string(itr, "file");
+            int referr = 0;
+            size_t offset = daeu_binary_get_size(itr, "offset", &referr);
+            size_t count = daeu_binary_get_size(itr, "count", &referr);
+            dae_obj_ptr array;
+            // untyped elements have no data, and strings are refused
+            dae_native_typeid type = dae_NATIVE_STRING;
+            void* data;
+            size_t len;
+            size_t typesize;
+            if(ids.cap == 0)
+            {
+                daeu_idmap_create(doc, &ids);
+            }
+            array = daeu_idmap_find(&ids, daeu_get_string(itr, "source"));
+            if(file == NULL)
+            {
+                // without a file, the last mapped sidecar is not the one
+                referr = -1;
+            }
+            if(referr == 0)
+            {
+                char* filepath = daeu_binary_get_path(path, file);
+                if(mappedpath == NULL || strcmp(mappedpath, filepath))
                 {
-                    int i = 0;
-                    if(sscanf(ref,"%d",&i) == 1)
+                    // arrays usually share one sidecar, so it stays mapped
+                    if(mapped != NULL)
                     {
-                        if(i >= 0)
-                        {
-                            if(i < (int) datalen)
-                            {
-                                *dataindex_out = i;
-                                ++result;
-                            }
-                        }
+                        daeu_file_unmap(mapped, mappedsize);
+                        mapped = NULL;
                     }
+                    free(mappedpath);
+                    mappedpath = filepath;
+                    if(daeu_file_map(filepath, &mapped, &mappedsize) != 0)
+                    {
+                        mapped = NULL;
+                    }
+                }
+                else
+                {
+                    free(filepath);
                 }
             }
-        }
-        else if(*ref == '/' || isrootless)
-        {
-            // traverse children
-            dae_obj_ptr elem = dae_get_first_element(searchroot);
-            while(elem != NULL)
+            if(array == NULL || mapped == NULL || referr != 0)
             {
-                result = daeu_search_sid(elem, ref, obj_out, dataindex_out);
-                if(result != 0)
+                err = -1;
+            }
+            else
+            {
+                dae_get_data(array, &type, &data, &len);
+                typesize = daeu_native_size(type);
+                if(typesize == 0 ||
+                    offset > mappedsize ||
+                    count > (mappedsize - offset)/typesize ||
+                    dae_set_data(array, type, mapped + offset, count) != 0)
                 {
-                    break;
+                    err = -1;
+                }
+                else if(daeu_is_big_endian())
+                {
+                    dae_get_mutable_data(array, &type, &data, &len);
+                    daeu_binary_swap(data, len, typesize);
                 }
-                elem = dae_get_next(elem);
             }
         }
+        itr = daeu_walk_next(doc, itr);
     }
-    return result;
+    if(mapped != NULL)
+    {
+        daeu_file_unmap(mapped, mappedsize);
+    }
+    free(mappedpath);
+    daeu_idmap_destroy(&ids);
+    return err;
 }
 
 //****************************************************************************
-dae_obj_ptr daeu_search_uri(
-    dae_obj_ptr searchroot,
-    const char* uri)
+static dae_obj_ptr daeu_binary_get_array(
+    dae_obj_ptr obj,
+    size_t minvalues,
+    dae_native_typeid* type_out,
+    void** data_out,
+    size_t* datalen_out)
 {
-    const char* key = uri + 1;
-    dae_obj_ptr result = NULL;
-    dae_obj_ptr itr = searchroot;
-    assert(*uri == '#');
-    do
+    // gets the array of a source that should be moved to a sidecar
+    dae_obj_ptr array = NULL;
+    *datalen_out = 0;
+    if(dae_get_typeid(obj) == dae_ID_SOURCE_TYPE)
     {
-        dae_obj_ptr at;
-        dae_obj_ptr next;
-        // attempt to find the id attribute for this object
-        at = daeu_find_attrib(itr, "id");
-        if(at != NULL)
+        dae_source_type* src = (dae_source_type*) obj;
+        array = (src->el_float_array != NULL)
+            ? (dae_obj_ptr) src->el_float_array
+            : (dae_obj_ptr) src->el_int_array;
+    }
+    if(array != NULL && daeu_get_id(array) != NULL)
+    {
+        dae_get_data(array, type_out, data_out, datalen_out);
+    }
+    return (*datalen_out > 0 && *datalen_out >= minvalues) ? array : NULL;
+}
+
+//****************************************************************************
+int daeu_binary_store(
+    dae_COLLADA* doc,
+    const char* path,
+    size_t minvalues)
+{
+    FILE* file = fopen(path, "wb");
+    const char* name = path;
+    size_t offset = 0;
+    dae_obj_ptr itr = doc;
+    int numstored = 0;
+    int err = 0;
+    size_t i;
+    if(file == NULL)
+    {
+        return -1;
+    }
+    // write every payload first, so the document is only changed once the
+    // whole sidecar is on disk
+    while(itr != NULL && err == 0)
+    {
+        dae_native_typeid type;
+        void* data;
+        size_t len;
+        if(daeu_binary_get_array(itr, minvalues, &type, &data, &len) != NULL)
         {
-            // attempt the get the attribute value
-            dae_native_typeid attype;
-            void* ataddr;
-            size_t atsize;
-            if(dae_get_data(at, &attype, &ataddr, &atsize))
+            size_t typesize = daeu_native_size(type);
+            if(daeu_is_big_endian())
             {
-                const char* atval = *((char**) ataddr);
-                if(attype == dae_NATIVE_STRING && atval != NULL)
-                {
-                    // compare the attribute value against the search key
-                    if(!strcmp(atval, key))
-                    {
-                        // found match
-                        result = itr;
-                        break;
-                    }
-                }
+                // the values may be shared with a clone, so swap a copy
+                void* swapped = malloc(len*typesize);
+                memcpy(swapped, data, len*typesize);
+                daeu_binary_swap(swapped, len, typesize);
+                err = (fwrite(swapped, typesize, len, file) == len) ? 0 : -1;
+                free(swapped);
+            }
+            else
+            {
+                err = (fwrite(data, typesize, len, file) == len) ? 0 : -1;
             }
         }
-        // attempt to traverse children
-        next = dae_get_first_element(itr);
-        while(next == NULL)
+        itr = daeu_walk_next(doc, itr);
+    }
+    if(fclose(file) != 0 || err != 0)
+    {
+        // a partial sidecar must not be mistaken for a complete one
+        remove(path);
+        return -1;
+    }
+    for(i = 0; path[i] != '\0'; ++i)
+    {
+        // the document refers to the sidecar by name, next to itself
+        if(path[i] == '/' || path[i] == '\\')
         {
-            // if no children exist, attempt to move to next sibling
-            next = dae_get_next(itr);
-            if(next == NULL)
+            name = path + i + 1;
+        }
+    }
+    itr = doc;
+    while(itr != NULL)
+    {
+        dae_native_typeid type;
+        void* data;
+        size_t len;
+        dae_obj_ptr array = daeu_binary_get_array(
+            itr,
+            minvalues,
+            &type,
+            &data,
+            &len);
+        dae_obj_ptr tech = NULL;
+        dae_obj_ptr ref;
+        if(len > 0)
+        {
+            tech = daeu_binary_get_technique(itr);
+        }
+        if(tech != NULL)
+        {
+            // the values in memory replace those of an earlier sidecar
+            ref = dae_get_first_element(tech);
+            while(ref != NULL)
             {
-                // if a sibling did not exist, attempt to move up to the
-                // parent's sibling.
-                next = dae_get_parent(itr);
-                if(next != searchroot)
+                dae_obj_ptr next = dae_get_next(ref);
+                if(!strcmp(dae_get_name(ref), "binary_array"))
                 {
-                    // only move to the parent's sibling if not at the root
-                    itr = next;
-                    next = dae_get_next(next);
+                    dae_remove(ref);
                 }
+                ref = next;
             }
         }
-        itr = next;
+        if(array != NULL)
+        {
+            const char* id = daeu_get_id(array);
+            char* uri = (char*) malloc(strlen(id) + 2);
+            if(tech == NULL)
+            {
+                tech = dae_add_element(itr, "technique");
+                dae_add_attrib(tech, "profile", "libdae");
+            }
+            ref = dae_add_element(tech, "binary_array");
+            uri[0] = '#';
+            strcpy(uri + 1, id);
+            dae_add_attrib(ref, "source", uri);
+            free(uri);
+            dae_add_attrib(ref, "file", name);
+            daeu_binary_set_size(ref, "offset", offset);
+            daeu_binary_set_size(ref, "count", len);
+            offset += len*daeu_native_size(type);
+            // the values now live in the sidecar only
+            dae_set_data(array, type, NULL, 0);
+            ++numstored;
+        }
+        itr = daeu_walk_next(doc, itr);
+    }
+    return numstored;
+}
+
+#ifdef DAE_INSTRUMENT
+//****************************************************************************
+static void daeu_xml_enter(
+    daeu_xml_parser parser)
+{
+    // the time between callbacks belongs to the xml tokenizer
+    double t = daeu_get_time();
+    if(parser->left > 0.0)
+    {
+        parser->stats.tokenizetime += t - parser->left;
+    }
+    parser->entered = t;
+    ++parser->stats.numcallbacks;
+}
+
+//****************************************************************************
+static void daeu_xml_leave(
+    daeu_xml_parser parser)
+{
+    double t = daeu_get_time();
+    parser->stats.handlertime += t - parser->entered;
+    parser->left = t;
+}
+#endif
+
+//****************************************************************************
+static void daeu_xml_chardata_hex(
+    daeu_xml_parser parser,
+    const char* s,
+    size_t len)
+{
+    // decodes the next piece of a hex payload, so the text is never held
+    unsigned char* bytes = (unsigned char*) parser->chardata.str;
+    size_t off = parser->chardata.len;
+    size_t used = 0;
+    size_t n;
+    if(parser->hex.carry != '\0')
+    {
+        // complete the pair that was split between pieces
+        char pair[2];
+        while(used < len && isspace((unsigned char) s[used]))
+        {
+            ++used;
+        }
+        if(used == len)
+        {
+            return;
+        }
+        pair[0] = parser->hex.carry;
+        pair[1] = s[used];
+        if(dae_decode_hex(pair, 2, bytes + off, NULL) != 1)
+        {
+            parser->hex.error = 1;
+            return;
+        }
+        parser->hex.carry = '\0';
+        ++parser->chardata.len;
+        ++off;
+        ++used;
+    }
+    off += dae_decode_hex(s + used, len - used, bytes + off, &n);
+    parser->chardata.len = off;
+    used += n;
+    if(used < len)
+    {
+        // all that may remain is an unpaired digit and whitespace
+        if(isxdigit((unsigned char) s[used]))
+        {
+            parser->hex.carry = s[used];
+            ++used;
+        }
+        while(used < len && isspace((unsigned char) s[used]))
+        {
+            ++used;
+        }
+        parser->hex.error = used < len;
+    }
+}
+
+//****************************************************************************
+static void daeu_xml_load_task(
+    void* userdata,
+    size_t index,
+    int worker)
+{
+    daeu_xml_batch* batch = (daeu_xml_batch*) userdata;
+    const daeu_xml_driver* driver = batch->driver;
+    daeu_xml_worker* w = batch->workers + worker;
+    daeu_xml_load_result* result = batch->results + index;
+    const char* data;
+    size_t size;
+    double t = daeu_get_time();
+    result->err = -1;
+    if(w->tokenizer == NULL && !w->failed)
+    {
+        w->tokenizer = driver->create(driver->user);
+        w->failed = w->tokenizer == NULL;
+    }
+    if(w->tokenizer != NULL &&
+        daeu_file_map(batch->paths[index], &data, &size) == 0)
+    {
+        dae_COLLADA* doc = (batch->allocator != NULL) ?
+            dae_create_ex(batch->allocator) :
+            dae_create();
+        result->size = size;
+        result->readtime = daeu_get_time() - t;
+        t = daeu_get_time();
+        if(w->parser == NULL)
+        {
+            daeu_xml_create(doc, &w->parser);
+        }
+        else
+        {
+            daeu_xml_reset(w->parser, doc);
+        }
+        result->err = driver->parse(
+            driver->user,
+            w->tokenizer,
+            w->parser,
+            data,
+            size);
+        // the reset clears the counters, so they are kept first
+        daeu_xml_get_stats(w->parser, &result->stats);
+        // the document must not keep any reference to the parser
+        daeu_xml_reset(w->parser, NULL);
+        result->parsetime = daeu_get_time() - t;
+        daeu_file_unmap(data, size);
+        if(result->err == 0)
+        {
+            // arrays kept in sidecar files count as reading
+            t = daeu_get_time();
+            result->err = daeu_binary_load(doc, batch->paths[index]);
+            result->readtime += daeu_get_time() - t;
+        }
+        if(result->err == 0)
+        {
+            result->doc = doc;
+        }
+        else
+        {
+            dae_destroy(doc);
+        }
     }
-    while(itr != searchroot);
-    return result;
 }
 
 //****************************************************************************
@@ -495,16 +7501,46 @@ void daeu_xml_chardata(
     char* chars = parser->chardata.str;
     size_t off = parser->chardata.len;
     size_t cap = parser->chardata.cap;
-    if((off + len + 1) > cap)
+#ifdef DAE_INSTRUMENT
+    daeu_xml_enter(parser);
+#endif
+    // after an invalid hex payload, the rest of it is dropped
+    if(!parser->hex.error)
     {
-        cap = (off + len + 1024) & ~1023;
-        chars = (char*) realloc(chars, cap * sizeof(*chars));
-        parser->chardata.str = chars;
-        parser->chardata.cap = cap;
+        if((off + len + 1) > cap)
+        {
+            const dae_allocator* allocator = parser->allocator;
+            size_t sz;
+            cap = (off + len + 1024) & ~1023;
+            sz = cap * sizeof(*chars);
+            chars = (char*) ((chars != NULL) ?
+                allocator->realloc(allocator->user, chars, sz) :
+                allocator->alloc(allocator->user, sz));
+            parser->chardata.str = chars;
+            parser->chardata.cap = cap;
+        }
+        if(parser->hex.active)
+        {
+#ifdef DAE_INSTRUMENT
+            dae_instrument* instrument = &parser->stats.document;
+            double t = daeu_get_time();
+#endif
+            daeu_xml_chardata_hex(parser, s, (size_t) len);
+#ifdef DAE_INSTRUMENT
+            instrument->converttime += daeu_get_time() - t;
+            instrument->convertbytes[dae_NATIVE_HEX8] += len;
+#endif
+        }
+        else
+        {
+            memcpy(chars + off, s, len);
+            chars[off + len] = '\0';
+            parser->chardata.len += len;
+        }
     }
-    memcpy(chars + off, s, len);
-    chars[off + len] = '\0';
-    parser->chardata.len += len;
+#ifdef DAE_INSTRUMENT
+    daeu_xml_leave(parser);
+#endif
 }
 
 //****************************************************************************
@@ -512,9 +7548,25 @@ void daeu_xml_create(
     dae_COLLADA* root,
     daeu_xml_parser* parser_out)
 {
-    daeu_xml_parser parser = (daeu_xml_parser) malloc(sizeof(*parser));
+    daeu_xml_create_ex(root, dae_get_allocator(root), parser_out);
+}
+
+//****************************************************************************
+void daeu_xml_create_ex(
+    dae_COLLADA* root,
+    const dae_allocator* allocator,
+    daeu_xml_parser* parser_out)
+{
+    daeu_xml_parser parser;
+    parser = (daeu_xml_parser) allocator->alloc(
+        allocator->user,
+        sizeof(*parser));
     memset(parser, 0, sizeof(*parser));
+    parser->allocator = allocator;
     parser->root = root;
+#ifdef DAE_INSTRUMENT
+    dae_set_instrument(root, &parser->stats.document);
+#endif
     *parser_out = parser;
 }
 
@@ -522,8 +7574,18 @@ void daeu_xml_create(
 void daeu_xml_destroy(
     daeu_xml_parser parser)
 {
-    free(parser->chardata.str);
-    free(parser);
+    const dae_allocator* allocator = parser->allocator;
+#ifdef DAE_INSTRUMENT
+    if(parser->root != NULL)
+    {
+        dae_set_instrument(parser->root, NULL);
+    }
+#endif
+    if(parser->chardata.str != NULL)
+    {
+        allocator->free(allocator->user, parser->chardata.str);
+    }
+    allocator->free(allocator->user, parser);
 }
 
 //****************************************************************************
@@ -532,9 +7594,20 @@ void daeu_xml_endelement(
     const char* el)
 {
     daeu_xml_parser parser = (daeu_xml_parser) userdata;
+#ifdef DAE_INSTRUMENT
+    daeu_xml_enter(parser);
+#endif
     if(parser->current != NULL)
     {
-        if(parser->chardata.len > 0)
+        if(parser->hex.active)
+        {
+            const unsigned char* bytes;
+            bytes = (const unsigned char*) parser->chardata.str;
+            dae_set_hex(parser->current, bytes, parser->chardata.len);
+            memset(&parser->hex, 0, sizeof(parser->hex));
+            parser->chardata.len = 0;
+        }
+        else if(parser->chardata.len > 0)
         {
             dae_obj_ptr obj = parser->current;
             if(dae_get_typeid(obj) == dae_ID_IMAGE_TYPE_INIT_FROM)
@@ -548,6 +7621,114 @@ void daeu_xml_endelement(
         }
         parser->current = dae_get_parent(parser->current);
     }
+#ifdef DAE_INSTRUMENT
+    daeu_xml_leave(parser);
+#endif
+}
+
+//****************************************************************************
+int daeu_xml_get_stats(
+    daeu_xml_parser parser,
+    daeu_xml_stats* stats_out)
+{
+#ifdef DAE_INSTRUMENT
+    *stats_out = parser->stats;
+    return 0;
+#else
+    memset(stats_out, 0, sizeof(*stats_out));
+    return -1;
+#endif
+}
+
+//****************************************************************************
+int daeu_xml_load_batch(
+    const char* const* paths,
+    size_t numpaths,
+    const daeu_xml_driver* driver,
+    const dae_allocator* allocator,
+    int numthreads,
+    daeu_xml_load_result* results_out)
+{
+    daeu_xml_batch batch;
+    daeu_mesh_cost* costs;
+    size_t* order;
+    int numworkers = daeu_pool_count_workers(numpaths, numthreads);
+    size_t i;
+    int err = 0;
+    memset(results_out, 0, numpaths*sizeof(*results_out));
+    batch.paths = paths;
+    batch.driver = driver;
+    batch.allocator = allocator;
+    batch.results = results_out;
+    batch.workers = (daeu_xml_worker*) calloc(
+        numworkers,
+        sizeof(*batch.workers));
+    costs = (daeu_mesh_cost*) malloc((numpaths + 1)*sizeof(*costs));
+    order = (size_t*) malloc((numpaths + 1)*sizeof(*order));
+    for(i = 0; i < numpaths; ++i)
+    {
+        costs[i].cost = daeu_file_size(paths[i]);
+        costs[i].index = i;
+    }
+    // dispatch the largest files first so they do not end up in the tail
+    qsort(costs, numpaths, sizeof(*costs), daeu_mesh_cmp_cost);
+    for(i = 0; i < numpaths; ++i)
+    {
+        order[i] = costs[i].index;
+    }
+    if(numpaths > 0)
+    {
+        daeu_pool_run(
+            numpaths,
+            order,
+            numworkers,
+            daeu_xml_load_task,
+            &batch);
+    }
+    for(i = 0; i < (size_t) numworkers; ++i)
+    {
+        daeu_xml_worker* w = batch.workers + i;
+        if(w->parser != NULL)
+        {
+            daeu_xml_destroy(w->parser);
+        }
+        if(w->tokenizer != NULL)
+        {
+            driver->destroy(driver->user, w->tokenizer);
+        }
+    }
+    for(i = 0; i < numpaths; ++i)
+    {
+        err = (results_out[i].err != 0) ? -1 : err;
+    }
+    free(order);
+    free(costs);
+    free(batch.workers);
+    return err;
+}
+
+//****************************************************************************
+void daeu_xml_reset(
+    daeu_xml_parser parser,
+    dae_COLLADA* root)
+{
+#ifdef DAE_INSTRUMENT
+    if(parser->root != NULL)
+    {
+        dae_set_instrument(parser->root, NULL);
+    }
+    memset(&parser->stats, 0, sizeof(parser->stats));
+    parser->entered = 0.0;
+    parser->left = 0.0;
+    if(root != NULL)
+    {
+        dae_set_instrument(root, &parser->stats.document);
+    }
+#endif
+    parser->root = root;
+    parser->current = NULL;
+    parser->chardata.len = 0;
+    memset(&parser->hex, 0, sizeof(parser->hex));
 }
 
 //****************************************************************************
@@ -559,6 +7740,9 @@ void daeu_xml_startelement(
     daeu_xml_parser parser = (daeu_xml_parser) userdata;
     dae_obj_ptr parent = parser->current;
     dae_obj_ptr obj = NULL;
+#ifdef DAE_INSTRUMENT
+    daeu_xml_enter(parser);
+#endif
     if(parent == NULL)
     {
         if(!strcmp(el, "COLLADA"))
@@ -572,16 +7756,25 @@ void daeu_xml_startelement(
     }
     if(obj != NULL)
     {
+        dae_native_typeid datatype = dae_NATIVE_STRING;
+        void* data;
+        size_t datalen;
         while(att[0] != NULL && att[1] != NULL)
         {
             dae_add_attrib(obj, att[0], att[1]);
             att += 2;
         }
         parser->current = obj;
+        dae_get_data(obj, &datatype, &data, &datalen);
+        memset(&parser->hex, 0, sizeof(parser->hex));
+        parser->hex.active = datatype == dae_NATIVE_HEX8;
     }
     else
     {
         assert(0);
     }
     parser->chardata.len = 0;
+#ifdef DAE_INSTRUMENT
+    daeu_xml_leave(parser);
+#endif
 }